@@ -135,6 +135,7 @@ typedef struct StreamMap {
     int disabled;           /* 1 is this mapping is disabled by a negative map */
     int file_index;
     int stream_index;
+    int tile_grid;          /* 1 if stream_index is the index of a tile grid stream group */
     char *linklabel;       /* name of an output link, for mapping lavfi outputs */
 
     ViewSpecifier vs;
@@ -415,6 +416,11 @@ typedef struct DecoderOpts {
     // Either forced (when DECODER_FLAG_FRAMERATE_FORCED is set) or
     // estimated (otherwise) video framerate.
     AVRational                  framerate;
+
+    // When non-NULL, the decoder composes the tiles of this tile grid into
+    // a single picture. Packets must carry the 1-based index of the tile
+    // they belong to in opaque, offset by nb_tiles for each picture.
+    const AVStreamGroup        *tile_grid;
 } DecoderOpts;
 
 typedef struct Decoder {
@@ -883,6 +889,23 @@ int ist_filter_add(InputStream *ist, InputFilter *ifilter, int is_simple,
                    const ViewSpecifier *vs, InputFilterOptions *opts,
                    SchedulerNode *src);
 
+/**
+ * Find the tile grid stream group that a stream specifier selects as a whole.
+ *
+ * @return index of the stream group in f->ctx->stream_groups, or a negative
+ *         value if ss does not select exactly one tile grid
+ */
+int ifile_tile_grid_find(const InputFile *f, const StreamSpecifier *ss);
+
+/**
+ * Decode the tiles of a tile grid stream group with a single decoder, which
+ * composes them into one picture, and connect it to a filtergraph input.
+ *
+ * @param opts filtergraph input options, to be filled by this function
+ */
+int ifile_tile_grid_filter_add(InputFile *f, int group_idx, InputFilter *ifilter,
+                               InputFilterOptions *opts, SchedulerNode *src);
+
 /**
  * Find an unused input stream of given type.
  */
@@ -22,6 +22,7 @@
 #include "libavutil/avstring.h"
 #include "libavutil/dict.h"
 #include "libavutil/error.h"
+#include "libavutil/imgutils.h"
 #include "libavutil/log.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
@@ -102,6 +103,24 @@ typedef struct DecoderPriv {
         AVDictionary       *opts;
         const AVCodec      *codec;
     } standalone_init;
+
+    // composition of a tile grid, see DecoderOpts.tile_grid
+    struct {
+        const AVStreamGroup *stg;
+        // the picture being composed
+        AVFrame            *canvas;
+        int64_t             picture;
+        int                 max_pixsteps[4];
+
+        // per tile: set if the first picture may be decoded in place, the
+        // decoded frame waiting to be copied into the canvas, and whether
+        // it was decoded at all
+        uint8_t            *in_place;
+        AVFrame           **copies;
+        uint8_t            *decoded;
+        int                 nb_decoded;
+        int                 nb_tiles;
+    } tile_grid;
 } DecoderPriv;
 
 static DecoderPriv *dp_from_dec(Decoder *d)
@@ -141,6 +160,15 @@ void dec_free(Decoder **pdec)
     av_freep(&dp->views_requested);
     av_freep(&dp->view_map);
 
+    av_frame_free(&dp->tile_grid.canvas);
+    if (dp->tile_grid.copies) {
+        for (int i = 0; i < dp->tile_grid.nb_tiles; i++)
+            av_frame_free(&dp->tile_grid.copies[i]);
+    }
+    av_freep(&dp->tile_grid.copies);
+    av_freep(&dp->tile_grid.in_place);
+    av_freep(&dp->tile_grid.decoded);
+
     av_freep(pdec);
 }
 
@@ -694,6 +722,425 @@ static int transcode_subtitles(DecoderPriv *dp, const AVPacket *pkt,
     return process_subtitle(dp, frame);
 }
 
+static const AVCodecParameters *tile_par(const DecoderPriv *dp, int tile)
+{
+    const AVStreamGroup *stg = dp->tile_grid.stg;
+
+    return stg->streams[stg->params.tile_grid->offsets[tile].idx]->codecpar;
+}
+
+// pointers to the top left corner of a tile in the canvas
+static void tile_pointers(const DecoderPriv *dp, int tile, uint8_t *data[4])
+{
+    const AVStreamGroupTileGrid *tg = dp->tile_grid.stg->params.tile_grid;
+    const AVFrame *canvas = dp->tile_grid.canvas;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(canvas->format);
+    int x = tg->offsets[tile].horizontal;
+    int y = tg->offsets[tile].vertical;
+
+    for (int i = 0; i < 4; i++) {
+        int is_chroma = i == 1 || i == 2;
+        int sx = is_chroma ? desc->log2_chroma_w : 0;
+        int sy = is_chroma ? desc->log2_chroma_h : 0;
+
+        data[i] = canvas->data[i] ? canvas->data[i] + (y >> sy) * canvas->linesize[i] +
+                                    (x >> sx) * dp->tile_grid.max_pixsteps[i] : NULL;
+    }
+}
+
+static int tiles_overlap(const DecoderPriv *dp, int i, int j)
+{
+    const AVStreamGroupTileGrid *tg = dp->tile_grid.stg->params.tile_grid;
+    const AVCodecParameters *par1 = tile_par(dp, i);
+    const AVCodecParameters *par2 = tile_par(dp, j);
+    int x1 = tg->offsets[i].horizontal, y1 = tg->offsets[i].vertical;
+    int x2 = tg->offsets[j].horizontal, y2 = tg->offsets[j].vertical;
+
+    return x1 < x2 + par2->width  && x2 < x1 + par1->width &&
+           y1 < y2 + par2->height && y2 < y1 + par1->height;
+}
+
+// fill a w x h area of the canvas with the background color of the grid
+static int tile_grid_fill(DecoderPriv *dp, uint8_t *data[4], int w, int h)
+{
+    const AVFrame *canvas = dp->tile_grid.canvas;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(canvas->format);
+    const uint8_t *rgba = dp->tile_grid.stg->params.tile_grid->background;
+    int shift = desc->comp[0].depth - 8;
+    ptrdiff_t linesize[4];
+    uint32_t color[4];
+
+    if (desc->flags & AV_PIX_FMT_FLAG_RGB) {
+        color[0] = rgba[0];
+        color[1] = rgba[1];
+        color[2] = rgba[2];
+    } else {
+        // BT.601 limited range
+        color[0] = (( 66 * rgba[0] + 129 * rgba[1] +  25 * rgba[2] + 128) >> 8) +  16;
+        color[1] = ((-38 * rgba[0] -  74 * rgba[1] + 112 * rgba[2] + 128) >> 8) + 128;
+        color[2] = ((112 * rgba[0] -  94 * rgba[1] -  18 * rgba[2] + 128) >> 8) + 128;
+    }
+    color[3] = rgba[3];
+
+    for (int i = 0; i < 4; i++) {
+        color[i]    = shift >= 0 ? color[i] << shift : color[i] >> -shift;
+        linesize[i] = canvas->linesize[i];
+    }
+
+    return av_image_fill_color(data, linesize, canvas->format, color, w, h, 0);
+}
+
+static int tile_grid_alloc_canvas(DecoderPriv *dp, enum AVPixelFormat format)
+{
+    const AVStreamGroupTileGrid *tg = dp->tile_grid.stg->params.tile_grid;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+    AVFrame *canvas = dp->tile_grid.canvas;
+    int linesize_align[AV_NUM_DATA_POINTERS];
+    int w = tg->coded_width, h = tg->coded_height;
+    int64_t area = 0;
+    int ret;
+
+    if (!desc || desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL |
+                                AV_PIX_FMT_FLAG_BITSTREAM)) {
+        av_log(dp, AV_LOG_ERROR, "Unsupported tile pixel format: %s\n",
+               desc ? desc->name : "none");
+        return AVERROR_PATCHWELCOME;
+    }
+
+    // Decoders may access the canvas up to the aligned dimensions of a tile,
+    // which for H.264 include two lines past the padded height. Allocate
+    // enough for every tile, the dimensions are restored below.
+    avcodec_align_dimensions2(dp->dec_ctx, &w, &h, linesize_align);
+    for (int i = 0; i < tg->nb_tiles; i++) {
+        const AVCodecParameters *par = tile_par(dp, i);
+        int tile_w = par->width, tile_h = par->height, tile_align[AV_NUM_DATA_POINTERS];
+
+        avcodec_align_dimensions2(dp->dec_ctx, &tile_w, &tile_h, tile_align);
+        w = FFMAX(w, tg->offsets[i].horizontal + tile_w);
+        h = FFMAX(h, tg->offsets[i].vertical   + tile_h);
+    }
+
+    canvas->format = format;
+    canvas->width  = w;
+    canvas->height = h;
+    ret = av_frame_get_buffer(canvas, linesize_align[0]);
+    if (ret < 0)
+        return ret;
+    canvas->width  = tg->coded_width;
+    canvas->height = tg->coded_height;
+
+    av_image_fill_max_pixsteps(dp->tile_grid.max_pixsteps, NULL, desc);
+
+    // fill the parts not covered by any tile, which grids usually have none of
+    for (int i = 0; i < tg->nb_tiles; i++) {
+        const AVCodecParameters *par = tile_par(dp, i);
+        int x = tg->offsets[i].horizontal, y = tg->offsets[i].vertical;
+
+        for (int j = 0; j < i; j++) {
+            if (tiles_overlap(dp, i, j))
+                area = INT64_MIN;
+        }
+        area += (int64_t)FFMAX(FFMIN(x + par->width,  canvas->width)  - FFMAX(x, 0), 0) *
+                         FFMAX(FFMIN(y + par->height, canvas->height) - FFMAX(y, 0), 0);
+    }
+    if (area != (int64_t)canvas->width * canvas->height)
+        return tile_grid_fill(dp, canvas->data, canvas->width, canvas->height);
+
+    return 0;
+}
+
+/**
+ * Check which tiles of the first picture may be decoded straight into the
+ * canvas: the tile must fit in the canvas without overlapping other tiles,
+ * and its planes must start at the alignment the decoder requires. Reads past
+ * the tile stay within the padding of the canvas, writes are limited to the
+ * size the decoder requests from get_buffer(), which is checked there.
+ */
+static void tile_grid_check_in_place(DecoderPriv *dp)
+{
+    const AVStreamGroupTileGrid *tg = dp->tile_grid.stg->params.tile_grid;
+    const AVFrame *canvas = dp->tile_grid.canvas;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(canvas->format);
+    int linesize_align[AV_NUM_DATA_POINTERS];
+    int w = canvas->width, h = canvas->height;
+
+    if (!(dp->dec_ctx->codec->capabilities & AV_CODEC_CAP_DR1))
+        return;
+
+    avcodec_align_dimensions2(dp->dec_ctx, &w, &h, linesize_align);
+
+    for (int i = 0; i < tg->nb_tiles; i++) {
+        const AVCodecParameters *par = tile_par(dp, i);
+        int x = tg->offsets[i].horizontal, y = tg->offsets[i].vertical;
+        uint8_t *data[4];
+        int in_place = 1;
+
+        if (par->format != canvas->format ||
+            x < 0 || y < 0 ||
+            x + par->width > canvas->width || y + par->height > canvas->height)
+            continue;
+        if ((x | par->width)  & ((1 << desc->log2_chroma_w) - 1) ||
+            (y | par->height) & ((1 << desc->log2_chroma_h) - 1))
+            continue;
+
+        tile_pointers(dp, i, data);
+        for (int p = 0; p < 4 && data[p]; p++) {
+            if ((uintptr_t)data[p] % linesize_align[p] ||
+                canvas->linesize[p] % linesize_align[p])
+                in_place = 0;
+        }
+
+        // with overlapping tiles the one with the higher index must win,
+        // which decoding in parallel cannot guarantee
+        for (int j = 0; j < tg->nb_tiles && in_place; j++) {
+            if (j != i && tiles_overlap(dp, i, j))
+                in_place = 0;
+        }
+
+        dp->tile_grid.in_place[i] = in_place;
+    }
+}
+
+static int tile_grid_init(DecoderPriv *dp, const AVStreamGroup *stg)
+{
+    const AVStreamGroupTileGrid *tg = stg->params.tile_grid;
+    enum AVPixelFormat format;
+    int ret;
+
+    dp->tile_grid.stg      = stg;
+    dp->tile_grid.nb_tiles = tg->nb_tiles;
+
+    dp->tile_grid.canvas   = av_frame_alloc();
+    dp->tile_grid.in_place = av_calloc(tg->nb_tiles, sizeof(*dp->tile_grid.in_place));
+    dp->tile_grid.copies   = av_calloc(tg->nb_tiles, sizeof(*dp->tile_grid.copies));
+    dp->tile_grid.decoded  = av_calloc(tg->nb_tiles, sizeof(*dp->tile_grid.decoded));
+    if (!dp->tile_grid.canvas || !dp->tile_grid.in_place ||
+        !dp->tile_grid.copies || !dp->tile_grid.decoded)
+        return AVERROR(ENOMEM);
+
+    // The canvas of the first picture is allocated now if the tile format is
+    // known, so that its tiles can be decoded in place. Later pictures and
+    // pictures of unknown format are allocated on demand and copied into.
+    format = tile_par(dp, 0)->format;
+    if (format == AV_PIX_FMT_NONE)
+        return 0;
+
+    ret = tile_grid_alloc_canvas(dp, format);
+    if (ret < 0)
+        return ret;
+
+    tile_grid_check_in_place(dp);
+
+    return 0;
+}
+
+static int tile_grid_get_buffer(DecoderPriv *dp, AVCodecContext *dec_ctx,
+                                AVFrame *frame, int flags)
+{
+    // the packet opaque value, out of range for all but the first picture
+    intptr_t tile = (intptr_t)frame->opaque - 1;
+    const AVFrame *canvas = dp->tile_grid.canvas;
+    const AVCodecParameters *par;
+    uint8_t *data[4];
+
+    if (tile < 0 || tile >= dp->tile_grid.nb_tiles || !dp->tile_grid.in_place[tile])
+        return avcodec_default_get_buffer2(dec_ctx, frame, flags);
+
+    // the decoder writes up to the dimensions requested here
+    par = tile_par(dp, tile);
+    if (frame->format != canvas->format ||
+        frame->width  != par->width || frame->height != par->height)
+        return avcodec_default_get_buffer2(dec_ctx, frame, flags);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(canvas->buf) && canvas->buf[i]; i++) {
+        frame->buf[i] = av_buffer_ref(canvas->buf[i]);
+        if (!frame->buf[i]) {
+            for (int j = 0; j < i; j++)
+                av_buffer_unref(&frame->buf[j]);
+            return AVERROR(ENOMEM);
+        }
+    }
+
+    tile_pointers(dp, tile, data);
+    for (int i = 0; i < 4; i++) {
+        frame->data[i]     = data[i];
+        frame->linesize[i] = canvas->linesize[i];
+    }
+    frame->extended_data = frame->data;
+
+    return 0;
+}
+
+static int tile_grid_copy(DecoderPriv *dp, int tile, AVFrame *frame)
+{
+    const AVStreamGroupTileGrid *tg = dp->tile_grid.stg->params.tile_grid;
+    const AVFrame *canvas = dp->tile_grid.canvas;
+    int x = tg->offsets[tile].horizontal;
+    int y = tg->offsets[tile].vertical;
+    uint8_t *data[4];
+    int ret;
+
+    ret = av_frame_apply_cropping(frame, AV_FRAME_CROP_UNALIGNED);
+    if (ret < 0)
+        return ret;
+
+    if (x < 0 || y < 0 || x >= canvas->width || y >= canvas->height ||
+        frame->format != canvas->format) {
+        av_log(dp, AV_LOG_WARNING, "Cannot place tile %d: unsupported "
+               "offset or pixel format\n", tile);
+        return 0;
+    }
+
+    tile_pointers(dp, tile, data);
+    av_image_copy2(data, canvas->linesize, frame->data, frame->linesize,
+                   frame->format, FFMIN(frame->width,  canvas->width  - x),
+                   FFMIN(frame->height, canvas->height - y));
+
+    return 0;
+}
+
+// finish the picture being composed and move it to frame
+static int tile_grid_output(DecoderPriv *dp, AVFrame *frame)
+{
+    const AVStreamGroupTileGrid *tg = dp->tile_grid.stg->params.tile_grid;
+    AVFrame *canvas = dp->tile_grid.canvas;
+    int ret = 0;
+
+    if (dp->tile_grid.nb_decoded < tg->nb_tiles)
+        av_log(dp, AV_LOG_WARNING, "%d of %d tiles missing from picture %"PRId64"\n",
+               tg->nb_tiles - dp->tile_grid.nb_decoded, tg->nb_tiles,
+               dp->tile_grid.picture);
+
+    // Tiles that were not decoded in place are copied in index order, so
+    // that overlapping tiles are layered as specified.
+    for (int i = 0; i < tg->nb_tiles; i++) {
+        if (dp->tile_grid.copies[i]) {
+            if (ret >= 0)
+                ret = tile_grid_copy(dp, i, dp->tile_grid.copies[i]);
+            av_frame_free(&dp->tile_grid.copies[i]);
+        } else if (!dp->tile_grid.decoded[i] && ret >= 0) {
+            const AVCodecParameters *par = tile_par(dp, i);
+            int x = tg->offsets[i].horizontal, y = tg->offsets[i].vertical;
+            uint8_t *data[4];
+
+            if (x >= 0 && y >= 0 && x < canvas->width && y < canvas->height) {
+                tile_pointers(dp, i, data);
+                ret = tile_grid_fill(dp, data, FFMIN(par->width,  canvas->width  - x),
+                                               FFMIN(par->height, canvas->height - y));
+            }
+        }
+        dp->tile_grid.decoded[i] = 0;
+    }
+    dp->tile_grid.nb_decoded = 0;
+    dp->tile_grid.picture++;
+    if (ret < 0) {
+        av_frame_unref(canvas);
+        return ret;
+    }
+
+    // the properties were taken from a tile
+    canvas->opaque      = NULL;
+    canvas->crop_left   = tg->horizontal_offset;
+    canvas->crop_top    = tg->vertical_offset;
+    canvas->crop_right  = tg->coded_width  - tg->width  - tg->horizontal_offset;
+    canvas->crop_bottom = tg->coded_height - tg->height - tg->vertical_offset;
+
+    ret = av_frame_apply_cropping(canvas, AV_FRAME_CROP_UNALIGNED);
+    if (ret < 0) {
+        av_frame_unref(canvas);
+        return ret;
+    }
+
+    av_frame_move_ref(frame, canvas);
+
+    return 1;
+}
+
+/**
+ * Place a decoded tile, given in frame, into the picture being composed.
+ *
+ * @param flush output the picture being composed even if tiles are missing,
+ *              frame is then empty on input
+ *
+ * @return 1 when frame was replaced by a complete picture, 0 when more tiles
+ *         are needed, a negative error code on failure
+ */
+static int tile_grid_process(DecoderPriv *dp, AVFrame *frame, int flush)
+{
+    const int nb_tiles = dp->tile_grid.nb_tiles;
+    intptr_t tag = (intptr_t)frame->opaque - 1;
+    int64_t picture;
+    uint8_t *data[4];
+    int tile, ret;
+
+    if (flush)
+        return tile_grid_output(dp, frame);
+
+    if (tag < 0) {
+        av_frame_unref(frame);
+        return 0;
+    }
+    picture = tag / nb_tiles;
+    tile    = tag % nb_tiles;
+
+    if (picture < dp->tile_grid.picture ||
+        (picture == dp->tile_grid.picture && dp->tile_grid.decoded[tile])) {
+        av_log(dp, AV_LOG_WARNING, "Dropping late tile %d of picture %"PRId64"\n",
+               tile, picture);
+        av_frame_unref(frame);
+        return 0;
+    }
+
+    // output what was decoded of the previous picture first
+    if (picture > dp->tile_grid.picture && dp->tile_grid.nb_decoded) {
+        AVFrame *next = av_frame_alloc();
+        if (!next)
+            return AVERROR(ENOMEM);
+        av_frame_move_ref(next, frame);
+
+        ret = tile_grid_output(dp, frame);
+        if (ret >= 0) {
+            // at least two tiles are needed to leave a picture incomplete
+            ret = tile_grid_process(dp, next, 0);
+            av_assert0(ret <= 0);
+        }
+        av_frame_free(&next);
+
+        return ret < 0 ? ret : 1;
+    }
+    dp->tile_grid.picture = picture;
+
+    if (!dp->tile_grid.canvas->buf[0]) {
+        ret = tile_grid_alloc_canvas(dp, frame->format);
+        if (ret < 0)
+            return ret;
+    }
+    if (!dp->tile_grid.nb_decoded) {
+        ret = av_frame_copy_props(dp->tile_grid.canvas, frame);
+        if (ret < 0)
+            return ret;
+    }
+
+    dp->tile_grid.decoded[tile] = 1;
+    dp->tile_grid.nb_decoded++;
+
+    // nothing to do if the tile was decoded in place
+    tile_pointers(dp, tile, data);
+    if (frame->data[0] == data[0]) {
+        av_frame_unref(frame);
+    } else {
+        dp->tile_grid.copies[tile] = av_frame_alloc();
+        if (!dp->tile_grid.copies[tile])
+            return AVERROR(ENOMEM);
+        av_frame_move_ref(dp->tile_grid.copies[tile], frame);
+    }
+
+    if (dp->tile_grid.nb_decoded < nb_tiles)
+        return 0;
+
+    return tile_grid_output(dp, frame);
+}
+
 static int packet_decode(DecoderPriv *dp, AVPacket *pkt, AVFrame *frame)
 {
     AVCodecContext *dec = dp->dec_ctx;
@@ -745,6 +1192,7 @@ static int packet_decode(DecoderPriv *dp, AVPacket *pkt, AVFrame *frame)
     while (1) {
         FrameData *fd;
         unsigned outputs_mask = 1;
+        int flush_tile_grid = 0;
 
         av_frame_unref(frame);
 
@@ -756,7 +1204,10 @@ static int packet_decode(DecoderPriv *dp, AVPacket *pkt, AVFrame *frame)
             av_assert0(pkt); // should never happen during flushing
             return 0;
         } else if (ret == AVERROR_EOF) {
-            return ret;
+            // output the last tile grid picture even if tiles are missing
+            if (!dp->tile_grid.stg || !dp->tile_grid.nb_decoded)
+                return ret;
+            flush_tile_grid = 1;
         } else if (ret < 0) {
             av_log(dp, AV_LOG_ERROR, "Decoding error: %s\n", av_err2str(ret));
             dp->dec.decode_errors++;
@@ -774,6 +1225,17 @@ static int packet_decode(DecoderPriv *dp, AVPacket *pkt, AVFrame *frame)
                 return AVERROR_INVALIDDATA;
         }
 
+        if (dp->tile_grid.stg) {
+            ret = tile_grid_process(dp, frame, flush_tile_grid);
+            if (ret < 0) {
+                av_log(dp, AV_LOG_ERROR, "Error composing the tile grid: %s\n",
+                       av_err2str(ret));
+                return ret;
+            }
+            if (!ret)
+                continue;
+        }
+
         fd      = frame_data(frame);
         if (!fd) {
             av_frame_unref(frame);
@@ -826,6 +1288,9 @@ static int packet_decode(DecoderPriv *dp, AVPacket *pkt, AVFrame *frame)
                 return ret == AVERROR_EOF ? AVERROR_EXIT : ret;
             }
         }
+
+        if (flush_tile_grid)
+            return AVERROR_EOF;
     }
 }
 
@@ -1358,6 +1823,9 @@ static int get_buffer(AVCodecContext *dec_ctx, AVFrame *frame, int flags)
 {
     DecoderPriv *dp = dec_ctx->opaque;
 
+    if (dp->tile_grid.stg)
+        return tile_grid_get_buffer(dp, dec_ctx, frame, flags);
+
     // for multiview video, store the output mask in frame opaque
     if (dp->nb_view_map) {
         const AVFrameSideData *sd = av_frame_get_side_data(frame, AV_FRAME_DATA_VIEW_ID);
@@ -1605,6 +2073,15 @@ static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
         return ret;
     }
 
+    if (o->tile_grid) {
+        ret = tile_grid_init(dp, o->tile_grid);
+        if (ret < 0) {
+            av_log(dp, AV_LOG_ERROR, "Error setting up tile grid composition: %s\n",
+                   av_err2str(ret));
+            return ret;
+        }
+    }
+
     if (dp->dec_ctx->hw_device_ctx) {
         // Update decoder extra_hw_frames option to account for the
         // frames held in queues inside the ffmpeg utility.  This is
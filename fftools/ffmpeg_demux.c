@@ -40,6 +40,23 @@
 
 #include "libavformat/avformat.h"
 
+// a tile grid stream group, decoded into a single picture per group of tiles
+typedef struct DemuxTileGrid {
+    const AVStreamGroup     *stg;
+
+    int                      sch_idx_stream;
+    int                      sch_idx_dec;
+
+    Decoder                 *decoder;
+    AVDictionary            *decoder_opts;
+    DecoderOpts              dec_opts;
+    char                     dec_name[16];
+    AVFrame                 *decoded_params;
+
+    // scheduler returned EOF for the grid
+    int                      finished;
+} DemuxTileGrid;
+
 typedef struct DemuxStream {
     InputStream              ist;
 
@@ -90,6 +107,9 @@ typedef struct DemuxStream {
 
     AVBSFContext            *bsf;
 
+    // tile grid this stream is a tile of, if it is decoded as part of one
+    DemuxTileGrid           *tile_grid;
+
     /* number of packets successfully read for this stream */
     uint64_t                 nb_packets;
     // combined size of all the packets read
@@ -132,6 +152,10 @@ typedef struct Demuxer {
 
     AVPacket             *pkt_heartbeat;
 
+    // indexed by stream group, allocated on first use
+    DemuxTileGrid       **tile_grids;
+    AVPacket             *pkt_tile;
+
     int                   read_started;
     int                   nb_streams_used;
     int                   nb_streams_finished;
@@ -537,6 +561,55 @@ static int do_send(Demuxer *d, DemuxStream *ds, AVPacket *pkt, unsigned flags,
     return 0;
 }
 
+static int tile_grid_send(Demuxer *d, DemuxStream *ds, const AVPacket *pkt)
+{
+    DemuxTileGrid                  *tg = ds->tile_grid;
+    const AVStreamGroupTileGrid *grid = tg->stg->params.tile_grid;
+    // every tile stream carries one packet per picture
+    int64_t picture = ds->nb_packets - 1;
+    int ret;
+
+    if (tg->finished)
+        return 0;
+
+    // the same stream may be used for several tiles
+    for (int i = 0; i < grid->nb_tiles; i++) {
+        if (tg->stg->streams[grid->offsets[i].idx] != ds->ist.st)
+            continue;
+
+        ret = av_packet_ref(d->pkt_tile, pkt);
+        if (ret < 0)
+            return ret;
+
+        d->pkt_tile->opaque       = (void*)(intptr_t)(picture * grid->nb_tiles + i + 1);
+        d->pkt_tile->stream_index = tg->sch_idx_stream;
+
+        ret = sch_demux_send(d->sch, d->f.index, d->pkt_tile, 0);
+        if (ret == AVERROR_EOF) {
+            av_packet_unref(d->pkt_tile);
+
+            av_log(d, AV_LOG_VERBOSE, "All consumers of tile grid %d are done\n",
+                   tg->stg->index);
+            tg->finished = 1;
+
+            if (++d->nb_streams_finished == d->nb_streams_used) {
+                av_log(d, AV_LOG_VERBOSE, "All consumers are done\n");
+                return AVERROR_EOF;
+            }
+            break;
+        } else if (ret < 0) {
+            av_packet_unref(d->pkt_tile);
+            if (ret != AVERROR_EXIT)
+                av_log(d, AV_LOG_ERROR,
+                       "Unable to send tile packet to consumers: %s\n",
+                       av_err2str(ret));
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
 static int demux_send(Demuxer *d, DemuxThreadContext *dt, DemuxStream *ds,
                       AVPacket *pkt, unsigned flags)
 {
@@ -546,6 +619,20 @@ static int demux_send(Demuxer *d, DemuxThreadContext *dt, DemuxStream *ds,
     // pkt can be NULL only when flushing BSFs
     av_assert0(ds->bsf || pkt);
 
+    if (ds->tile_grid && pkt) {
+        ret = tile_grid_send(d, ds, pkt);
+        if (ret < 0) {
+            av_packet_unref(pkt);
+            return ret;
+        }
+    }
+
+    // the stream is only read for a tile grid, or its own consumers are done
+    if (pkt && (ds->sch_idx_stream < 0 || ds->finished)) {
+        av_packet_unref(pkt);
+        return 0;
+    }
+
     // send heartbeat for sub2video streams
     if (d->pkt_heartbeat && pkt && pkt->pts != AV_NOPTS_VALUE) {
         for (int i = 0; i < f->nb_streams; i++) {
@@ -748,7 +835,9 @@ static int input_thread(void *arg)
            dynamically in stream : we ignore them */
         ds = dt.pkt_demux->stream_index < f->nb_streams ?
              ds_from_ist(f->streams[dt.pkt_demux->stream_index]) : NULL;
-        if (!ds || ds->discard || ds->finished) {
+        if (!ds || ds->discard ||
+            ((ds->finished || ds->sch_idx_stream < 0) &&
+             (!ds->tile_grid || ds->tile_grid->finished))) {
             report_new_stream(d, dt.pkt_demux);
             av_packet_unref(dt.pkt_demux);
             continue;
@@ -852,6 +941,20 @@ static void ist_free(InputStream **pist)
     av_freep(pist);
 }
 
+static void tile_grid_free(DemuxTileGrid **ptg)
+{
+    DemuxTileGrid *tg = *ptg;
+
+    if (!tg)
+        return;
+
+    dec_free(&tg->decoder);
+    av_dict_free(&tg->decoder_opts);
+    av_frame_free(&tg->decoded_params);
+
+    av_freep(ptg);
+}
+
 void ifile_close(InputFile **pf)
 {
     InputFile *f = *pf;
@@ -867,9 +970,14 @@ void ifile_close(InputFile **pf)
         ist_free(&f->streams[i]);
     av_freep(&f->streams);
 
+    for (int i = 0; d->tile_grids && i < f->ctx->nb_stream_groups; i++)
+        tile_grid_free(&d->tile_grids[i]);
+    av_freep(&d->tile_grids);
+
     avformat_close_input(&f->ctx);
 
     av_packet_free(&d->pkt_heartbeat);
+    av_packet_free(&d->pkt_tile);
 
     av_freep(pf);
 }
@@ -899,13 +1007,10 @@ static int ist_use(InputStream *ist, int decoding_needed,
         if (ret < 0)
             return ret;
         ds->sch_idx_stream = ret;
-    }
-
-    if (ds->discard) {
-        ds->discard = 0;
         d->nb_streams_used++;
     }
 
+    ds->discard           = 0;
     ist->st->discard      = ist->user_set_discard;
     ds->decoding_needed   |= decoding_needed;
     ds->streamcopy_needed |= !decoding_needed;
@@ -994,13 +1099,26 @@ int ist_output_add(InputStream *ist, OutputStream *ost)
     return ost->enc ? ds->sch_idx_dec : ds->sch_idx_stream;
 }
 
+static void ifilter_opts_trim(const Demuxer *d, InputFilterOptions *opts)
+{
+    int64_t tsoffset = 0;
+
+    if (copy_ts) {
+        tsoffset = d->f.start_time == AV_NOPTS_VALUE ? 0 : d->f.start_time;
+        if (!start_at_zero && d->f.ctx->start_time != AV_NOPTS_VALUE)
+            tsoffset += d->f.ctx->start_time;
+    }
+    opts->trim_start_us = ((d->f.start_time == AV_NOPTS_VALUE) || !d->accurate_seek) ?
+                          AV_NOPTS_VALUE : tsoffset;
+    opts->trim_end_us   = d->recording_time;
+}
+
 int ist_filter_add(InputStream *ist, InputFilter *ifilter, int is_simple,
                    const ViewSpecifier *vs, InputFilterOptions *opts,
                    SchedulerNode *src)
 {
     Demuxer      *d = demuxer_from_ifile(ist->file);
     DemuxStream *ds = ds_from_ist(ist);
-    int64_t tsoffset = 0;
     int ret;
 
     ret = ist_use(ist, is_simple ? DECODING_FOR_OST : DECODING_FOR_FILTER,
@@ -1072,14 +1190,7 @@ int ist_filter_add(InputStream *ist, InputFilter *ifilter, int is_simple,
     if (ret < 0)
         return ret;
 
-    if (copy_ts) {
-        tsoffset = d->f.start_time == AV_NOPTS_VALUE ? 0 : d->f.start_time;
-        if (!start_at_zero && d->f.ctx->start_time != AV_NOPTS_VALUE)
-            tsoffset += d->f.ctx->start_time;
-    }
-    opts->trim_start_us = ((d->f.start_time == AV_NOPTS_VALUE) || !d->accurate_seek) ?
-                          AV_NOPTS_VALUE : tsoffset;
-    opts->trim_end_us   = d->recording_time;
+    ifilter_opts_trim(d, opts);
 
     opts->name = av_strdup(ds->dec_name);
     if (!opts->name)
@@ -1091,6 +1202,195 @@ int ist_filter_add(InputStream *ist, InputFilter *ifilter, int is_simple,
     return 0;
 }
 
+int ifile_tile_grid_find(const InputFile *f, const StreamSpecifier *ss)
+{
+    const AVFormatContext *s = f->ctx;
+    const AVStreamGroup *stg = NULL;
+
+    // a specifier selecting anything narrower than the whole group refers to
+    // the streams in it
+    if ((ss->stream_list != STREAM_LIST_GROUP_IDX &&
+         ss->stream_list != STREAM_LIST_GROUP_ID) ||
+        ss->idx >= 0 || ss->usable_only || ss->disposition || ss->meta_key ||
+        (ss->media_type != AVMEDIA_TYPE_UNKNOWN &&
+         ss->media_type != AVMEDIA_TYPE_VIDEO))
+        return -1;
+
+    if (ss->stream_list == STREAM_LIST_GROUP_IDX) {
+        if (ss->list_id >= 0 && ss->list_id < s->nb_stream_groups)
+            stg = s->stream_groups[ss->list_id];
+    } else {
+        for (unsigned i = 0; i < s->nb_stream_groups; i++)
+            if (s->stream_groups[i]->id == ss->list_id) {
+                stg = s->stream_groups[i];
+                break;
+            }
+    }
+
+    return stg && stg->type == AV_STREAM_GROUP_PARAMS_TILE_GRID ? stg->index : -1;
+}
+
+static int tile_grid_open(Demuxer *d, int group_idx, DemuxTileGrid **ptg)
+{
+    InputFile                      *f = &d->f;
+    const AVStreamGroup          *stg = f->ctx->stream_groups[group_idx];
+    const AVStreamGroupTileGrid *grid = stg->params.tile_grid;
+    InputStream *ist0;
+    DemuxStream  *ds0;
+    DemuxTileGrid *tg;
+    int ret;
+
+    if (!d->tile_grids) {
+        d->tile_grids = av_calloc(f->ctx->nb_stream_groups, sizeof(*d->tile_grids));
+        if (!d->tile_grids)
+            return AVERROR(ENOMEM);
+    }
+    if (d->tile_grids[group_idx]) {
+        *ptg = d->tile_grids[group_idx];
+        return 0;
+    }
+
+    if (!grid->nb_tiles) {
+        av_log(d, AV_LOG_ERROR, "Tile grid %d has no tiles\n", group_idx);
+        return AVERROR_INVALIDDATA;
+    }
+
+    ist0 = f->streams[stg->streams[grid->offsets[0].idx]->index];
+    ds0  = ds_from_ist(ist0);
+
+    // all the tiles are fed to a single decoder
+    for (unsigned i = 0; i < stg->nb_streams; i++) {
+        InputStream        *ist = f->streams[stg->streams[i]->index];
+        const AVCodecParameters *par = ist->par;
+
+        if (ist->user_set_discard == AVDISCARD_ALL) {
+            av_log(ist, AV_LOG_ERROR, "Cannot decode a disabled input stream\n");
+            return AVERROR(EINVAL);
+        }
+        if (ds_from_ist(ist)->tile_grid) {
+            av_log(ist, AV_LOG_ERROR, "Decoding a stream as a tile of more than "
+                   "one tile grid is not supported\n");
+            return AVERROR_PATCHWELCOME;
+        }
+        if (par->codec_type != AVMEDIA_TYPE_VIDEO ||
+            par->codec_id   != ist0->par->codec_id ||
+            par->extradata_size != ist0->par->extradata_size ||
+            (par->extradata_size &&
+             memcmp(par->extradata, ist0->par->extradata, par->extradata_size))) {
+            av_log(d, AV_LOG_ERROR, "Tile grid %d has tiles with different "
+                   "decoder configurations, which is not supported\n", group_idx);
+            return AVERROR_PATCHWELCOME;
+        }
+    }
+
+    if (!ist0->dec) {
+        av_log(ist0, AV_LOG_ERROR,
+               "Decoding requested, but no decoder found for: %s\n",
+                avcodec_get_name(ist0->par->codec_id));
+        return AVERROR(EINVAL);
+    }
+
+    tg = av_mallocz(sizeof(*tg));
+    if (!tg)
+        return AVERROR(ENOMEM);
+    d->tile_grids[group_idx] = tg;
+
+    tg->stg = stg;
+
+    ret = sch_add_demux_stream(d->sch, f->index);
+    if (ret < 0)
+        return ret;
+    tg->sch_idx_stream = ret;
+    d->nb_streams_used++;
+
+    snprintf(tg->dec_name, sizeof(tg->dec_name), "%d:g:%d", f->index, group_idx);
+    tg->dec_opts.name       = tg->dec_name;
+    tg->dec_opts.log_parent = d;
+
+    tg->dec_opts.flags      = (ds0->dec_opts.flags & DECODER_FLAG_BITEXACT) |
+                              (!!(f->ctx->iformat->flags & AVFMT_NOTIMESTAMPS) * DECODER_FLAG_TS_UNRELIABLE);
+    tg->dec_opts.framerate  = ist0->st->avg_frame_rate;
+    tg->dec_opts.codec      = ist0->dec;
+    tg->dec_opts.par        = ist0->par;
+    tg->dec_opts.time_base  = ist0->st->time_base;
+    // tiles are composed in system memory
+    tg->dec_opts.hwaccel_id = HWACCEL_NONE;
+    tg->dec_opts.tile_grid  = stg;
+
+    ret = av_dict_copy(&tg->decoder_opts, ds0->decoder_opts, 0);
+    if (ret < 0)
+        return ret;
+
+    tg->decoded_params = av_frame_alloc();
+    if (!tg->decoded_params)
+        return AVERROR(ENOMEM);
+
+    ret = dec_init(&tg->decoder, d->sch, &tg->decoder_opts, &tg->dec_opts,
+                   tg->decoded_params);
+    if (ret < 0)
+        return ret;
+    tg->sch_idx_dec = ret;
+
+    ret = sch_connect(d->sch, SCH_DSTREAM(f->index, tg->sch_idx_stream),
+                              SCH_DEC_IN(tg->sch_idx_dec));
+    if (ret < 0)
+        return ret;
+
+    for (unsigned i = 0; i < stg->nb_streams; i++) {
+        InputStream *ist = f->streams[stg->streams[i]->index];
+        DemuxStream  *ds = ds_from_ist(ist);
+
+        ds->tile_grid    = tg;
+        ds->discard      = 0;
+        ist->st->discard = ist->user_set_discard;
+    }
+
+    if (!d->pkt_tile) {
+        d->pkt_tile = av_packet_alloc();
+        if (!d->pkt_tile)
+            return AVERROR(ENOMEM);
+    }
+
+    *ptg = tg;
+
+    return 0;
+}
+
+int ifile_tile_grid_filter_add(InputFile *f, int group_idx, InputFilter *ifilter,
+                               InputFilterOptions *opts, SchedulerNode *src)
+{
+    Demuxer                        *d = demuxer_from_ifile(f);
+    const AVStreamGroup          *stg = f->ctx->stream_groups[group_idx];
+    const AVStreamGroupTileGrid *grid = stg->params.tile_grid;
+    DemuxTileGrid *tg;
+    int ret;
+
+    ret = tile_grid_open(d, group_idx, &tg);
+    if (ret < 0)
+        return ret;
+
+    ret = dec_request_view(tg->decoder, NULL, src);
+    if (ret < 0)
+        return ret;
+
+    opts->framerate = av_guess_frame_rate(f->ctx, stg->streams[grid->offsets[0].idx], NULL);
+
+    ret = av_frame_copy_props(opts->fallback, tg->decoded_params);
+    if (ret < 0)
+        return ret;
+    opts->fallback->format = tg->decoded_params->format;
+    opts->fallback->width  = grid->width;
+    opts->fallback->height = grid->height;
+
+    ifilter_opts_trim(d, opts);
+
+    opts->name = av_strdup(tg->dec_name);
+    if (!opts->name)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
 static int choose_decoder(const OptionsContext *o, void *logctx,
                           AVFormatContext *s, AVStream *st,
                           enum HWAccelID hwaccel_id, enum AVHWDeviceType hwaccel_device_type,
@@ -714,6 +714,34 @@ static int ifilter_bind_ist(InputFilter *ifilter, InputStream *ist,
     return 0;
 }
 
+static int ifilter_bind_tile_grid(InputFilterPriv *ifp, InputFile *f, int group_idx)
+{
+    FilterGraphPriv *fgp = fgp_from_fg(ifp->ifilter.graph);
+    SchedulerNode src;
+    int ret;
+
+    av_assert0(!ifp->bound);
+    ifp->bound = 1;
+
+    if (ifp->type != AVMEDIA_TYPE_VIDEO) {
+        av_log(fgp, AV_LOG_ERROR, "Tried to connect a tile grid to %s filtergraph input\n",
+               av_get_media_type_string(ifp->type));
+        return AVERROR(EINVAL);
+    }
+
+    ifp->type_src = AVMEDIA_TYPE_VIDEO;
+
+    ifp->opts.fallback = av_frame_alloc();
+    if (!ifp->opts.fallback)
+        return AVERROR(ENOMEM);
+
+    ret = ifile_tile_grid_filter_add(f, group_idx, &ifp->ifilter, &ifp->opts, &src);
+    if (ret < 0)
+        return ret;
+
+    return sch_connect(fgp->sch, src, SCH_FILTER_IN(fgp->sch_idx, ifp->index));
+}
+
 static int ifilter_bind_dec(InputFilterPriv *ifp, Decoder *dec,
                             const ViewSpecifier *vs)
 {
@@ -1325,6 +1353,21 @@ static int fg_complex_bind_input(FilterGraph *fg, InputFilter *ifilter)
             }
         }
 
+        // bind to a tile grid stream group, composed by its decoder
+        if (type == AVMEDIA_TYPE_VIDEO && vs.type == VIEW_SPECIFIER_TYPE_NONE) {
+            int group_idx = ifile_tile_grid_find(input_files[file_idx], &ss);
+            if (group_idx >= 0) {
+                stream_specifier_uninit(&ss);
+
+                ret = ifilter_bind_tile_grid(ifp, input_files[file_idx], group_idx);
+                if (ret < 0)
+                    av_log(fg, AV_LOG_ERROR, "Error binding tile grid %d:g:%d to "
+                           "filtergraph input %s\n", file_idx, group_idx,
+                           ifilter->name);
+                return ret;
+            }
+        }
+
         for (i = 0; i < s->nb_streams; i++) {
             enum AVMediaType stream_type = s->streams[i]->codecpar->codec_type;
             if (stream_type != type &&
@@ -1782,6 +1782,30 @@ loop_end:
         ret = ost_add(mux, o, ofilter->type, NULL, ofilter, NULL, NULL);
         if (ret < 0)
             return ret;
+    } else if (map->tile_grid) {
+        FilterGraph *fg;
+        char *graph_desc;
+
+        if (o->video_disable)
+            return 0;
+
+        /* the tiles are composed by the decoder feeding a filtergraph input,
+         * so route the grid through a pass-through complex filtergraph */
+        graph_desc = av_asprintf("[%d:g:%d]null", map->file_index, map->stream_index);
+        if (!graph_desc)
+            return AVERROR(ENOMEM);
+
+        ret = fg_create(NULL, graph_desc, mux->sch);
+        if (ret < 0)
+            return ret;
+        fg = filtergraphs[nb_filtergraphs - 1];
+
+        av_log(mux, AV_LOG_VERBOSE, "Creating output stream from tile grid "
+               "%d:g:%d\n", map->file_index, map->stream_index);
+
+        ret = ost_add(mux, o, AVMEDIA_TYPE_VIDEO, NULL, fg->outputs[0], NULL, NULL);
+        if (ret < 0)
+            return ret;
     } else {
         const ViewSpecifier *vs = map->vs.type == VIEW_SPECIFIER_TYPE_NONE ?
                                   NULL : &map->vs;
@@ -544,14 +544,29 @@ static int opt_map(void *optctx, const char *opt, const char *arg)
             /* disable some already defined maps */
             for (i = 0; i < o->nb_stream_maps; i++) {
                 m = &o->stream_maps[i];
-                if (file_idx == m->file_index &&
+                if (file_idx != m->file_index)
+                    continue;
+                if (m->tile_grid ?
+                    ifile_tile_grid_find(input_files[file_idx], &ss) == m->stream_index :
                     stream_specifier_match(&ss,
                                            input_files[m->file_index]->ctx,
                                            input_files[m->file_index]->ctx->streams[m->stream_index],
                                            NULL))
                     m->disabled = 1;
             }
-        else
+        else if (vs.type == VIEW_SPECIFIER_TYPE_NONE &&
+                 (i = ifile_tile_grid_find(input_files[file_idx], &ss)) >= 0) {
+            /* a tile grid is mapped as the picture composed from its tiles */
+            ret = GROW_ARRAY(o->stream_maps, o->nb_stream_maps);
+            if (ret < 0)
+                goto fail;
+
+            m = &o->stream_maps[o->nb_stream_maps - 1];
+
+            m->file_index   = file_idx;
+            m->stream_index = i;
+            m->tile_grid    = 1;
+        } else
             for (i = 0; i < input_files[file_idx]->nb_streams; i++) {
                 if (!stream_specifier_match(&ss,
                                             input_files[file_idx]->ctx,
@@ -2086,6 +2086,21 @@ typedef struct AVCodecContext {
      */
     AVFrameSideData  **decoded_side_data;
     int             nb_decoded_side_data;
+
+    /**
+     * Maximum number of frames of output delay that frame threading may add.
+     * When set to a value smaller than thread_count - 1, at most
+     * frame_thread_delay + 1 frames are decoded concurrently and a frame is
+     * returned as soon as its decoding thread has finished, rather than when
+     * all threads are busy. The resulting delay is exported in
+     * AVCodecContext.delay.
+     *
+     * 0 means no limit other than the one implied by thread_count.
+     *
+     * - encoding: unused
+     * - decoding: Set by user before avcodec_open2().
+     */
+    int frame_thread_delay;
 } AVCodecContext;
 
 /**
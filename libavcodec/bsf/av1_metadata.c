@@ -150,6 +150,10 @@ static const CBSBSFType av1_metadata_type = {
     .update_fragment = &av1_metadata_update_fragment,
 };
 
+static const CodedBitstreamUnitType av1_metadata_decompose_unit_types[] = {
+    AV1_OBU_SEQUENCE_HEADER,
+};
+
 static int av1_metadata_init(AVBSFContext *bsf)
 {
     AV1MetadataContext *ctx = bsf->priv_data;
@@ -158,6 +162,10 @@ static int av1_metadata_init(AVBSFContext *bsf)
         .header.obu_type = AV1_OBU_TEMPORAL_DELIMITER,
     };
 
+    ctx->common.decompose_unit_types    = av1_metadata_decompose_unit_types;
+    ctx->common.nb_decompose_unit_types =
+        FF_ARRAY_ELEMS(av1_metadata_decompose_unit_types);
+
     return ff_cbs_bsf_generic_init(bsf, &av1_metadata_type);
 }
 
@@ -97,6 +97,7 @@ static int extract_extradata_av1(AVBSFContext *ctx, AVPacket *pkt,
 
     ExtractExtradataContext *s = ctx->priv_data;
 
+    const uint8_t *filtered_data = NULL;
     int extradata_size = 0, filtered_size = 0;
     int i, has_seq = 0, ret = 0;
 
@@ -111,6 +112,8 @@ static int extract_extradata_av1(AVBSFContext *ctx, AVPacket *pkt,
             if (obu->type == AV1_OBU_SEQUENCE_HEADER)
                 has_seq = 1;
         } else if (s->remove) {
+            if (!filtered_data)
+                filtered_data = obu->raw_data;
             filtered_size += obu->raw_size;
         }
     }
@@ -120,7 +123,13 @@ static int extract_extradata_av1(AVBSFContext *ctx, AVPacket *pkt,
         PutByteContext pb_filtered_data, pb_extradata;
         uint8_t *extradata;
 
-        if (s->remove) {
+        /* If the removed OBUs all precede the remaining ones, the filtered
+         * packet is a tail of the input and can reference it directly. */
+        if (s->remove && filtered_data &&
+            filtered_data + filtered_size != pkt->data + pkt->size)
+            filtered_data = NULL;
+
+        if (s->remove && !filtered_data) {
             filtered_buf = av_buffer_alloc(filtered_size + AV_INPUT_BUFFER_PADDING_SIZE);
             if (!filtered_buf) {
                 return AVERROR(ENOMEM);
@@ -138,23 +147,26 @@ static int extract_extradata_av1(AVBSFContext *ctx, AVPacket *pkt,
         *size = extradata_size;
 
         bytestream2_init_writer(&pb_extradata, extradata, extradata_size);
-        if (s->remove)
+        if (filtered_buf)
             bytestream2_init_writer(&pb_filtered_data, filtered_buf->data, filtered_size);
 
         for (i = 0; i < s->av1_pkt.nb_obus; i++) {
             AV1OBU *obu = &s->av1_pkt.obus[i];
             if (obu_is_global(obu)) {
                 bytestream2_put_bufferu(&pb_extradata, obu->raw_data, obu->raw_size);
-            } else if (s->remove) {
+            } else if (filtered_buf) {
                 bytestream2_put_bufferu(&pb_filtered_data, obu->raw_data, obu->raw_size);
             }
         }
 
-        if (s->remove) {
+        if (filtered_buf) {
             av_buffer_unref(&pkt->buf);
             pkt->buf  = filtered_buf;
             pkt->data = filtered_buf->data;
             pkt->size = filtered_size;
+        } else if (s->remove) {
+            pkt->data = (uint8_t *)filtered_data;
+            pkt->size = filtered_size;
         }
     }
 
@@ -549,6 +549,11 @@ static const CBSBSFType h264_metadata_type = {
     .update_fragment = &h264_metadata_update_fragment,
 };
 
+// Units which are needed when no slice or SEI content is touched.
+static const CodedBitstreamUnitType h264_metadata_decompose_unit_types[] = {
+    H264_NAL_SPS,
+};
+
 static int h264_metadata_init(AVBSFContext *bsf)
 {
     H264MetadataContext *ctx = bsf->priv_data;
@@ -586,6 +591,15 @@ static int h264_metadata_init(AVBSFContext *bsf)
         }
     }
 
+    // AUD insertion needs the slice types and SEI parsing depends on the
+    // active SPS, which is only known after reading the slice headers.
+    if (ctx->aud != BSF_ELEMENT_INSERT && !ctx->sei_user_data &&
+        !ctx->delete_filler && ctx->display_orientation == BSF_ELEMENT_PASS) {
+        ctx->common.decompose_unit_types    = h264_metadata_decompose_unit_types;
+        ctx->common.nb_decompose_unit_types =
+            FF_ARRAY_ELEMS(h264_metadata_decompose_unit_types);
+    }
+
     return ff_cbs_bsf_generic_init(bsf, &h264_metadata_type);
 }
 
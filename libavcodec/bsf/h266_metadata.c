@@ -114,8 +114,24 @@ static const CBSBSFType h266_metadata_type = {
     .update_fragment = &h266_metadata_update_fragment,
 };
 
+// Units which are needed when no slice content is touched.
+static const CodedBitstreamUnitType h266_metadata_decompose_unit_types[] = {
+    VVC_VPS_NUT,
+    VVC_SPS_NUT,
+    VVC_PPS_NUT,
+};
+
 static int h266_metadata_init(AVBSFContext *bsf)
 {
+    H266MetadataContext *ctx = bsf->priv_data;
+
+    // AUD insertion needs the slice types and picture header.
+    if (ctx->aud != BSF_ELEMENT_INSERT) {
+        ctx->common.decompose_unit_types    = h266_metadata_decompose_unit_types;
+        ctx->common.nb_decompose_unit_types =
+            FF_ARRAY_ELEMS(h266_metadata_decompose_unit_types);
+    }
+
     return ff_cbs_bsf_generic_init(bsf, &h266_metadata_type);
 }
 
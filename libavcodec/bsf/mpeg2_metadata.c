@@ -175,6 +175,11 @@ static const CBSBSFType mpeg2_metadata_type = {
     .update_fragment = &mpeg2_metadata_update_fragment,
 };
 
+static const CodedBitstreamUnitType mpeg2_metadata_decompose_unit_types[] = {
+    MPEG2_START_SEQUENCE_HEADER,
+    MPEG2_START_EXTENSION,
+};
+
 static int mpeg2_metadata_init(AVBSFContext *bsf)
 {
     MPEG2MetadataContext *ctx = bsf->priv_data;
@@ -191,6 +196,10 @@ static int mpeg2_metadata_init(AVBSFContext *bsf)
     VALIDITY_CHECK(matrix_coefficients);
 #undef VALIDITY_CHECK
 
+    ctx->common.decompose_unit_types    = mpeg2_metadata_decompose_unit_types;
+    ctx->common.nb_decompose_unit_types =
+        FF_ARRAY_ELEMS(mpeg2_metadata_decompose_unit_types);
+
     return ff_cbs_bsf_generic_init(bsf, &mpeg2_metadata_type);
 }
 
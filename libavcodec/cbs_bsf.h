@@ -57,6 +57,13 @@ typedef struct CBSBSFContext {
     CodedBitstreamContext *input;
     CodedBitstreamContext *output;
     CodedBitstreamFragment fragment;
+
+    // Unit types which update_fragment() needs to see the content of.
+    // If set before calling ff_cbs_bsf_generic_init(), only these units
+    // are decomposed; all others are passed through as opaque data and
+    // copied unchanged to the output.  If NULL, all units are decomposed.
+    const CodedBitstreamUnitType *decompose_unit_types;
+    int                        nb_decompose_unit_types;
 } CBSBSFContext;
 
 /**
@@ -884,9 +884,12 @@ static int b44_uncompress(const EXRContext *s, const uint8_t *src, int compresse
     return 0;
 }
 
+/**
+ * @return a mask of the columns holding non-zero AC coefficients
+ */
 static int ac_uncompress(const EXRContext *s, GetByteContext *gb, float *block)
 {
-    int ret = 0, n = 1;
+    int cols = 0, n = 1;
 
     while (n < 64) {
         uint16_t val = bytestream2_get_ne16(gb);
@@ -896,13 +899,15 @@ static int ac_uncompress(const EXRContext *s, GetByteContext *gb, float *block)
         } else if ((val >> 8) == 0xff) {
             n += val & 0xff;
         } else {
-            ret = n;
-            block[ff_zigzag_direct[n]] = av_int2float(half2float(val, &s->h2f_tables));
+            const int pos = ff_zigzag_direct[n];
+
+            cols |= 1 << (pos & 7);
+            block[pos] = av_int2float(half2float(val, &s->h2f_tables));
             n++;
         }
     }
 
-    return ret;
+    return cols;
 }
 
 static void idct_1d(float *blk, int step)
@@ -949,13 +954,40 @@ static void idct_1d(float *blk, int step)
     blk[7 * step] = gamma[0] - beta[0];
 }
 
-static void dct_inverse(float *block)
+/* idct_1d() of a vector with only blk[0] set; the remaining zero terms are
+ * kept so that the result, including the sign of zeros, is the same. */
+static void idct_1d_dc(float *blk)
 {
+    const float a = .5f * cosf(M_PI / 4.f);
+    const float theta0 = a * (blk[0] + 0.f);
+    const float theta3 = a * blk[0];
+    const float gamma0 = theta0 + 0.f;
+    const float gamma1 = theta3 + 0.f;
+
+    blk[0] = gamma0 + 0.f;
+    blk[1] = gamma1 + 0.f;
+    blk[2] = theta3 + 0.f;
+    blk[3] = theta0 + 0.f;
+
+    blk[4] = theta0;
+    blk[5] = theta3;
+    blk[6] = gamma1;
+    blk[7] = gamma0;
+}
+
+static void dct_inverse(float *block, int cols)
+{
+    /* Columns without coefficients stay zero. */
+    cols |= 1;
     for (int i = 0; i < 8; i++)
-        idct_1d(block + i, 8);
+        if (cols & (1 << i))
+            idct_1d(block + i, 8);
 
     for (int i = 0; i < 8; i++) {
-        idct_1d(block, 1);
+        if (cols == 1)
+            idct_1d_dc(block);
+        else
+            idct_1d(block, 1);
         block += 8;
     }
 }
@@ -1118,8 +1150,7 @@ static int dwa_uncompress(const EXRContext *s, const uint8_t *src, int compresse
                 dc_val.i = half2float(dc[idx], &s->h2f_tables);
 
                 block[0] = dc_val.f;
-                ac_uncompress(s, &agb, block);
-                dct_inverse(block);
+                dct_inverse(block, ac_uncompress(s, &agb, block));
             }
 
             {
@@ -1133,16 +1164,28 @@ static int dwa_uncompress(const EXRContext *s, const uint8_t *src, int compresse
                 float *yb = td->block[0];
                 float *ub = td->block[1];
                 float *vb = td->block[2];
+                float b = 0.f, g = 0.f, r = 0.f;
 
                 for (int yy = 0; yy < 8; yy++) {
                     for (int xx = 0; xx < 8; xx++) {
                         const int idx = xx + yy * 8;
 
-                        convert(yb[idx], ub[idx], vb[idx], &bo[xx], &go[xx], &ro[xx]);
+                        /* Flat areas repeat the previous pixel, reuse its
+                         * output instead of linearizing it again. */
+                        if (!idx ||
+                            av_float2int(yb[idx]) != av_float2int(yb[idx - 1]) ||
+                            av_float2int(ub[idx]) != av_float2int(ub[idx - 1]) ||
+                            av_float2int(vb[idx]) != av_float2int(vb[idx - 1])) {
+                            convert(yb[idx], ub[idx], vb[idx], &b, &g, &r);
+
+                            b = to_linear(b, 1.f);
+                            g = to_linear(g, 1.f);
+                            r = to_linear(r, 1.f);
+                        }
 
-                        bo[xx] = to_linear(bo[xx], 1.f);
-                        go[xx] = to_linear(go[xx], 1.f);
-                        ro[xx] = to_linear(ro[xx], 1.f);
+                        bo[xx] = b;
+                        go[xx] = g;
+                        ro[xx] = r;
                     }
 
                     bo += td->xsize * s->nb_channels;
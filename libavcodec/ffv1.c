@@ -210,6 +210,8 @@ av_cold int ff_ffv1_close(AVCodecContext *avctx)
 
         av_freep(&sc->sample_buffer);
         av_freep(&sc->sample_buffer32);
+        av_freep(&sc->context_buffer);
+        av_freep(&sc->diff_buffer);
 
         ff_refstruct_unref(&sc->plane);
     }
@@ -70,6 +70,8 @@ typedef struct PlaneContext {
 typedef struct FFV1SliceContext {
     int16_t *sample_buffer;
     int32_t *sample_buffer32;
+    int32_t *context_buffer;     ///< contexts of the current line, encoder only
+    int32_t *diff_buffer;        ///< folded residuals of the current line, encoder only
 
     int slice_width;
     int slice_height;
@@ -879,14 +879,21 @@ slices_ok:
     s->slice_count = s->max_slice_count;
 
     for (int j = 0; j < s->slice_count; j++) {
+        FFV1SliceContext *sc = &s->slices[j];
+
+        sc->context_buffer = av_malloc_array(s->width + 6, sizeof(*sc->context_buffer));
+        sc->diff_buffer    = av_malloc_array(s->width + 6, sizeof(*sc->diff_buffer));
+        if (!sc->context_buffer || !sc->diff_buffer)
+            return AVERROR(ENOMEM);
+
         for (int i = 0; i < s->plane_count; i++) {
-            PlaneContext *const p = &s->slices[j].plane[i];
+            PlaneContext *const p = &sc->plane[i];
 
             p->quant_table_index = s->context_model;
             p->context_count     = s->context_count[p->quant_table_index];
         }
 
-        ff_build_rac_states(&s->slices[j].c, 0.05 * (1LL << 32), 256 - 8);
+        ff_build_rac_states(&sc->c, 0.05 * (1LL << 32), 256 - 8);
     }
 
     if ((ret = ff_ffv1_init_slices_state(s)) < 0)
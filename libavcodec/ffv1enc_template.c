@@ -30,6 +30,9 @@ RENAME(encode_line)(FFV1Context *f, FFV1SliceContext *sc,
 {
     PlaneContext *const p = &sc->plane[plane_index];
     RangeCoder *const c   = &sc->c;
+    const int16_t (*quant_table)[256] = f->quant_tables[p->quant_table_index];
+    int32_t *const context_buffer = sc->context_buffer;
+    int32_t *const diff_buffer    = sc->diff_buffer;
     int x;
     int run_index = sc->run_index;
     int run_count = 0;
@@ -59,10 +62,12 @@ RENAME(encode_line)(FFV1Context *f, FFV1SliceContext *sc,
         return 0;
     }
 
+    /* All samples of the line are known, so compute the contexts and
+     * residuals in a separate pass that does not depend on the coder state. */
     for (x = 0; x < w; x++) {
         int diff, context;
 
-        context = RENAME(get_context)(f->quant_tables[p->quant_table_index],
+        context = RENAME(get_context)(quant_table,
                                       sample[0] + x, sample[1] + x, sample[2] + x);
         diff    = sample[0][x] - RENAME(predict)(sample[0] + x, sample[1] + x);
 
@@ -71,7 +76,13 @@ RENAME(encode_line)(FFV1Context *f, FFV1SliceContext *sc,
             diff    = -diff;
         }
 
-        diff = fold(diff, bits);
+        context_buffer[x] = context;
+        diff_buffer[x]    = fold(diff, bits);
+    }
+
+    for (x = 0; x < w; x++) {
+        int diff    = diff_buffer[x];
+        int context = context_buffer[x];
 
         if (ac != AC_GOLOMB_RICE) {
             if (pass1) {
@@ -29,6 +29,7 @@
 #include "bytestream.h"
 #include "h264.h"
 #include "h2645_parse.h"
+#include "startcode.h"
 #include "vvc.h"
 
 #include "hevc/hevc.h"
@@ -402,17 +403,19 @@ static int h264_parse_nal_header(H2645NAL *nal, void *logctx)
 
 static int find_next_start_code(const uint8_t *buf, const uint8_t *next_avc)
 {
-    int i = 0;
+    const uint8_t *p;
+    uint32_t state = -1;
 
     if (buf + 3 >= next_avc)
         return next_avc - buf;
 
-    while (buf + i + 3 < next_avc) {
-        if (buf[i] == 0 && buf[i + 1] == 0 && buf[i + 2] == 1)
-            break;
-        i++;
-    }
-    return i + 3;
+    /* avpriv_find_start_code() also consumes the byte following the
+     * start code; a start code without one is not a valid NAL start. */
+    p = avpriv_find_start_code(buf, next_avc, &state);
+    if ((state & 0xFFFFFF00) != 0x100)
+        return next_avc - buf;
+
+    return p - 1 - buf;
 }
 
 static void alloc_rbsp_buffer(H2645RBSP *rbsp, unsigned int size, int use_ref)
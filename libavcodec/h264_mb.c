@@ -785,6 +785,139 @@ static av_always_inline void hl_decode_mb_idct_luma(const H264Context *h, H264Sl
     }
 }
 
+/* Reconstruction for the lowres option, only 8-bit 4:2:0 progressive
+ * content is handled, see h264_slice_header_init().
+ * Intra prediction does not tolerate reduced size reconstruction, errors
+ * propagate across the whole picture. Each macroblock is thus decoded at
+ * full size into bipred_scratchpad, which is unused without inter
+ * prediction, with the bottom rows of the macroblocks above kept in
+ * top_borders and the right column of the previous macroblock kept in
+ * the scratchpad itself. Only the downscaled result is written to the
+ * picture. Non-intra slices are never decoded at reduced size, see
+ * ff_h264_queue_decode_slice(). */
+
+#define LOWRES_LINESIZE   64
+#define LOWRES_UVLINESIZE 32
+
+static const int lowres_block_offset[48] = {
+      0,   4, 256, 260,   8,  12, 264, 268,
+    512, 516, 768, 772, 520, 524, 776, 780,
+      0,   4, 128, 132,   8,  12, 136, 140,
+    256, 260, 384, 388, 264, 268, 392, 396,
+      0,   4, 128, 132,   8,  12, 136, 140,
+    256, 260, 384, 388, 264, 268, 392, 396,
+};
+
+static av_always_inline void lowres_downscale(uint8_t *dst, ptrdiff_t dst_stride,
+                                              const uint8_t *src, ptrdiff_t src_stride,
+                                              int size, int lowres)
+{
+    const int f = 1 << lowres;
+
+    for (int y = 0; y < size >> lowres; y++) {
+        for (int x = 0; x < size >> lowres; x++) {
+            int sum = 0;
+            for (int j = 0; j < f; j++)
+                for (int i = 0; i < f; i++)
+                    sum += src[j * src_stride + x * f + i];
+            dst[x] = (sum + (f * f >> 1)) >> (2 * lowres);
+        }
+        dst += dst_stride;
+        src += f * src_stride;
+    }
+}
+
+static av_always_inline void lowres_put_mb(const H264Context *h, H264SliceContext *sl,
+                                           uint8_t *const src[3], int lowres)
+{
+    const int mb_x = sl->mb_x, mb_y = sl->mb_y;
+
+    lowres_downscale(h->cur_pic.f->data[0] + (mb_x + mb_y * sl->linesize) * (16 >> lowres),
+                     sl->linesize, src[0], LOWRES_LINESIZE, 16, lowres);
+    lowres_downscale(h->cur_pic.f->data[1] + (mb_x + mb_y * sl->uvlinesize) * (8 >> lowres),
+                     sl->uvlinesize, src[1], LOWRES_UVLINESIZE, 8, lowres);
+    lowres_downscale(h->cur_pic.f->data[2] + (mb_x + mb_y * sl->uvlinesize) * (8 >> lowres),
+                     sl->uvlinesize, src[2], LOWRES_UVLINESIZE, 8, lowres);
+}
+
+static void hl_decode_mb_lowres(const H264Context *h, H264SliceContext *sl)
+{
+    const int lowres  = h->avctx->lowres;
+    const int mb_x    = sl->mb_x;
+    const int mb_y    = sl->mb_y;
+    const int mb_xy   = sl->mb_xy;
+    const int mb_type = h->cur_pic.mb_type[mb_xy];
+    const int *block_offset = lowres_block_offset;
+    uint8_t (*top_borders)[(16 * 3) * 2] = sl->top_borders[!(mb_y & 1)];
+    uint8_t *dest[3];
+    int i;
+
+    dest[0] = sl->bipred_scratchpad + LOWRES_LINESIZE + 16;
+    dest[1] = sl->bipred_scratchpad + 17 * LOWRES_LINESIZE + LOWRES_UVLINESIZE + 16;
+    dest[2] = dest[1] + 9 * LOWRES_UVLINESIZE;
+
+    /* neighbouring samples: the previous macroblock is still in place */
+    for (i = 0; i < 16; i++)
+        dest[0][i * LOWRES_LINESIZE - 1] = dest[0][i * LOWRES_LINESIZE + 15];
+    for (i = 0; i < 8; i++) {
+        dest[1][i * LOWRES_UVLINESIZE - 1] = dest[1][i * LOWRES_UVLINESIZE + 7];
+        dest[2][i * LOWRES_UVLINESIZE - 1] = dest[2][i * LOWRES_UVLINESIZE + 7];
+    }
+    if (mb_y) {
+        AV_COPY128(dest[0] - LOWRES_LINESIZE,   top_borders[mb_x]);
+        AV_COPY64(dest[1]  - LOWRES_UVLINESIZE, top_borders[mb_x] + 16);
+        AV_COPY64(dest[2]  - LOWRES_UVLINESIZE, top_borders[mb_x] + 24);
+        if (mb_x) {
+            dest[0][-LOWRES_LINESIZE   - 1] = top_borders[mb_x - 1][15];
+            dest[1][-LOWRES_UVLINESIZE - 1] = top_borders[mb_x - 1][23];
+            dest[2][-LOWRES_UVLINESIZE - 1] = top_borders[mb_x - 1][31];
+        }
+        if (mb_x + 1 < h->mb_width)
+            AV_COPY64(dest[0] - LOWRES_LINESIZE + 16, top_borders[mb_x + 1]);
+    }
+
+    h->list_counts[mb_xy] = sl->list_count;
+    sl->mb_linesize   = sl->linesize;
+    sl->mb_uvlinesize = sl->uvlinesize;
+
+    if (IS_INTRA_PCM(mb_type)) {
+        for (i = 0; i < 16; i++)
+            memcpy(dest[0] + i * LOWRES_LINESIZE, sl->intra_pcm_ptr + i * 16, 16);
+        for (i = 0; i < 8; i++) {
+            memcpy(dest[1] + i * LOWRES_UVLINESIZE, sl->intra_pcm_ptr + 256 + i * 8, 8);
+            memcpy(dest[2] + i * LOWRES_UVLINESIZE, sl->intra_pcm_ptr + 320 + i * 8, 8);
+        }
+    } else {
+        h->hpc.pred8x8[sl->chroma_pred_mode](dest[1], LOWRES_UVLINESIZE);
+        h->hpc.pred8x8[sl->chroma_pred_mode](dest[2], LOWRES_UVLINESIZE);
+        hl_decode_mb_predict_luma(h, sl, mb_type, 1, 0, 0, block_offset,
+                                  LOWRES_LINESIZE, dest[0], 0);
+        hl_decode_mb_idct_luma(h, sl, mb_type, 1, 0, 0, block_offset,
+                               LOWRES_LINESIZE, dest[0], 0);
+
+        if (sl->cbp & 0x30) {
+            if (sl->non_zero_count_cache[scan8[CHROMA_DC_BLOCK_INDEX + 0]])
+                h->h264dsp.h264_chroma_dc_dequant_idct(sl->mb + 16 * 16 * 1,
+                                                       h->ps.pps->dequant4_coeff[1][sl->chroma_qp[0]][0]);
+            if (sl->non_zero_count_cache[scan8[CHROMA_DC_BLOCK_INDEX + 1]])
+                h->h264dsp.h264_chroma_dc_dequant_idct(sl->mb + 16 * 16 * 2,
+                                                       h->ps.pps->dequant4_coeff[2][sl->chroma_qp[1]][0]);
+            h->h264dsp.h264_idct_add8(dest + 1, block_offset, sl->mb,
+                                      LOWRES_UVLINESIZE, sl->non_zero_count_cache);
+        }
+    }
+
+    AV_COPY128(sl->top_borders[mb_y & 1][mb_x],      dest[0] + 15 * LOWRES_LINESIZE);
+    AV_COPY64(sl->top_borders[mb_y & 1][mb_x] + 16, dest[1] +  7 * LOWRES_UVLINESIZE);
+    AV_COPY64(sl->top_borders[mb_y & 1][mb_x] + 24, dest[2] +  7 * LOWRES_UVLINESIZE);
+
+    switch (lowres) {
+    case 1: lowres_put_mb(h, sl, dest, 1); break;
+    case 2: lowres_put_mb(h, sl, dest, 2); break;
+    case 3: lowres_put_mb(h, sl, dest, 3); break;
+    }
+}
+
 #define BITS   8
 #define SIMPLE 1
 #include "h264_mb_template.c"
@@ -804,7 +937,9 @@ void ff_h264_hl_decode_mb(const H264Context *h, H264SliceContext *sl)
     int is_complex    = CONFIG_SMALL || sl->is_complex ||
                         IS_INTRA_PCM(mb_type) || sl->qscale == 0;
 
-    if (CHROMA444(h)) {
+    if (h->avctx->lowres) {
+        hl_decode_mb_lowres(h, sl);
+    } else if (CHROMA444(h)) {
         if (is_complex || h->pixel_shift)
             hl_decode_mb_444_complex(h, sl);
         else
@@ -901,6 +901,15 @@ static enum AVPixelFormat get_pixel_format(H264Context *h, int force_callback)
         return AVERROR_INVALIDDATA;
     }
 
+    /* hardware decoders cannot reconstruct at reduced resolution */
+    if (h->avctx->lowres) {
+        enum AVPixelFormat *sw = pix_fmts;
+        for (enum AVPixelFormat *f = pix_fmts; f < fmt; f++)
+            if (!(av_pix_fmt_desc_get(*f)->flags & AV_PIX_FMT_FLAG_HWACCEL))
+                *sw++ = *f;
+        fmt = sw;
+    }
+
     *fmt = AV_PIX_FMT_NONE;
 
     for (int i = 0; pix_fmts[i] != AV_PIX_FMT_NONE; i++)
@@ -940,6 +949,16 @@ static void init_dimensions(H264Context *h)
         h->height_from_caller = 0;
     }
 
+    if (h->avctx->lowres) {
+        const int lowres = h->avctx->lowres;
+        width  = AV_CEIL_RSHIFT(width,  lowres);
+        height = AV_CEIL_RSHIFT(height, lowres);
+        cl   >>= lowres;
+        ct   >>= lowres;
+        cr     = AV_CEIL_RSHIFT(h->width,  lowres) - cl - width;
+        cb     = AV_CEIL_RSHIFT(h->height, lowres) - ct - height;
+    }
+
     h->avctx->coded_width  = h->width;
     h->avctx->coded_height = h->height;
     h->avctx->width        = width;
@@ -960,6 +979,15 @@ static int h264_slice_header_init(H264Context *h)
         goto fail;
     }
 
+    if (h->avctx->lowres &&
+        (sps->bit_depth_luma != 8 || sps->chroma_format_idc != 1 ||
+         !sps->frame_mbs_only_flag || sps->transform_bypass)) {
+        avpriv_report_missing_feature(h->avctx,
+                                      "lowres with other than 8-bit 4:2:0 progressive");
+        ret = AVERROR_PATCHWELCOME;
+        goto fail;
+    }
+
     ff_set_sar(h->avctx, sps->vui.sar);
     av_pix_fmt_get_chroma_sub_sample(h->avctx->pix_fmt,
                                      &h->chroma_x_shift, &h->chroma_y_shift);
@@ -1949,7 +1977,8 @@ static int h264_slice_init(H264Context *h, H264SliceContext *sl,
         (h->avctx->skip_loop_filter >= AVDISCARD_BIDIR  &&
          sl->slice_type_nos == AV_PICTURE_TYPE_B) ||
         (h->avctx->skip_loop_filter >= AVDISCARD_NONREF &&
-         nal->ref_idc == 0))
+         nal->ref_idc == 0) ||
+        h->avctx->lowres)
         sl->deblocking_filter = 0;
 
     if (sl->deblocking_filter == 1 && h->nb_slice_ctx > 1) {
@@ -2123,13 +2152,29 @@ int ff_h264_queue_decode_slice(H264Context *h, const H2645NAL *nal)
         if (
             (h->avctx->skip_frame >= AVDISCARD_NONREF && !h->nal_ref_idc) ||
             (h->avctx->skip_frame >= AVDISCARD_BIDIR  && sl->slice_type_nos == AV_PICTURE_TYPE_B) ||
-            (h->avctx->skip_frame >= AVDISCARD_NONINTRA && sl->slice_type_nos != AV_PICTURE_TYPE_I) ||
+            ((h->avctx->skip_frame >= AVDISCARD_NONINTRA || h->avctx->lowres) && sl->slice_type_nos != AV_PICTURE_TYPE_I) ||
             (h->avctx->skip_frame >= AVDISCARD_NONKEY && h->nal_unit_type != H264_NAL_IDR_SLICE && h->sei.recovery_point.recovery_frame_cnt < 0) ||
             h->avctx->skip_frame >= AVDISCARD_ALL) {
             return 0;
         }
     }
 
+    /* Reduced size reconstruction only handles intra macroblocks, drop the
+     * non-intra slices of pictures that started with an intra slice. */
+    if (h->avctx->lowres && sl->slice_type_nos != AV_PICTURE_TYPE_I) {
+        av_log(h->avctx, AV_LOG_WARNING,
+               "Skipping a non-intra slice of an intra picture with lowres\n");
+        if (h->cur_pic_ptr) {
+            if (h->cur_pic_ptr->decode_error_flags)
+                atomic_fetch_or_explicit(h->cur_pic_ptr->decode_error_flags,
+                                         FF_DECODE_ERROR_DECODE_SLICES,
+                                         memory_order_relaxed);
+            else
+                h->cur_pic_ptr->f->decode_error_flags |= FF_DECODE_ERROR_DECODE_SLICES;
+        }
+        return 0;
+    }
+
     if (!first_slice) {
         const PPS *pps = h->ps.pps_list[sl->pps_id];
 
@@ -121,6 +121,9 @@ void ff_h264_draw_horiz_band(const H264Context *h, H264SliceContext *sl,
         y      <<= 1;
     }
 
+    y      >>= avctx->lowres;
+    height   = AV_CEIL_RSHIFT(height, avctx->lowres);
+
     height = FFMIN(height, avctx->height - y);
 
     desc   = av_pix_fmt_desc_get(avctx->pix_fmt);
@@ -430,6 +433,10 @@ FF_ENABLE_DEPRECATION_WARNINGS
     if (h->enable_er < 0 && (avctx->active_thread_type & FF_THREAD_SLICE))
         h->enable_er = 0;
 
+    /* concealment works on full resolution macroblocks */
+    if (avctx->lowres)
+        h->enable_er = 0;
+
     if (h->enable_er && (avctx->active_thread_type & FF_THREAD_SLICE)) {
         av_log(avctx, AV_LOG_WARNING,
                "Error resilience with slice threads is enabled. It is unsafe and unsupported and may crash. "
@@ -1074,7 +1081,7 @@ static int h264_decode_frame(AVCodecContext *avctx, AVFrame *pict,
     }
 
     if (!(avctx->flags2 & AV_CODEC_FLAG2_CHUNKS) && (!h->cur_pic_ptr || !h->has_slice)) {
-        if (avctx->skip_frame >= AVDISCARD_NONREF ||
+        if (avctx->skip_frame >= AVDISCARD_NONREF || avctx->lowres ||
             buf_size >= 4 && !memcmp("Q264", buf, 4))
             return buf_size;
         av_log(avctx, AV_LOG_ERROR, "no frame!\n");
@@ -1170,4 +1177,5 @@ const FFCodec ff_h264_decoder = {
     UPDATE_THREAD_CONTEXT_FOR_USER(ff_h264_update_thread_context_for_user),
     .p.profiles            = NULL_IF_CONFIG_SMALL(ff_h264_profiles),
     .p.priv_class          = &h264_class,
+    .p.max_lowres          = 3,
 };
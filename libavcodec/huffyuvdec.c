@@ -35,6 +35,7 @@
 #include "config_components.h"
 
 #include "avcodec.h"
+#include "bitstream.h"
 #include "bswapdsp.h"
 #include "bytestream.h"
 #include "codec_internal.h"
@@ -50,6 +51,11 @@
 
 #define VLC_BITS 12
 
+typedef struct HuffEntry {
+    uint8_t  len;
+    uint16_t sym;
+} HuffEntry;
+
 typedef struct HYuvDecContext {
     GetBitContext gb;
     Predictor predictor;
@@ -79,6 +85,8 @@ typedef struct HYuvDecContext {
     uint32_t bits[4][MAX_VLC_N];
     uint32_t pix_bgr_map[1<<VLC_BITS];
     VLC vlc[8];                             //Y,U,V,A,YY,YU,YV,AA
+    VLC_MULTI multi[4];                     //Y,U,V,A, joint tables for up to 6 symbols
+    HuffEntry he[MAX_VLC_N];
     uint8_t *bitstream_buffer;
     unsigned int bitstream_buffer_size;
     BswapDSPContext bdsp;
@@ -255,6 +263,44 @@ out:
     return ret;
 }
 
+/**
+ * Build the single-symbol VLC of a plane from canonical codes. For bps <= 14
+ * a multi-symbol table is built alongside it, so that runs of short codes
+ * can be decoded with a single lookup.
+ */
+static int build_plane_vlc(HYuvDecContext *s, int plane, int nb_codes)
+{
+    const uint8_t *len_table = s->len[plane];
+    HuffEntry *he = s->he;
+    unsigned pos[33] = { 0 };
+    int nb_elems;
+
+    ff_vlc_free(&s->vlc[plane]);
+    ff_vlc_free_multi(&s->multi[plane]);
+
+    if (s->bps > 14)
+        return vlc_init(&s->vlc[plane], VLC_BITS, nb_codes, len_table, 1, 1,
+                        s->bits[plane], 4, 4, 0);
+
+    /* ff_huffyuv_generate_bits_table() assigns the numerically smallest
+     * codes to the longest lengths, with ties ordered by symbol; this is
+     * exactly the tree order ff_vlc_init_multi_from_lengths() expects. */
+    for (int i = 0; i < nb_codes; i++)
+        pos[len_table[i]]++;
+    for (int len = 31; len > 0; len--)
+        pos[len] += pos[len + 1];
+    nb_elems = pos[1];
+    for (int i = nb_codes; i-- > 0;)
+        if (len_table[i])
+            he[--pos[len_table[i]]] = (HuffEntry){ len_table[i], i };
+
+    return ff_vlc_init_multi_from_lengths(&s->vlc[plane], &s->multi[plane],
+                                          VLC_BITS, nb_codes, nb_elems,
+                                          &he[0].len, sizeof(he[0]),
+                                          &he[0].sym, sizeof(he[0]), sizeof(he[0].sym),
+                                          0, 0, NULL);
+}
+
 static int read_huffman_tables(HYuvDecContext *s, const uint8_t *src, int length)
 {
     GetByteContext gb;
@@ -271,9 +317,7 @@ static int read_huffman_tables(HYuvDecContext *s, const uint8_t *src, int length
             return ret;
         if ((ret = ff_huffyuv_generate_bits_table(s->bits[i], s->len[i], s->vlc_n)) < 0)
             return ret;
-        ff_vlc_free(&s->vlc[i]);
-        if ((ret = vlc_init(&s->vlc[i], VLC_BITS, s->vlc_n, s->len[i], 1, 1,
-                           s->bits[i], 4, 4, 0)) < 0)
+        if ((ret = build_plane_vlc(s, i, s->vlc_n)) < 0)
             return ret;
     }
 
@@ -312,6 +356,7 @@ static int read_old_huffman_tables(HYuvDecContext *s)
 
     for (i = 0; i < 4; i++) {
         ff_vlc_free(&s->vlc[i]);
+        ff_vlc_free_multi(&s->multi[i]);
         if ((ret = vlc_init(&s->vlc[i], VLC_BITS, 256, s->len[i], 1, 1,
                             s->bits[i], 4, 4, 0)) < 0)
             return ret;
@@ -335,6 +380,8 @@ static av_cold int decode_end(AVCodecContext *avctx)
 
     for (i = 0; i < 8; i++)
         ff_vlc_free(&s->vlc[i]);
+    for (i = 0; i < 4; i++)
+        ff_vlc_free_multi(&s->multi[i]);
 
     return 0;
 }
@@ -712,11 +759,52 @@ static void decode_422_bitstream(HYuvDecContext *s, int count)
     dst1 = get_vlc2(&s->gb, s->vlc[plane].table, VLC_BITS, 3)*4;\
     dst1 += get_bits(&s->gb, 2);\
 }
+/**
+ * Decode width symbols of one plane using the multi-symbol table,
+ * which yields up to VLC_MULTI_MAX_SYMBOLS (8 bit) or half as many
+ * (9-14 bit) symbols per lookup.
+ */
+static av_always_inline void decode_plane_multi(HYuvDecContext *s, uint8_t *dst,
+                                                int width, int plane, int b)
+{
+    const VLC_MULTI_ELEM *const multi = s->multi[plane].table;
+    const VLCElem *const vlc = s->vlc[plane].table;
+    BitstreamContext bc;
+    int x = 0;
+
+    /* Switch to the cached reader for the duration of the row; the
+     * non-cached GetBitContext is resynced from its position afterwards. */
+    bits_init(&bc, s->gb.buffer, s->gb.size_in_bits);
+    bits_skip(&bc, get_bits_count(&s->gb));
+
+    while (x < width - VLC_MULTI_MAX_SYMBOLS && bits_left(&bc) > 0) {
+        int ret = bits_read_vlc_multi(&bc, dst + x * b, multi, vlc,
+                                      VLC_BITS, 3, b);
+        if (ret <= 0)
+            break;
+        x += ret;
+    }
+    for (; x < width && bits_left(&bc) > 0; x++) {
+        int code = bits_read_vlc(&bc, vlc, VLC_BITS, 3);
+        if (b == 1)
+            dst[x] = code;
+        else
+            AV_WN16(dst + 2 * x, code);
+    }
+
+    skip_bits_long(&s->gb, bits_tell(&bc) - get_bits_count(&s->gb));
+}
+
 static void decode_plane_bitstream(HYuvDecContext *s, int width, int plane)
 {
     int i, count = width/2;
 
-    if (s->bps <= 8) {
+    if (s->multi[plane].table) {
+        if (s->bps <= 8)
+            decode_plane_multi(s, s->temp[0], width, plane, 1);
+        else
+            decode_plane_multi(s, (uint8_t *)s->temp16[0], width, plane, 2);
+    } else if (s->bps <= 8) {
         OPEN_READER(re, &s->gb);
         if (count >= (get_bits_left(&s->gb)) / (32 * 2)) {
             for (i = 0; i < count && BITS_LEFT(re, &s->gb) > 0; i++) {
@@ -776,19 +864,24 @@ static void decode_plane_bitstream(HYuvDecContext *s, int width, int plane)
 static void decode_gray_bitstream(HYuvDecContext *s, int count)
 {
     int i;
-    OPEN_READER(re, &s->gb);
-    count /= 2;
 
-    if (count >= (get_bits_left(&s->gb)) / (32 * 2)) {
-        for (i = 0; i < count && BITS_LEFT(re, &s->gb) > 0; i++) {
-            READ_2PIX(s->temp[0][2 * i], s->temp[0][2 * i + 1], 0);
-        }
+    if (s->multi[0].table) {
+        decode_plane_multi(s, s->temp[0], count & ~1, 0, 1);
     } else {
-        for (i = 0; i < count; i++) {
-            READ_2PIX(s->temp[0][2 * i], s->temp[0][2 * i + 1], 0);
+        OPEN_READER(re, &s->gb);
+        count /= 2;
+
+        if (count >= (get_bits_left(&s->gb)) / (32 * 2)) {
+            for (i = 0; i < count && BITS_LEFT(re, &s->gb) > 0; i++) {
+                READ_2PIX(s->temp[0][2 * i], s->temp[0][2 * i + 1], 0);
+            }
+        } else {
+            for (i = 0; i < count; i++) {
+                READ_2PIX(s->temp[0][2 * i], s->temp[0][2 * i + 1], 0);
+            }
         }
+        CLOSE_READER(re, &s->gb);
     }
-    CLOSE_READER(re, &s->gb);
 }
 
 static av_always_inline void decode_bgr_1(HYuvDecContext *s, int count,
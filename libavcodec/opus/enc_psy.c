@@ -28,8 +28,8 @@
 #include "tab.h"
 #include "libavfilter/window_func.h"
 
-static float pvq_band_cost(CeltPVQ *pvq, CeltFrame *f, OpusRangeCoder *rc, int band,
-                           float *bits, float lambda)
+static float pvq_band_cost(CeltPVQ *pvq, CeltFrame *f, const CeltFrame *src,
+                           OpusRangeCoder *rc, int band, float *bits, float lambda)
 {
     int i, b = 0;
     uint32_t cm[2] = { (1 << f->blocks) - 1, (1 << f->blocks) - 1 };
@@ -37,9 +37,9 @@ static float pvq_band_cost(CeltPVQ *pvq, CeltFrame *f, OpusRangeCoder *rc, int b
     float buf[176 * 2], lowband_scratch[176], norm1[176], norm2[176];
     float dist, cost, err_x = 0.0f, err_y = 0.0f;
     float *X = buf;
-    float *X_orig = f->block[0].coeffs + (ff_celt_freq_bands[band] << f->size);
+    const float *X_orig = src->block[0].coeffs + (ff_celt_freq_bands[band] << f->size);
     float *Y = (f->channels == 2) ? &buf[176] : NULL;
-    float *Y_orig = f->block[1].coeffs + (ff_celt_freq_bands[band] << f->size);
+    const float *Y_orig = src->block[1].coeffs + (ff_celt_freq_bands[band] << f->size);
     OPUS_RC_CHECKPOINT_SPAWN(rc);
 
     memcpy(X, X_orig, band_size*sizeof(float));
@@ -364,7 +364,8 @@ static void celt_gauge_psy_weight(OpusPsyContext *s, OpusPsyStep **start,
     f_out->framebits = FFALIGN(f_out->framebits, 8);
 }
 
-static int bands_dist(OpusPsyContext *s, CeltFrame *f, float *total_dist)
+static int bands_dist(OpusPsyContext *s, CeltFrame *f, const CeltFrame *src,
+                      float *total_dist)
 {
     int i, tdist = 0.0f;
     OpusRangeCoder dump;
@@ -374,7 +375,7 @@ static int bands_dist(OpusPsyContext *s, CeltFrame *f, float *total_dist)
 
     for (i = 0; i < CELT_MAX_BANDS; i++) {
         float bits = 0.0f;
-        float dist = pvq_band_cost(f->pvq, f, &dump, i, &bits, s->lambda);
+        float dist = pvq_band_cost(f->pvq, f, src, &dump, i, &bits, s->lambda);
         tdist += dist;
     }
 
@@ -383,35 +384,64 @@ static int bands_dist(OpusPsyContext *s, CeltFrame *f, float *total_dist)
     return 0;
 }
 
+/* Each trial runs on a per-thread copy of the frame parameters; the
+ * coefficients are read from the source frame, only the band energies the
+ * quantizer needs are copied */
+static int bands_dist_trial(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    OpusPsyContext *s = arg;
+    const CeltFrame *f = s->trial_src;
+    CeltFrame *t = &s->trials[threadnr];
+
+    for (int ch = 0; ch < f->channels; ch++)
+        memcpy(t->block[ch].lin_energy, f->block[ch].lin_energy,
+               sizeof(f->block[ch].lin_energy));
+    memcpy(&t->channels, &f->channels,
+           sizeof(*f) - offsetof(CeltFrame, channels));
+
+    if (s->trial_dual_stereo)
+        t->dual_stereo = jobnr;
+    else
+        t->intensity_stereo = f->end_band - jobnr;
+
+    return bands_dist(s, t, f, &s->trial_dist[jobnr]);
+}
+
+static void run_dist_trials(OpusPsyContext *s, const CeltFrame *f,
+                            int dual_stereo, int nb_trials)
+{
+    s->trial_src         = f;
+    s->trial_dual_stereo = dual_stereo;
+    s->avctx->execute2(s->avctx, bands_dist_trial, s, NULL, nb_trials);
+}
+
 static void celt_search_for_dual_stereo(OpusPsyContext *s, CeltFrame *f)
 {
-    float td1, td2;
     f->dual_stereo = 0;
 
     if (s->avctx->ch_layout.nb_channels < 2)
         return;
 
-    bands_dist(s, f, &td1);
-    f->dual_stereo = 1;
-    bands_dist(s, f, &td2);
+    run_dist_trials(s, f, 1, 2);
 
-    f->dual_stereo = td2 < td1;
-    s->dual_stereo_used += td2 < td1;
+    f->dual_stereo = s->trial_dist[1] < s->trial_dist[0];
+    s->dual_stereo_used += f->dual_stereo;
 }
 
 static void celt_search_for_intensity(OpusPsyContext *s, CeltFrame *f)
 {
     int i, best_band = CELT_MAX_BANDS - 1;
-    float dist, best_dist = FLT_MAX;
+    float best_dist = FLT_MAX;
     /* TODO: fix, make some heuristic up here using the lambda value */
-    float end_band = 0;
+    int end_band = 0;
 
     if (s->avctx->ch_layout.nb_channels < 2)
         return;
 
+    run_dist_trials(s, f, 0, f->end_band - end_band + 1);
+
     for (i = f->end_band; i >= end_band; i--) {
-        f->intensity_stereo = i;
-        bands_dist(s, f, &dist);
+        float dist = s->trial_dist[f->end_band - i];
         if (best_dist > dist) {
             best_dist = dist;
             best_band = i;
@@ -539,6 +569,17 @@ av_cold int ff_opus_psy_init(OpusPsyContext *s, AVCodecContext *avctx,
         goto fail;
     }
 
+    s->nb_trials = FFMAX(avctx->thread_count, 1);
+    s->trials = av_calloc(s->nb_trials, sizeof(*s->trials));
+    if (!s->trials) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    for (i = 0; i < s->nb_trials; i++) {
+        if ((ret = ff_celt_pvq_init(&s->trials[i].pvq, 1)) < 0)
+            goto fail;
+    }
+
     for (ch = 0; ch < s->avctx->ch_layout.nb_channels; ch++) {
         for (i = 0; i < CELT_MAX_BANDS; i++) {
             bessel_init(&s->bfilter_hi[ch][i], 1.0f, 19.0f, 100.0f, 1);
@@ -576,6 +617,10 @@ fail:
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
 
+    for (i = 0; s->trials && i < s->nb_trials; i++)
+        ff_celt_pvq_uninit(&s->trials[i].pvq);
+    av_freep(&s->trials);
+
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         av_tx_uninit(&s->mdct[i]);
         av_freep(&s->window[i]);
@@ -599,6 +644,10 @@ av_cold int ff_opus_psy_end(OpusPsyContext *s)
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
 
+    for (i = 0; s->trials && i < s->nb_trials; i++)
+        ff_celt_pvq_uninit(&s->trials[i].pvq);
+    av_freep(&s->trials);
+
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         av_tx_uninit(&s->mdct[i]);
         av_freep(&s->window[i]);
@@ -82,6 +82,13 @@ typedef struct OpusPsyContext {
     float lambda;
     int *inflection_points;
     int inflection_points_count;
+
+    /* Band distortion trials, run in parallel with slice threading */
+    CeltFrame *trials; /* one per thread */
+    int nb_trials;
+    const CeltFrame *trial_src;
+    int trial_dual_stereo;
+    float trial_dist[CELT_MAX_BANDS + 1];
 } OpusPsyContext;
 
 int  ff_opus_psy_process           (OpusPsyContext *s, OpusPacketInfo *p);
@@ -218,10 +218,13 @@ struct TrellisNode {
 };
 
 #define MAX_STORED_Q 16
+#define EST_TAB_SIZE 64
 
 typedef struct ProresThreadData {
     DECLARE_ALIGNED(16, int16_t, blocks)[MAX_PLANES][64 * 4 * MAX_MBS_PER_SLICE];
     DECLARE_ALIGNED(16, uint16_t, emu_buf)[16 * 16];
+    DECLARE_ALIGNED(16, uint16_t, levels)[64 * 4 * MAX_MBS_PER_SLICE];
+    uint64_t nz_mask[4 * MAX_MBS_PER_SLICE];
     int16_t custom_q[64];
     int16_t custom_chroma_q[64];
     struct TrellisNode *nodes;
@@ -233,6 +236,9 @@ typedef struct ProresContext {
     DECLARE_ALIGNED(16, uint16_t, emu_buf)[16*16];
     int16_t quants[MAX_STORED_Q][64];
     int16_t quants_chroma[MAX_STORED_Q][64];
+    /* codeword lengths for small runs/levels given the previous ones */
+    uint8_t run_bits[16][EST_TAB_SIZE];
+    uint8_t level_bits[10][EST_TAB_SIZE];
     int16_t custom_q[64];
     int16_t custom_chroma_q[64];
     const uint8_t *quant_mat;
@@ -663,35 +669,58 @@ static int estimate_dcs(int *error, int16_t *blocks, int blocks_per_slice,
     return bits;
 }
 
-static int estimate_acs(int *error, int16_t *blocks, int blocks_per_slice,
-                        const uint8_t *scan, const int16_t *qmat)
+static int estimate_acs(ProresContext *ctx, int *error, int16_t *blocks,
+                        int blocks_per_slice, const int16_t *qmat,
+                        uint16_t *levels, uint64_t *nz_mask)
 {
-    int idx, i;
+    const uint8_t *scan = ctx->scantable;
+    int idx, i, n, pos, last;
     int prev_run = 4;
     int prev_level = 2;
-    int run, level;
-    int max_coeffs, abs_level;
+    int run;
+    int abs_level;
     int bits = 0;
+    unsigned err = 0;
 
-    max_coeffs = blocks_per_slice << 6;
-    run        = 0;
-
+    /* Quantise in coding order, dividing by multiplying with a reciprocal
+     * (exact as long as |coeff| * qmat < 2^31), and record which levels
+     * are nonzero so that only those need to be visited below. */
+    n = 0;
     for (i = 1; i < 64; i++) {
-        for (idx = scan[i]; idx < max_coeffs; idx += 64) {
-            level   = blocks[idx] / qmat[scan[i]];
-            *error += FFABS(blocks[idx]) % qmat[scan[i]];
-            if (level) {
-                abs_level = FFABS(level);
-                bits += estimate_vlc(ff_prores_run_to_cb[prev_run], run);
-                bits += estimate_vlc(ff_prores_level_to_cb[prev_level],
-                                     abs_level - 1) + 1;
-
-                prev_run   = FFMIN(run, 15);
-                prev_level = FFMIN(abs_level, 9);
-                run    = 0;
-            } else {
-                run++;
-            }
+        const unsigned q     = qmat[scan[i]];
+        const uint32_t recip = (1U << 31) / q + 1;
+
+        for (idx = scan[i]; idx < blocks_per_slice << 6; idx += 64, n++) {
+            unsigned a = FFABS(blocks[idx]);
+            unsigned l = (uint64_t)a * recip >> 31;
+            err       += a - l * q;
+            levels[n]  = l;
+            if (!(n & 63))
+                nz_mask[n >> 6] = 0;
+            nz_mask[n >> 6] |= (uint64_t)!!l << (n & 63);
+        }
+    }
+    *error += err;
+
+    last = -1;
+    for (i = 0; i < n; i += 64) {
+        uint64_t mask = nz_mask[i >> 6];
+
+        while (mask) {
+            pos  = i + ff_ctzll(mask);
+            mask &= mask - 1;
+
+            run       = pos - last - 1;
+            abs_level = levels[pos];
+            bits += run < EST_TAB_SIZE ? ctx->run_bits[prev_run][run]
+                  : estimate_vlc(ff_prores_run_to_cb[prev_run], run);
+            bits += abs_level <= EST_TAB_SIZE ? ctx->level_bits[prev_level][abs_level - 1]
+                  : estimate_vlc(ff_prores_level_to_cb[prev_level],
+                                 abs_level - 1) + 1;
+
+            prev_run   = FFMIN(run, 15);
+            prev_level = FFMIN(abs_level, 9);
+            last       = pos;
         }
     }
 
@@ -710,7 +739,8 @@ static int estimate_slice_plane(ProresContext *ctx, int *error, int plane,
     blocks_per_slice = mbs_per_slice * blocks_per_mb;
 
     bits  = estimate_dcs(error, td->blocks[plane], blocks_per_slice, qmat[0]);
-    bits += estimate_acs(error, td->blocks[plane], blocks_per_slice, ctx->scantable, qmat);
+    bits += estimate_acs(ctx, error, td->blocks[plane], blocks_per_slice,
+                         qmat, td->levels, td->nz_mask);
 
     return FFALIGN(bits, 8);
 }
@@ -883,6 +913,10 @@ static int find_slice_quant(AVCodecContext *avctx,
                                          num_cblocks[0],
                                          qmat, td);/* estimate luma plane */
             for (i = 1; i < ctx->num_planes - !!ctx->alpha_bits; i++) { /* estimate chroma plane */
+                // Only the estimate for the quantiser finally picked is
+                // used, so give up on this one as soon as it cannot fit.
+                if (bits > ctx->bits_per_mb * mbs_per_slice && q < 127)
+                    break;
                 bits += estimate_slice_plane(ctx, &error, i,
                                              src, linesize[i],
                                              mbs_per_slice,
@@ -1161,6 +1195,13 @@ static av_cold int encode_init(AVCodecContext *avctx)
                                 : ff_prores_progressive_scan;
     ff_fdctdsp_init(&ctx->fdsp, avctx);
 
+    for (i = 0; i < EST_TAB_SIZE; i++) {
+        for (j = 0; j < FF_ARRAY_ELEMS(ctx->run_bits); j++)
+            ctx->run_bits[j][i]   = estimate_vlc(ff_prores_run_to_cb[j], i);
+        for (j = 0; j < FF_ARRAY_ELEMS(ctx->level_bits); j++)
+            ctx->level_bits[j][i] = estimate_vlc(ff_prores_level_to_cb[j], i) + 1;
+    }
+
     mps = ctx->mbs_per_slice;
     if (mps & (mps - 1)) {
         av_log(avctx, AV_LOG_ERROR,
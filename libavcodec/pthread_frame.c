@@ -149,6 +149,8 @@ typedef struct FrameThreadContext {
 
     int next_decoding;             ///< The next context to submit a packet to.
     int next_finished;             ///< The next context to return output from.
+    int nb_pending;                ///< Number of contexts with output not yet returned.
+    int max_pending;               ///< Maximum number of contexts decoding at once.
 
     /* hwaccel state for thread-unsafe hwaccels is temporarily stored here in
      * order to transfer its ownership to the next decoding thread without the
@@ -576,6 +578,11 @@ int ff_thread_receive_frame(AVCodecContext *avctx, AVFrame *frame)
     while (!fctx->df.nb_f && !fctx->result) {
         PerThreadContext *p;
 
+        /* in low-delay mode, return output as soon as it is available */
+        if (fctx->max_pending < avctx->thread_count && fctx->nb_pending &&
+            atomic_load(&fctx->threads[fctx->next_finished].state) == STATE_INPUT_READY)
+            goto collect;
+
         /* get a packet to be submitted to the next thread */
         av_packet_unref(fctx->next_pkt);
         ret = ff_decode_get_packet(avctx, fctx->next_pkt);
@@ -586,14 +593,17 @@ int ff_thread_receive_frame(AVCodecContext *avctx, AVFrame *frame)
                             fctx->next_pkt);
         if (ret < 0)
              goto finish;
+        fctx->nb_pending++;
 
         /* do not return any frames until all threads have something to do */
-        if (fctx->next_decoding != fctx->next_finished &&
+        if (fctx->nb_pending < fctx->max_pending &&
             !avctx->internal->draining)
             continue;
 
+collect:
         p                   = &fctx->threads[fctx->next_finished];
         fctx->next_finished = (fctx->next_finished + 1) % avctx->thread_count;
+        fctx->nb_pending--;
 
         if (atomic_load(&p->state) != STATE_INPUT_READY) {
             pthread_mutex_lock(&p->progress_mutex);
@@ -956,8 +966,12 @@ int ff_frame_thread_init(AVCodecContext *avctx)
 
     fctx->async_lock = 1;
 
+    fctx->max_pending = thread_count;
+    if (avctx->frame_thread_delay > 0)
+        fctx->max_pending = FFMIN(avctx->frame_thread_delay + 1, thread_count);
+
     if (codec->p.type == AVMEDIA_TYPE_VIDEO)
-        avctx->delay = avctx->thread_count - 1;
+        avctx->delay = fctx->max_pending - 1;
 
     fctx->threads = av_calloc(thread_count, sizeof(*fctx->threads));
     if (!fctx->threads) {
@@ -995,6 +1009,7 @@ void ff_thread_flush(AVCodecContext *avctx)
     }
 
     fctx->next_decoding = fctx->next_finished = 0;
+    fctx->nb_pending = 0;
     fctx->prev_thread = NULL;
 
     decoded_frames_flush(&fctx->df);
@@ -61,27 +61,29 @@ void ff_build_rac_states(RangeCoder *c, int factor, int max_p);
 
 static inline void renorm_encoder(RangeCoder *c)
 {
-    // FIXME: optimize
-    while (c->range < 0x100) {
-        if (c->outstanding_byte < 0) {
-            c->outstanding_byte = c->low >> 8;
-        } else if (c->low <= 0xFF00) {
-            *c->bytestream++ = c->outstanding_byte;
-            for (; c->outstanding_count; c->outstanding_count--)
-                *c->bytestream++ = 0xFF;
-            c->outstanding_byte = c->low >> 8;
-        } else if (c->low >= 0x10000) {
-            *c->bytestream++ = c->outstanding_byte + 1;
-            for (; c->outstanding_count; c->outstanding_count--)
-                *c->bytestream++ = 0x00;
-            c->outstanding_byte = (c->low >> 8) & 0xFF;
-        } else {
-            c->outstanding_count++;
-        }
-
-        c->low     = (c->low & 0xFF) << 8;
-        c->range <<= 8;
+    /* range is never 0, so shifting in a single byte always suffices. */
+    if (c->range >= 0x100)
+        return;
+
+    av_assert2(c->range > 0);
+    if (c->outstanding_byte < 0) {
+        c->outstanding_byte = c->low >> 8;
+    } else if (c->low <= 0xFF00) {
+        *c->bytestream++ = c->outstanding_byte;
+        for (; c->outstanding_count; c->outstanding_count--)
+            *c->bytestream++ = 0xFF;
+        c->outstanding_byte = c->low >> 8;
+    } else if (c->low >= 0x10000) {
+        *c->bytestream++ = c->outstanding_byte + 1;
+        for (; c->outstanding_count; c->outstanding_count--)
+            *c->bytestream++ = 0x00;
+        c->outstanding_byte = (c->low >> 8) & 0xFF;
+    } else {
+        c->outstanding_count++;
     }
+
+    c->low     = (c->low & 0xFF) << 8;
+    c->range <<= 8;
 }
 
 static inline int get_rac_count(RangeCoder *c)
@@ -95,18 +97,15 @@ static inline int get_rac_count(RangeCoder *c)
 static inline void put_rac(RangeCoder *c, uint8_t *const state, int bit)
 {
     int range1 = (c->range * (*state)) >> 8;
+    int range0 = c->range - range1;
 
     av_assert2(*state);
     av_assert2(range1 < c->range);
     av_assert2(range1 > 0);
-    if (!bit) {
-        c->range -= range1;
-        *state    = c->zero_state[*state];
-    } else {
-        c->low  += c->range - range1;
-        c->range = range1;
-        *state   = c->one_state[*state];
-    }
+    /* Select instead of branching, the coded bits are hard to predict. */
+    c->low  += range0 & -!!bit;
+    c->range = bit ? range1 : range0;
+    *state   = (bit ? c->one_state : c->zero_state)[*state];
 
     renorm_encoder(c);
 }
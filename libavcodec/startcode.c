@@ -25,6 +25,7 @@
  * @author Michael Niedermayer <michaelni@gmx.at>
  */
 
+#include "libavutil/attributes.h"
 #include "libavutil/intreadwrite.h"
 #include "startcode.h"
 #include "config.h"
@@ -56,3 +57,12 @@ int ff_startcode_find_candidate_c(const uint8_t *buf, int size)
             break;
     return i;
 }
+
+av_cold void ff_startcode_init(StartCodeContext *c)
+{
+    c->find_candidate = ff_startcode_find_candidate_c;
+
+#if ARCH_X86
+    ff_startcode_init_x86(c);
+#endif
+}
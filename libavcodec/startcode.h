@@ -33,4 +33,16 @@ const uint8_t *avpriv_find_start_code(const uint8_t *p,
 
 int ff_startcode_find_candidate_c(const uint8_t *buf, int size);
 
+typedef struct StartCodeContext {
+    /**
+     * Return the offset of the first zero byte in buf, or size if there
+     * is none. size must be a multiple of 64, nothing past buf + size is
+     * read so the buffer needs no padding.
+     */
+    int (*find_candidate)(const uint8_t *buf, int size);
+} StartCodeContext;
+
+void ff_startcode_init(StartCodeContext *c);
+void ff_startcode_init_x86(StartCodeContext *c);
+
 #endif /* AVCODEC_STARTCODE_H */
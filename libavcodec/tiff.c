@@ -55,6 +55,13 @@
 #include "thread.h"
 #include "get_bits.h"
 
+typedef struct TiffStrip {
+    const uint8_t *src;
+    int size;
+    int start;
+    int ret;
+} TiffStrip;
+
 typedef struct TiffContext {
     AVClass *class;
     AVCodecContext *avctx;
@@ -121,6 +128,12 @@ typedef struct TiffContext {
     uint8_t *yuv_line;
     unsigned int yuv_line_size;
 
+    /* Slice threading */
+    TiffStrip *strip_list;
+    unsigned int strip_list_size;
+    LZWState **slice_lzw;
+    int nb_slice_lzw;
+
     int geotag_count;
     TiffGeoTag *geotags;
 } TiffContext;
@@ -736,9 +749,11 @@ static int dng_decode_jpeg(AVCodecContext *avctx, AVFrame *frame,
     return 0;
 }
 
-static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int stride,
-                             const uint8_t *src, int size, int strip_start, int lines)
+static int tiff_unpack_strip(TiffContext *s, LZWState *lzw, AVFrame *p,
+                             uint8_t *dst, int stride, const uint8_t *src,
+                             int size, int strip_start, int lines)
 {
+    GetByteContext gb;
     PutByteContext pb;
     int c, line, pixels, code, ret;
     const uint8_t *ssrc = src;
@@ -815,12 +830,12 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
         if (size > 1 && !src[0] && (src[1]&1)) {
             av_log(s->avctx, AV_LOG_ERROR, "Old style LZW is unsupported\n");
         }
-        if ((ret = ff_lzw_decode_init(s->lzw, 8, src, size, FF_LZW_TIFF)) < 0) {
+        if ((ret = ff_lzw_decode_init(lzw, 8, src, size, FF_LZW_TIFF)) < 0) {
             av_log(s->avctx, AV_LOG_ERROR, "Error initializing LZW decoder\n");
             return ret;
         }
         for (line = 0; line < lines; line++) {
-            pixels = ff_lzw_decode(s->lzw, dst, width);
+            pixels = ff_lzw_decode(lzw, dst, width);
             if (pixels < width) {
                 av_log(s->avctx, AV_LOG_ERROR, "Decoded only %i bytes of %i\n",
                        pixels, width);
@@ -847,13 +862,14 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
         return tiff_unpack_fax(s, dst, stride, src, size, width, lines);
     }
 
-    bytestream2_init(&s->gb, src, size);
+    bytestream2_init(&gb, src, size);
     bytestream2_init_writer(&pb, dst, is_yuv ? s->yuv_line_size : (stride * lines));
 
     is_dng = (s->tiff_type == TIFF_TYPE_DNG || s->tiff_type == TIFF_TYPE_CINEMADNG);
 
     /* Decode JPEG-encoded DNGs with strips */
     if (s->compr == TIFF_NEWJPEG && is_dng) {
+        s->gb = gb;
         if (s->strips > 1) {
             av_log(s->avctx, AV_LOG_ERROR, "More than one DNG JPEG strips unsupported\n");
             return AVERROR_PATCHWELCOME;
@@ -874,7 +890,7 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
             return AVERROR_INVALIDDATA;
         }
 
-        if (bytestream2_get_bytes_left(&s->gb) == 0 || bytestream2_get_eof(&pb))
+        if (bytestream2_get_bytes_left(&gb) == 0 || bytestream2_get_eof(&pb))
             break;
         bytestream2_seek_p(&pb, stride * line, SEEK_SET);
         switch (s->compr) {
@@ -1921,6 +1937,182 @@ static void camera_xyz_coeff(TiffContext *s,
     }
 }
 
+typedef struct TiffSliceArg {
+    AVFrame *frame;
+    uint8_t *dst;
+    uint8_t *tmpbuf;
+    int stride;
+    int lines;
+    int nb_jobs;
+} TiffSliceArg;
+
+/**
+ * Check whether the strips of the current image can be unpacked
+ * concurrently, i.e. without touching any scratch state shared through
+ * the context.
+ */
+static int tiff_strips_are_independent(const TiffContext *s, const AVFrame *p)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(p->format);
+    int is_yuv = !(desc->flags & AV_PIX_FMT_FLAG_RGB) &&
+                 (desc->flags & AV_PIX_FMT_FLAG_PLANAR) &&
+                 desc->nb_components >= 3;
+
+    if (!(s->avctx->active_thread_type & FF_THREAD_SLICE) ||
+        s->avctx->thread_count <= 1 || s->rps >= s->height)
+        return 0;
+    /* yuv_line, the DNG JPEG decoder and deinvert_buf are per-context */
+    if (is_yuv || p->format == AV_PIX_FMT_GRAY12 ||
+        s->tiff_type == TIFF_TYPE_DNG || s->tiff_type == TIFF_TYPE_CINEMADNG)
+        return 0;
+
+    switch (s->compr) {
+    case TIFF_RAW:
+    case TIFF_PACKBITS:
+        return 1;
+    case TIFF_LZW:
+        return !s->fill_order && s->nb_slice_lzw >= s->avctx->thread_count;
+    case TIFF_DEFLATE:
+    case TIFF_ADOBE_DEFLATE:
+    case TIFF_LZMA:
+        return !s->fill_order;
+    }
+    return 0;
+}
+
+static int unpack_strip_job(AVCodecContext *avctx, void *arg,
+                            int jobnr, int threadnr)
+{
+    TiffContext *s = avctx->priv_data;
+    const TiffSliceArg *a = arg;
+    TiffStrip *strip = &s->strip_list[jobnr];
+
+    strip->ret = tiff_unpack_strip(s, s->slice_lzw[threadnr], a->frame,
+                                   a->dst + strip->start * (ptrdiff_t)a->stride,
+                                   a->stride, strip->src, strip->size,
+                                   strip->start,
+                                   FFMIN(s->rps, s->height - strip->start));
+    return 0;
+}
+
+static void undo_horizontal_predictor(TiffContext *s, uint8_t *dst,
+                                      int stride, int lines)
+{
+    int soff, ssize, i, j;
+
+    soff  = s->bpp >> 3;
+    if (s->planar)
+        soff  = FFMAX(soff / s->bppcount, 1);
+    ssize = s->width * soff;
+    if (s->avctx->pix_fmt == AV_PIX_FMT_RGB48LE ||
+        s->avctx->pix_fmt == AV_PIX_FMT_RGBA64LE ||
+        s->avctx->pix_fmt == AV_PIX_FMT_GRAY16LE ||
+        s->avctx->pix_fmt == AV_PIX_FMT_YA16LE ||
+        s->avctx->pix_fmt == AV_PIX_FMT_GBRP16LE ||
+        s->avctx->pix_fmt == AV_PIX_FMT_GBRAP16LE) {
+        for (i = 0; i < lines; i++) {
+            for (j = soff; j < ssize; j += 2)
+                AV_WL16(dst + j, AV_RL16(dst + j) + AV_RL16(dst + j - soff));
+            dst += stride;
+        }
+    } else if (s->avctx->pix_fmt == AV_PIX_FMT_RGB48BE ||
+               s->avctx->pix_fmt == AV_PIX_FMT_RGBA64BE ||
+               s->avctx->pix_fmt == AV_PIX_FMT_GRAY16BE ||
+               s->avctx->pix_fmt == AV_PIX_FMT_YA16BE ||
+               s->avctx->pix_fmt == AV_PIX_FMT_GBRP16BE ||
+               s->avctx->pix_fmt == AV_PIX_FMT_GBRAP16BE) {
+        for (i = 0; i < lines; i++) {
+            for (j = soff; j < ssize; j += 2)
+                AV_WB16(dst + j, AV_RB16(dst + j) + AV_RB16(dst + j - soff));
+            dst += stride;
+        }
+    } else {
+        for (i = 0; i < lines; i++) {
+            for (j = soff; j < ssize; j++)
+                dst[j] += dst[j - soff];
+            dst += stride;
+        }
+    }
+}
+
+/* Floating point predictor
+   TIFF Technical Note 3 http://chriscox.org/TIFFTN3d1.pdf */
+static void undo_float_predictor(TiffContext *s, uint8_t *dst, int stride,
+                                 int lines, uint8_t *tmpbuf)
+{
+    int channels = s->bppcount;
+    int group_size;
+    int soff, ssize, bpc, i, j;
+
+    soff  = s->bpp >> 3;
+    if (s->planar) {
+        soff  = FFMAX(soff / s->bppcount, 1);
+        channels = 1;
+    }
+    ssize = s->width * soff;
+    bpc = FFMAX(soff / s->bppcount, 1); /* Bytes per component */
+    group_size = s->width * channels;
+
+    if (s->avctx->pix_fmt == AV_PIX_FMT_RGBF32LE ||
+        s->avctx->pix_fmt == AV_PIX_FMT_RGBAF32LE) {
+        for (i = 0; i < lines; i++) {
+            /* Copy first sample byte for each channel */
+            for (j = 0; j < channels; j++)
+                tmpbuf[j] = dst[j];
+
+            /* Decode horizontal differences */
+            for (j = channels; j < ssize; j++)
+                tmpbuf[j] = dst[j] + tmpbuf[j-channels];
+
+            /* Combine shuffled bytes from their separate groups. Each
+               byte of every floating point value in a row of pixels is
+               split and combined into separate groups. A group of all
+               the sign/exponents bytes in the row and groups for each
+               of the upper, mid, and lower mantissa bytes in the row. */
+            for (j = 0; j < group_size; j++) {
+                for (int k = 0; k < bpc; k++) {
+                    dst[bpc * j + k] = tmpbuf[(bpc - k - 1) * group_size + j];
+                }
+            }
+            dst += stride;
+        }
+    } else if (s->avctx->pix_fmt == AV_PIX_FMT_RGBF32BE ||
+               s->avctx->pix_fmt == AV_PIX_FMT_RGBAF32BE) {
+        /* Same as LE only the shuffle at the end is reversed */
+        for (i = 0; i < lines; i++) {
+            for (j = 0; j < channels; j++)
+                tmpbuf[j] = dst[j];
+
+            for (j = channels; j < ssize; j++)
+                tmpbuf[j] = dst[j] + tmpbuf[j-channels];
+
+            for (j = 0; j < group_size; j++) {
+                for (int k = 0; k < bpc; k++) {
+                    dst[bpc * j + k] = tmpbuf[k * group_size + j];
+                }
+            }
+            dst += stride;
+        }
+    }
+}
+
+static int undo_predictor_job(AVCodecContext *avctx, void *arg,
+                              int jobnr, int threadnr)
+{
+    TiffContext *s = avctx->priv_data;
+    const TiffSliceArg *a = arg;
+    int start = (int64_t)a->lines *  jobnr      / a->nb_jobs;
+    int end   = (int64_t)a->lines * (jobnr + 1) / a->nb_jobs;
+    uint8_t *dst = a->dst + start * (ptrdiff_t)a->stride;
+
+    if (s->predictor == 2)
+        undo_horizontal_predictor(s, dst, a->stride, end - start);
+    else
+        undo_float_predictor(s, dst, a->stride, end - start,
+                             a->tmpbuf + jobnr * (ptrdiff_t)(s->width * (s->bpp >> 3)));
+    return 0;
+}
+
 static int decode_frame(AVCodecContext *avctx, AVFrame *p,
                         int *got_frame, AVPacket *avpkt)
 {
@@ -1933,7 +2125,7 @@ static int decode_frame(AVCodecContext *avctx, AVFrame *p,
     GetByteContext stripsizes;
     GetByteContext stripdata;
     int retry_for_subifd, retry_for_page;
-    int is_dng;
+    int is_dng, slice_threads;
     int has_tile_bits, has_strip_bits;
 
     bytestream2_init(&s->gb, avpkt->data, avpkt->size);
@@ -2180,6 +2372,7 @@ again:
 
     /* Handle TIFF images and DNG images with uncompressed strips (non-tiled) */
 
+    slice_threads = tiff_strips_are_independent(s, p);
     planes = s->planar ? s->bppcount : 1;
     for (plane = 0; plane < planes; plane++) {
         uint8_t *five_planes = NULL;
@@ -2195,145 +2388,122 @@ again:
             if (!dst)
                 return AVERROR(ENOMEM);
         }
-        for (i = 0; i < s->height; i += s->rps) {
-            if (i)
-                dst += s->rps * stride;
-            if (s->stripsizesoff)
-                ssize = ff_tget(&stripsizes, s->sstype, le);
-            else
-                ssize = s->stripsize;
-
-            if (s->strippos)
-                soff = ff_tget(&stripdata, s->sot, le);
-            else
-                soff = s->stripoff;
-
-            if (soff > avpkt->size || ssize > avpkt->size - soff || ssize > remaining) {
-                av_log(avctx, AV_LOG_ERROR, "Invalid strip size/offset\n");
+        if (slice_threads) {
+            /* Collect all strips first, then unpack them concurrently. */
+            TiffSliceArg arg = { .frame = p, .dst = dst, .stride = stride };
+            int nb_strips = 0;
+
+            av_fast_malloc(&s->strip_list, &s->strip_list_size,
+                           (s->height / s->rps + 1) * sizeof(*s->strip_list));
+            if (!s->strip_list) {
+                s->strip_list_size = 0;
                 av_freep(&five_planes);
-                return AVERROR_INVALIDDATA;
+                return AVERROR(ENOMEM);
             }
-            remaining -= ssize;
-            if ((ret = tiff_unpack_strip(s, p, dst, stride, avpkt->data + soff, ssize, i,
-                                         FFMIN(s->rps, s->height - i))) < 0) {
-                if (avctx->err_recognition & AV_EF_EXPLODE) {
+            for (i = 0; i < s->height; i += s->rps) {
+                if (s->stripsizesoff)
+                    ssize = ff_tget(&stripsizes, s->sstype, le);
+                else
+                    ssize = s->stripsize;
+
+                if (s->strippos)
+                    soff = ff_tget(&stripdata, s->sot, le);
+                else
+                    soff = s->stripoff;
+
+                if (soff > avpkt->size || ssize > avpkt->size - soff || ssize > remaining) {
+                    av_log(avctx, AV_LOG_ERROR, "Invalid strip size/offset\n");
                     av_freep(&five_planes);
-                    return ret;
+                    return AVERROR_INVALIDDATA;
                 }
-                break;
+                remaining -= ssize;
+                s->strip_list[nb_strips++] = (TiffStrip){
+                    .src   = avpkt->data + soff,
+                    .size  = ssize,
+                    .start = i,
+                };
             }
-        }
-        decoded_height = FFMIN(i, s->height);
 
-        if (s->predictor == 2) {
-            if (s->photometric == TIFF_PHOTOMETRIC_YCBCR) {
-                av_log(s->avctx, AV_LOG_ERROR, "predictor == 2 with YUV is unsupported");
-                return AVERROR_PATCHWELCOME;
-            }
-            dst   = five_planes ? five_planes : p->data[plane];
-            soff  = s->bpp >> 3;
-            if (s->planar)
-                soff  = FFMAX(soff / s->bppcount, 1);
-            ssize = s->width * soff;
-            if (s->avctx->pix_fmt == AV_PIX_FMT_RGB48LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_RGBA64LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_GRAY16LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_YA16LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_GBRP16LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_GBRAP16LE) {
-                for (i = 0; i < decoded_height; i++) {
-                    for (j = soff; j < ssize; j += 2)
-                        AV_WL16(dst + j, AV_RL16(dst + j) + AV_RL16(dst + j - soff));
-                    dst += stride;
+            avctx->execute2(avctx, unpack_strip_job, &arg, NULL, nb_strips);
+
+            for (j = 0; j < nb_strips; j++) {
+                if ((ret = s->strip_list[j].ret) < 0) {
+                    if (avctx->err_recognition & AV_EF_EXPLODE) {
+                        av_freep(&five_planes);
+                        return ret;
+                    }
+                    i = s->strip_list[j].start;
+                    break;
                 }
-            } else if (s->avctx->pix_fmt == AV_PIX_FMT_RGB48BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_RGBA64BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_GRAY16BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_YA16BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_GBRP16BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_GBRAP16BE) {
-                for (i = 0; i < decoded_height; i++) {
-                    for (j = soff; j < ssize; j += 2)
-                        AV_WB16(dst + j, AV_RB16(dst + j) + AV_RB16(dst + j - soff));
-                    dst += stride;
+            }
+        } else {
+            for (i = 0; i < s->height; i += s->rps) {
+                if (i)
+                    dst += s->rps * stride;
+                if (s->stripsizesoff)
+                    ssize = ff_tget(&stripsizes, s->sstype, le);
+                else
+                    ssize = s->stripsize;
+
+                if (s->strippos)
+                    soff = ff_tget(&stripdata, s->sot, le);
+                else
+                    soff = s->stripoff;
+
+                if (soff > avpkt->size || ssize > avpkt->size - soff || ssize > remaining) {
+                    av_log(avctx, AV_LOG_ERROR, "Invalid strip size/offset\n");
+                    av_freep(&five_planes);
+                    return AVERROR_INVALIDDATA;
                 }
-            } else {
-                for (i = 0; i < decoded_height; i++) {
-                    for (j = soff; j < ssize; j++)
-                        dst[j] += dst[j - soff];
-                    dst += stride;
+                remaining -= ssize;
+                if ((ret = tiff_unpack_strip(s, s->lzw, p, dst, stride,
+                                             avpkt->data + soff, ssize, i,
+                                             FFMIN(s->rps, s->height - i))) < 0) {
+                    if (avctx->err_recognition & AV_EF_EXPLODE) {
+                        av_freep(&five_planes);
+                        return ret;
+                    }
+                    break;
                 }
             }
         }
+        decoded_height = FFMIN(i, s->height);
 
-        /* Floating point predictor
-           TIFF Technical Note 3 http://chriscox.org/TIFFTN3d1.pdf */
-        if (s->predictor == 3) {
-            int channels = s->bppcount;
-            int group_size;
-            uint8_t *tmpbuf;
-            int bpc;
+        if (s->predictor == 2 || s->predictor == 3) {
+            TiffSliceArg arg = {
+                .dst     = five_planes ? five_planes : p->data[plane],
+                .stride  = stride,
+                .lines   = decoded_height,
+                .nb_jobs = 1,
+            };
 
-            dst   = five_planes ? five_planes : p->data[plane];
-            soff  = s->bpp >> 3;
-            if (s->planar) {
-                soff  = FFMAX(soff / s->bppcount, 1);
-                channels = 1;
+            if (s->predictor == 2 && s->photometric == TIFF_PHOTOMETRIC_YCBCR) {
+                av_log(s->avctx, AV_LOG_ERROR, "predictor == 2 with YUV is unsupported");
+                return AVERROR_PATCHWELCOME;
             }
-            ssize = s->width * soff;
-            bpc = FFMAX(soff / s->bppcount, 1); /* Bytes per component */
-            group_size = s->width * channels;
-
-            tmpbuf = av_malloc(ssize);
-            if (!tmpbuf) {
-                av_free(five_planes);
-                return AVERROR(ENOMEM);
+            if (s->predictor == 3 &&
+                s->avctx->pix_fmt != AV_PIX_FMT_RGBF32LE &&
+                s->avctx->pix_fmt != AV_PIX_FMT_RGBAF32LE &&
+                s->avctx->pix_fmt != AV_PIX_FMT_RGBF32BE &&
+                s->avctx->pix_fmt != AV_PIX_FMT_RGBAF32BE) {
+                av_log(s->avctx, AV_LOG_ERROR, "unsupported floating point pixel format\n");
+                arg.lines = 0;
             }
 
-            if (s->avctx->pix_fmt == AV_PIX_FMT_RGBF32LE ||
-                s->avctx->pix_fmt == AV_PIX_FMT_RGBAF32LE) {
-                for (i = 0; i < decoded_height; i++) {
-                    /* Copy first sample byte for each channel */
-                    for (j = 0; j < channels; j++)
-                        tmpbuf[j] = dst[j];
-
-                    /* Decode horizontal differences */
-                    for (j = channels; j < ssize; j++)
-                        tmpbuf[j] = dst[j] + tmpbuf[j-channels];
-
-                    /* Combine shuffled bytes from their separate groups. Each
-                       byte of every floating point value in a row of pixels is
-                       split and combined into separate groups. A group of all
-                       the sign/exponents bytes in the row and groups for each
-                       of the upper, mid, and lower mantissa bytes in the row. */
-                    for (j = 0; j < group_size; j++) {
-                        for (int k = 0; k < bpc; k++) {
-                            dst[bpc * j + k] = tmpbuf[(bpc - k - 1) * group_size + j];
-                        }
-                    }
-                    dst += stride;
-                }
-            } else if (s->avctx->pix_fmt == AV_PIX_FMT_RGBF32BE ||
-                       s->avctx->pix_fmt == AV_PIX_FMT_RGBAF32BE) {
-                /* Same as LE only the shuffle at the end is reversed */
-                for (i = 0; i < decoded_height; i++) {
-                    for (j = 0; j < channels; j++)
-                        tmpbuf[j] = dst[j];
-
-                    for (j = channels; j < ssize; j++)
-                        tmpbuf[j] = dst[j] + tmpbuf[j-channels];
-
-                    for (j = 0; j < group_size; j++) {
-                        for (int k = 0; k < bpc; k++) {
-                            dst[bpc * j + k] = tmpbuf[k * group_size + j];
-                        }
-                    }
-                    dst += stride;
+            /* Rows are independent, so split them evenly among the threads. */
+            if (avctx->active_thread_type & FF_THREAD_SLICE)
+                arg.nb_jobs = av_clip(arg.lines, 1, avctx->thread_count);
+
+            if (s->predictor == 3 && arg.lines) {
+                arg.tmpbuf = av_malloc_array(arg.nb_jobs, s->width * (s->bpp >> 3));
+                if (!arg.tmpbuf) {
+                    av_free(five_planes);
+                    return AVERROR(ENOMEM);
                 }
-            } else {
-                av_log(s->avctx, AV_LOG_ERROR, "unsupported floating point pixel format\n");
             }
-            av_free(tmpbuf);
+            if (arg.lines)
+                avctx->execute2(avctx, undo_predictor_job, &arg, NULL, arg.nb_jobs);
+            av_free(arg.tmpbuf);
         }
 
         if (s->photometric == TIFF_PHOTOMETRIC_WHITE_IS_ZERO) {
@@ -2422,6 +2592,17 @@ static av_cold int tiff_init(AVCodecContext *avctx)
         return AVERROR(ENOMEM);
     ff_ccitt_unpack_init();
 
+    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        s->slice_lzw = av_calloc(avctx->thread_count, sizeof(*s->slice_lzw));
+        if (!s->slice_lzw)
+            return AVERROR(ENOMEM);
+        for (; s->nb_slice_lzw < avctx->thread_count; s->nb_slice_lzw++) {
+            ff_lzw_decode_open(&s->slice_lzw[s->nb_slice_lzw]);
+            if (!s->slice_lzw[s->nb_slice_lzw])
+                return AVERROR(ENOMEM);
+        }
+    }
+
     /* Allocate JPEG frame */
     s->jpgframe = av_frame_alloc();
     s->jpkt     = av_packet_alloc();
@@ -2454,6 +2635,12 @@ static av_cold int tiff_end(AVCodecContext *avctx)
     free_geotags(s);
 
     ff_lzw_decode_close(&s->lzw);
+    for (int i = 0; i < s->nb_slice_lzw; i++)
+        ff_lzw_decode_close(&s->slice_lzw[i]);
+    av_freep(&s->slice_lzw);
+    s->nb_slice_lzw = 0;
+    av_freep(&s->strip_list);
+    s->strip_list_size = 0;
     av_freep(&s->deinvert_buf);
     s->deinvert_buf_size = 0;
     av_freep(&s->yuv_line);
@@ -2488,7 +2675,8 @@ const FFCodec ff_tiff_decoder = {
     .init           = tiff_init,
     .close          = tiff_end,
     FF_CODEC_DECODE_CB(decode_frame),
-    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS,
+    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_ICC_PROFILES |
                       FF_CODEC_CAP_SKIP_FRAME_FILL_PARAM,
     .p.priv_class   = &tiff_decoder_class,
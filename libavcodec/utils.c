@@ -33,6 +33,7 @@
 #include "libavutil/pixdesc.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/pixfmt.h"
+#include "libavutil/thread.h"
 #include "avcodec.h"
 #include "codec.h"
 #include "codec_desc.h"
@@ -934,6 +935,14 @@ void ff_thread_report_progress2(AVCodecContext *avctx, int field, int thread, in
 
 #endif
 
+static StartCodeContext startcode_ctx;
+static AVOnce startcode_init_once = AV_ONCE_INIT;
+
+static av_cold void startcode_init(void)
+{
+    ff_startcode_init(&startcode_ctx);
+}
+
 const uint8_t *avpriv_find_start_code(const uint8_t *restrict p,
                                       const uint8_t *end,
                                       uint32_t *restrict state)
@@ -952,6 +961,24 @@ const uint8_t *avpriv_find_start_code(const uint8_t *restrict p,
     }
 
     while (p < end) {
+#if HAVE_FAST_UNALIGNED && HAVE_FAST_64BIT
+        /* A start code ending in p[-1..6] needs a zero in p[-2..5];
+         * skip 8 bytes at a time while there is none. */
+        while (p + 6 <= end) {
+            uint64_t x = AV_RN64(p - 2);
+            if ((x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL)
+                break;
+            p += 8;
+            /* In long runs without zero bytes hand over to the SIMD search;
+             * it only gets whole 64 byte blocks so it never reads past end. */
+            if (end - p >= 256) {
+                ff_thread_once(&startcode_init_once, startcode_init);
+                p += startcode_ctx.find_candidate(p - 2, FFMIN(end - p + 2, INT_MAX) & ~63);
+            }
+        }
+        if (p >= end)
+            break;
+#endif
         if      (p[-1] > 1      ) p += 3;
         else if (p[-2]          ) p += 2;
         else if (p[-3]|(p[-1]-1)) p++;
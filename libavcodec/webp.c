@@ -704,6 +704,25 @@ static int decode_entropy_coded_image(WebPContext *s, enum ImageRole role,
             ref_x = FFMAX(0, ref_x);
             ref_y = FFMAX(0, ref_y);
 
+            if (x + length <= width && ref_x + length <= width) {
+                /* neither region wraps, copy along the rows */
+                uint8_t *p_ref = GET_PIXEL(img->frame, ref_x, ref_y);
+                uint8_t *p     = GET_PIXEL(img->frame,     x,     y);
+
+                for (i = 0; i < length; i++)
+                    AV_COPY32(p + 4 * i, p_ref + 4 * i);
+                if (img->color_cache_bits) {
+                    for (i = 0; i < length; i++)
+                        color_cache_put(img, AV_RB32(p + 4 * i));
+                }
+                x += length;
+                if (x == width) {
+                    x = 0;
+                    y++;
+                }
+                continue;
+            }
+
             /* copy pixels
              * source and dest regions can overlap and wrap lines, so just
              * copy per-pixel */
@@ -921,32 +940,83 @@ static void inverse_prediction(AVFrame *frame, enum PredictionMode m, int x, int
     dec[3] += p[3];
 }
 
-static int apply_predictor_transform(WebPContext *s)
+/* Apply one predictor to a run of w pixels that all have their top-right
+ * neighbour in the previous row, so the mode is looked up and dispatched
+ * once per run and the predictor is inlined into the loop. */
+#define DEFINE_INV_PREDICT_ROW(n)                                           \
+static void inv_predict_row_ ## n(uint8_t *p, const uint8_t *p_t, int w)    \
+{                                                                           \
+    for (int x = 0; x < w; x++, p += 4, p_t += 4) {                         \
+        uint8_t pred[4];                                                    \
+                                                                            \
+        inv_predict_ ## n(pred, p - 4, p_t - 4, p_t, p_t + 4);              \
+        p[0] += pred[0];                                                    \
+        p[1] += pred[1];                                                    \
+        p[2] += pred[2];                                                    \
+        p[3] += pred[3];                                                    \
+    }                                                                       \
+}
+
+DEFINE_INV_PREDICT_ROW(0)
+DEFINE_INV_PREDICT_ROW(1)
+DEFINE_INV_PREDICT_ROW(2)
+DEFINE_INV_PREDICT_ROW(3)
+DEFINE_INV_PREDICT_ROW(4)
+DEFINE_INV_PREDICT_ROW(5)
+DEFINE_INV_PREDICT_ROW(6)
+DEFINE_INV_PREDICT_ROW(7)
+DEFINE_INV_PREDICT_ROW(8)
+DEFINE_INV_PREDICT_ROW(9)
+DEFINE_INV_PREDICT_ROW(10)
+DEFINE_INV_PREDICT_ROW(11)
+DEFINE_INV_PREDICT_ROW(12)
+DEFINE_INV_PREDICT_ROW(13)
+
+typedef void (*inv_predict_row_func)(uint8_t *p, const uint8_t *p_t, int w);
+
+static const inv_predict_row_func inverse_predict_row[14] = {
+    inv_predict_row_0,  inv_predict_row_1,  inv_predict_row_2,
+    inv_predict_row_3,  inv_predict_row_4,  inv_predict_row_5,
+    inv_predict_row_6,  inv_predict_row_7,  inv_predict_row_8,
+    inv_predict_row_9,  inv_predict_row_10, inv_predict_row_11,
+    inv_predict_row_12, inv_predict_row_13,
+};
+
+static int apply_predictor_transform(WebPContext *s, int y, int width)
 {
     ImageContext *img  = &s->image[IMAGE_ROLE_ARGB];
     ImageContext *pimg = &s->image[IMAGE_ROLE_PREDICTOR];
-    int x, y;
+    AVFrame *frame     = img->frame;
+    int bits           = pimg->size_reduction;
+    const uint8_t *modes = GET_PIXEL(pimg->frame, 0, y >> bits) + 2;
+    uint8_t *row       = GET_PIXEL(frame, 0, y);
+    const uint8_t *top = row - frame->linesize[0];
+    /* the top-right neighbour of the last pixel wraps to the current row */
+    int end = width == frame->width ? width - 1 : width;
+    int x, n;
+
+    if (y == 0) {
+        inverse_prediction(frame, PRED_MODE_BLACK, 0, 0);
+        for (x = 1; x < width; x++)
+            inverse_prediction(frame, PRED_MODE_L, x, 0);
+        return 0;
+    }
 
-    for (y = 0; y < img->frame->height; y++) {
-        for (x = 0; x < s->reduced_width; x++) {
-            int tx = x >> pimg->size_reduction;
-            int ty = y >> pimg->size_reduction;
-            enum PredictionMode m = GET_PIXEL_COMP(pimg->frame, tx, ty, 2);
-
-            if (x == 0) {
-                if (y == 0)
-                    m = PRED_MODE_BLACK;
-                else
-                    m = PRED_MODE_T;
-            } else if (y == 0)
-                m = PRED_MODE_L;
-
-            if (m > 13) {
-                av_log(s->avctx, AV_LOG_ERROR,
-                       "invalid predictor mode: %d\n", m);
-                return AVERROR_INVALIDDATA;
-            }
-            inverse_prediction(img->frame, m, x, y);
+    inverse_prediction(frame, PRED_MODE_T, 0, y);
+    for (x = 1; x < width; x += n) {
+        enum PredictionMode m = modes[4 * (x >> bits)];
+
+        if (m > 13) {
+            av_log(s->avctx, AV_LOG_ERROR,
+                   "invalid predictor mode: %d\n", m);
+            return AVERROR_INVALIDDATA;
+        }
+        n = FFMIN(((x >> bits) + 1) << bits, width) - x;
+        if (x + n > end) {
+            inverse_predict_row[m](row + 4 * x, top + 4 * x, end - x);
+            inverse_prediction(frame, m, end, y);
+        } else {
+            inverse_predict_row[m](row + 4 * x, top + 4 * x, n);
         }
     }
     return 0;
@@ -958,114 +1028,59 @@ static av_always_inline uint8_t color_transform_delta(uint8_t color_pred,
     return (int)ff_u8_to_s8(color_pred) * ff_u8_to_s8(color) >> 5;
 }
 
-static int apply_color_transform(WebPContext *s)
+static int apply_color_transform(WebPContext *s, int y, int width)
 {
-    ImageContext *img, *cimg;
-    int x, y, cx, cy;
-    uint8_t *p, *cp;
+    ImageContext *img  = &s->image[IMAGE_ROLE_ARGB];
+    ImageContext *cimg = &s->image[IMAGE_ROLE_COLOR_TRANSFORM];
+    int bits           = cimg->size_reduction;
+    const uint8_t *cp  = GET_PIXEL(cimg->frame, 0, y >> bits);
+    uint8_t *p         = GET_PIXEL(img->frame,  0, y);
 
-    img  = &s->image[IMAGE_ROLE_ARGB];
-    cimg = &s->image[IMAGE_ROLE_COLOR_TRANSFORM];
+    for (int x = 0; x < width; x++, p += 4) {
+        const uint8_t *c = cp + 4 * (x >> bits);
 
-    for (y = 0; y < img->frame->height; y++) {
-        for (x = 0; x < s->reduced_width; x++) {
-            cx = x >> cimg->size_reduction;
-            cy = y >> cimg->size_reduction;
-            cp = GET_PIXEL(cimg->frame, cx, cy);
-            p  = GET_PIXEL(img->frame,   x,  y);
-
-            p[1] += color_transform_delta(cp[3], p[2]);
-            p[3] += color_transform_delta(cp[2], p[2]) +
-                    color_transform_delta(cp[1], p[1]);
-        }
+        p[1] += color_transform_delta(c[3], p[2]);
+        p[3] += color_transform_delta(c[2], p[2]) +
+                color_transform_delta(c[1], p[1]);
     }
     return 0;
 }
 
-static int apply_subtract_green_transform(WebPContext *s)
+static int apply_subtract_green_transform(WebPContext *s, int y, int width)
 {
-    int x, y;
-    ImageContext *img = &s->image[IMAGE_ROLE_ARGB];
+    uint8_t *p = GET_PIXEL(s->image[IMAGE_ROLE_ARGB].frame, 0, y);
 
-    for (y = 0; y < img->frame->height; y++) {
-        for (x = 0; x < s->reduced_width; x++) {
-            uint8_t *p = GET_PIXEL(img->frame, x, y);
-            p[1] += p[2];
-            p[3] += p[2];
-        }
+    for (int x = 0; x < width; x++, p += 4) {
+        p[1] += p[2];
+        p[3] += p[2];
     }
     return 0;
 }
 
-static int apply_color_indexing_transform(WebPContext *s)
+static int apply_color_indexing_transform(WebPContext *s, int y,
+                                          const uint8_t *palette)
 {
-    ImageContext *img;
-    ImageContext *pal;
-    int i, x, y;
-    uint8_t *p;
-
-    img = &s->image[IMAGE_ROLE_ARGB];
-    pal = &s->image[IMAGE_ROLE_COLOR_INDEXING];
-
-    if (pal->size_reduction > 0) { // undo pixel packing
-        GetBitContext gb_g;
-        uint8_t *line;
-        int pixel_bits = 8 >> pal->size_reduction;
-
-        line = av_malloc(img->frame->linesize[0] + AV_INPUT_BUFFER_PADDING_SIZE);
-        if (!line)
-            return AVERROR(ENOMEM);
-
-        for (y = 0; y < img->frame->height; y++) {
-            p = GET_PIXEL(img->frame, 0, y);
-            memcpy(line, p, img->frame->linesize[0]);
-            init_get_bits(&gb_g, line, img->frame->linesize[0] * 8);
-            skip_bits(&gb_g, 16);
-            i = 0;
-            for (x = 0; x < img->frame->width; x++) {
-                p    = GET_PIXEL(img->frame, x, y);
-                p[2] = get_bits(&gb_g, pixel_bits);
-                i++;
-                if (i == 1 << pal->size_reduction) {
-                    skip_bits(&gb_g, 24);
-                    i = 0;
-                }
-            }
-        }
-        av_free(line);
-        s->reduced_width = s->width; // we are back to full size
-    }
-
-    // switch to local palette if it's worth initializing it
-    if (img->frame->height * img->frame->width > 300) {
-        uint8_t palette[256 * 4];
-        const int size = pal->frame->width * 4;
-        av_assert0(size <= 1024U);
-        memcpy(palette, GET_PIXEL(pal->frame, 0, 0), size);   // copy palette
-        // set extra entries to transparent black
-        memset(palette + size, 0, 256 * 4 - size);
-        for (y = 0; y < img->frame->height; y++) {
-            for (x = 0; x < img->frame->width; x++) {
-                p = GET_PIXEL(img->frame, x, y);
-                i = p[2];
-                AV_COPY32(p, &palette[i * 4]);
-            }
+    ImageContext *img = &s->image[IMAGE_ROLE_ARGB];
+    ImageContext *pal = &s->image[IMAGE_ROLE_COLOR_INDEXING];
+    uint8_t *p        = GET_PIXEL(img->frame, 0, y);
+    int x;
+
+    if (pal->size_reduction > 0) {
+        /* Undo pixel packing. Going right to left, every packed pixel is
+         * read before the unpacked pixels overwrite it. */
+        int bits       = pal->size_reduction;
+        int pixel_bits = 8 >> bits;
+        int mask       = (1 << pixel_bits) - 1;
+
+        for (x = img->frame->width - 1; x >= 0; x--) {
+            int g = p[4 * (x >> bits) + 2];
+            int i = g >> ((x & ((1 << bits) - 1)) * pixel_bits) & mask;
+            AV_COPY32(p + 4 * x, &palette[i * 4]);
         }
     } else {
-        for (y = 0; y < img->frame->height; y++) {
-            for (x = 0; x < img->frame->width; x++) {
-                p = GET_PIXEL(img->frame, x, y);
-                i = p[2];
-                if (i >= pal->frame->width) {
-                    AV_WB32(p, 0x00000000);
-                } else {
-                    const uint8_t *pi = GET_PIXEL(pal->frame, i, 0);
-                    AV_COPY32(p, pi);
-                }
-            }
-        }
+        for (x = 0; x < img->frame->width; x++, p += 4)
+            AV_COPY32(p, &palette[p[2] * 4]);
     }
-
     return 0;
 }
 
@@ -1089,7 +1104,7 @@ static int vp8_lossless_decode_frame(AVCodecContext *avctx, AVFrame *p,
                                      unsigned int data_size, int is_alpha_chunk)
 {
     WebPContext *s = avctx->priv_data;
-    int w, h, ret, i, used;
+    int w, h, ret, i, y, used, width;
 
     if (!is_alpha_chunk) {
         s->lossless = 1;
@@ -1166,23 +1181,55 @@ static int vp8_lossless_decode_frame(AVCodecContext *avctx, AVFrame *p,
         goto free_and_return;
 
     /* apply transformations */
-    for (i = s->nb_transforms - 1; i >= 0; i--) {
-        switch (s->transforms[i]) {
-        case PREDICTOR_TRANSFORM:
-            ret = apply_predictor_transform(s);
-            break;
-        case COLOR_TRANSFORM:
-            ret = apply_color_transform(s);
-            break;
-        case SUBTRACT_GREEN:
-            ret = apply_subtract_green_transform(s);
-            break;
-        case COLOR_INDEXING_TRANSFORM:
-            ret = apply_color_indexing_transform(s);
-            break;
+    if (s->nb_transforms) {
+        uint8_t palette[256 * 4];
+        int widths[4];
+
+        /* Transforms applied before color indexing work on the packed
+         * pixels, the remaining ones on the full width. */
+        width = s->reduced_width;
+        for (i = s->nb_transforms - 1; i >= 0; i--) {
+            widths[i] = width;
+            if (s->transforms[i] == COLOR_INDEXING_TRANSFORM) {
+                const ImageContext *pal = &s->image[IMAGE_ROLE_COLOR_INDEXING];
+                const int size = pal->frame->width * 4;
+
+                av_assert0(size <= 1024U);
+                memcpy(palette, GET_PIXEL(pal->frame, 0, 0), size);
+                // set extra entries to transparent black
+                memset(palette + size, 0, 256 * 4 - size);
+                width = s->width;
+            }
+        }
+
+        /* Run the transforms as a wavefront over the rows, each one a row
+         * behind the previous one. This keeps the rows in cache, while the
+         * predictor still sees the row above as left by the transforms
+         * before it and not yet touched by the ones after it. */
+        for (y = 0; y < h + s->nb_transforms - 1; y++) {
+            for (i = s->nb_transforms - 1; i >= 0; i--) {
+                int row = y - (s->nb_transforms - 1 - i);
+
+                if (row < 0 || row >= h)
+                    continue;
+                switch (s->transforms[i]) {
+                case PREDICTOR_TRANSFORM:
+                    ret = apply_predictor_transform(s, row, widths[i]);
+                    break;
+                case COLOR_TRANSFORM:
+                    ret = apply_color_transform(s, row, widths[i]);
+                    break;
+                case SUBTRACT_GREEN:
+                    ret = apply_subtract_green_transform(s, row, widths[i]);
+                    break;
+                case COLOR_INDEXING_TRANSFORM:
+                    ret = apply_color_indexing_transform(s, row, palette);
+                    break;
+                }
+                if (ret < 0)
+                    goto free_and_return;
+            }
         }
-        if (ret < 0)
-            goto free_and_return;
     }
 
     *got_frame   = 1;
@@ -278,6 +278,53 @@ INIT_XMM ssse3
 %define ABS_SUM_8x8 ABS_SUM_8x8_64
 HADAMARD8_DIFF 9
 
+%if HAVE_AVX2_EXTERNAL && ARCH_X86_64
+; %1 = dst, %2 = tmp, %3 = pix1 address, %4 = pix2 address
+%macro DIFF_PIXELS_16 4
+    pmovzxbw        %1, %3
+    pmovzxbw        %2, %4
+    psubw           %1, %2
+%endmacro
+
+; Each row of 16 pixels is widened into one ymm register, so the left and
+; right 8x8 blocks are transformed in parallel, one per 128-bit lane.
+INIT_YMM avx2
+cglobal hadamard8_diff16, 5, 8, 10, v, pix1, pix2, stride, h, stride3, tmp, sum
+    lea       stride3q, [strideq*3]
+    xor           sumd, sumd
+    shr              hd, 4          ; like the C version, only h == 16 does
+    inc              hd             ; a second row of 8x8 blocks
+.loop:
+    DIFF_PIXELS_16  m0, m8, [pix1q],           [pix2q]
+    DIFF_PIXELS_16  m1, m8, [pix1q+strideq],   [pix2q+strideq]
+    DIFF_PIXELS_16  m2, m8, [pix1q+strideq*2], [pix2q+strideq*2]
+    DIFF_PIXELS_16  m3, m8, [pix1q+stride3q],  [pix2q+stride3q]
+    lea           pix1q, [pix1q+strideq*4]
+    lea           pix2q, [pix2q+strideq*4]
+    DIFF_PIXELS_16  m4, m8, [pix1q],           [pix2q]
+    DIFF_PIXELS_16  m5, m8, [pix1q+strideq],   [pix2q+strideq]
+    DIFF_PIXELS_16  m6, m8, [pix1q+strideq*2], [pix2q+strideq*2]
+    DIFF_PIXELS_16  m7, m8, [pix1q+stride3q],  [pix2q+stride3q]
+    lea           pix1q, [pix1q+strideq*4]
+    lea           pix2q, [pix2q+strideq*4]
+    HADAMARD8
+    TRANSPOSE8x8W    0, 1, 2, 3, 4, 5, 6, 7, 8
+    HADAMARD8
+    ABS_SUM_8x8_64   0
+    ; each 8x8 sum saturates on its own, as in the 128-bit version
+    vextracti128    xm1, m0, 1
+    HSUM            xm0, xm2, tmpd
+    and            tmpd, 0xFFFF
+    add            sumd, tmpd
+    HSUM            xm1, xm2, tmpd
+    and            tmpd, 0xFFFF
+    add            sumd, tmpd
+    dec              hd
+    jg .loop
+    mov             eax, sumd
+    RET
+%endif
+
 ; int ff_sse*_*(MpegEncContext *v, const uint8_t *pix1, const uint8_t *pix2,
 ;               ptrdiff_t line_size, int h)
 
@@ -356,6 +403,31 @@ SUM_SQUARED_ERRORS 16
 INIT_XMM sse2
 SUM_SQUARED_ERRORS 16
 
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+cglobal sse16, 5,5,5, v, pix1, pix2, lsize, h
+    pxor      m4, m4
+.next2lines:
+    pmovzxbw  m0, [pix1q]
+    pmovzxbw  m1, [pix2q]
+    pmovzxbw  m2, [pix1q+lsizeq]
+    pmovzxbw  m3, [pix2q+lsizeq]
+    psubw     m0, m1
+    psubw     m2, m3
+    pmaddwd   m0, m0
+    pmaddwd   m2, m2
+    paddd     m4, m0
+    paddd     m4, m2
+    lea    pix1q, [pix1q + 2*lsizeq]
+    lea    pix2q, [pix2q + 2*lsizeq]
+    sub       hd, 2
+    jg .next2lines
+
+    HADDD     m4, m0
+    movd     eax, xm4
+    RET
+%endif
+
 ;-----------------------------------------------
 ;int ff_sum_abs_dctelem(const int16_t *block)
 ;-----------------------------------------------
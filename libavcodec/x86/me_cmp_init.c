@@ -38,6 +38,8 @@ int ff_sse16_mmx(MpegEncContext *v, const uint8_t *pix1, const uint8_t *pix2,
                  ptrdiff_t stride, int h);
 int ff_sse16_sse2(MpegEncContext *v, const uint8_t *pix1, const uint8_t *pix2,
                   ptrdiff_t stride, int h);
+int ff_sse16_avx2(MpegEncContext *v, const uint8_t *pix1, const uint8_t *pix2,
+                  ptrdiff_t stride, int h);
 int ff_hf_noise8_mmx(const uint8_t *pix1, ptrdiff_t stride, int h);
 int ff_hf_noise16_mmx(const uint8_t *pix1, ptrdiff_t stride, int h);
 int ff_sad8_mmxext(MpegEncContext *v, const uint8_t *pix1, const uint8_t *pix2,
@@ -86,6 +88,8 @@ int ff_vsad16_approx_sse2(MpegEncContext *v, const uint8_t *pix1, const uint8_t
 hadamard_func(mmxext)
 hadamard_func(sse2)
 hadamard_func(ssse3)
+int ff_hadamard8_diff16_avx2(MpegEncContext *s, const uint8_t *src1,
+                             const uint8_t *src2, ptrdiff_t stride, int h);
 
 #if HAVE_X86ASM
 static int nsse16_mmx(MpegEncContext *c, const uint8_t *pix1, const uint8_t *pix2,
@@ -305,6 +309,13 @@ av_cold void ff_me_cmp_init_x86(MECmpContext *c, AVCodecContext *avctx)
 #if HAVE_ALIGNED_STACK
         c->hadamard8_diff[0] = ff_hadamard8_diff16_ssse3;
         c->hadamard8_diff[1] = ff_hadamard8_diff_ssse3;
+#endif
+    }
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        c->sse[0] = ff_sse16_avx2;
+#if ARCH_X86_64
+        c->hadamard8_diff[0] = ff_hadamard8_diff16_avx2;
 #endif
     }
 }
@@ -0,0 +1,80 @@
+;******************************************************************************
+;* SIMD-optimized start code candidate search
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;-----------------------------------------------------------------------------
+; int ff_startcode_find_candidate(const uint8_t *buf, int size)
+;
+; Returns the offset of the first zero byte in buf, or size if there is none.
+; Each iteration loads 2 * mmsize bytes, so this may read up to
+; 2 * mmsize - 1 bytes past the end of the buffer (63 bytes for AVX2). The
+; H.264 and VC-1 parsers scan parser input, which is padded by
+; AV_INPUT_BUFFER_PADDING_SIZE (64) bytes, so that stays within the padding.
+; avpriv_find_start_code() only passes sizes that are a multiple of 64, for
+; which nothing past buf + size is read.
+;-----------------------------------------------------------------------------
+%macro STARTCODE_FIND_CANDIDATE 0
+cglobal startcode_find_candidate, 2, 4, 4, buf, size, idx, mask
+    movsxdifnidn sizeq, sized
+    xor          idxq, idxq
+    test         sizeq, sizeq
+    jle .end
+    pxor         m0, m0
+.loop:
+    movu         m1, [bufq + idxq]
+    movu         m2, [bufq + idxq + mmsize]
+    pcmpeqb      m1, m0
+    pcmpeqb      m2, m0
+    por          m3, m1, m2
+    pmovmskb  maskd, m3
+    test      maskd, maskd
+    jnz .found
+    add          idxq, 2 * mmsize
+    cmp          idxq, sizeq
+    jl .loop
+    mov          idxq, sizeq
+    jmp .end
+.found:
+    pmovmskb  maskd, m1
+    test      maskd, maskd
+    jnz .found_first
+    pmovmskb  maskd, m2
+    add          idxq, mmsize
+.found_first:
+    bsf       maskd, maskd
+    add          idxq, maskq
+    cmp          idxq, sizeq
+    jle .end
+    mov          idxq, sizeq
+.end:
+    mov          eax, idxd
+    RET
+%endmacro
+
+INIT_XMM sse2
+STARTCODE_FIND_CANDIDATE
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+STARTCODE_FIND_CANDIDATE
+%endif
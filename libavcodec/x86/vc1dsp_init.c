@@ -30,6 +30,7 @@
 #include "libavutil/x86/asm.h"
 #include "libavcodec/vc1dsp.h"
 #include "fpel.h"
+#include "startcode.h"
 #include "vc1dsp.h"
 #include "config.h"
 
@@ -139,6 +140,8 @@ av_cold void ff_vc1dsp_init_x86(VC1DSPContext *dsp)
     if (EXTERNAL_SSE2(cpu_flags)) {
         ASSIGN_LF816(sse2);
 
+        dsp->startcode_find_candidate            = ff_startcode_find_candidate_sse2;
+
         dsp->put_vc1_mspel_pixels_tab[0][0]      = put_vc1_mspel_mc00_16_sse2;
         dsp->avg_vc1_mspel_pixels_tab[0][0]      = avg_vc1_mspel_mc00_16_sse2;
     }
@@ -152,5 +155,8 @@ av_cold void ff_vc1dsp_init_x86(VC1DSPContext *dsp)
         dsp->vc1_h_loop_filter8  = ff_vc1_h_loop_filter8_sse4;
         dsp->vc1_h_loop_filter16 = vc1_h_loop_filter16_sse4;
     }
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        dsp->startcode_find_candidate = ff_startcode_find_candidate_avx2;
+    }
 #endif /* HAVE_X86ASM */
 }
@@ -844,6 +844,21 @@ int ffurl_get_short_seek(void *urlcontext)
     return h->prot->url_get_short_seek(h);
 }
 
+int ffurl_map_range(URLContext *h, int64_t pos, int size, int padding,
+                    AVBufferRef **buf)
+{
+    if (!h || !h->prot || !h->prot->url_map_range)
+        return AVERROR(ENOSYS);
+    return h->prot->url_map_range(h, pos, size, padding, buf);
+}
+
+int64_t ffurl_insert_space(URLContext *h, int64_t offset, int64_t size)
+{
+    if (!h || !h->prot || !h->prot->url_insert_space)
+        return AVERROR(ENOSYS);
+    return h->prot->url_insert_space(h, offset, size);
+}
+
 int ffurl_shutdown(URLContext *h, int flags)
 {
     if (!h || !h->prot || !h->prot->url_shutdown)
@@ -21,6 +21,7 @@
 
 #include "avio.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/log.h"
 
 extern const AVClass ff_avio_class;
@@ -214,6 +215,20 @@ unsigned long ff_crcA001_update(unsigned long checksum, const uint8_t *buf,
  */
 int ffio_open_dyn_packet_buf(AVIOContext **s, int max_packet_size);
 
+/**
+ * Read size bytes without copying them, if the protocol under s can map
+ * them into memory. Small reads are never mapped as copying them is cheaper.
+ *
+ * @param padding number of zeroed bytes following the data in *buf
+ * @param buf     set to a new reference covering the data and its padding
+ *                on success
+ * @param data    set to the start of the data, i.e. (*buf)->data
+ * @return size on success, 0 if the data can not be referenced in place
+ *         and must be read normally, or a negative AVERROR code
+ */
+int ffio_read_mapped(AVIOContext *s, int size, int padding,
+                     AVBufferRef **buf, uint8_t **data);
+
 /**
  * Return the URLContext associated with the AVIOContext
  *
@@ -20,6 +20,7 @@
  */
 
 #include "libavutil/bprint.h"
+#include "libavutil/buffer.h"
 #include "libavutil/crc.h"
 #include "libavutil/dict.h"
 #include "libavutil/intreadwrite.h"
@@ -31,6 +32,7 @@
 #include "avio.h"
 #include "avio_internal.h"
 #include "internal.h"
+#include "url.h"
 #include <stdarg.h>
 
 #define IO_BUFFER_SIZE 32768
@@ -202,7 +204,13 @@ void avio_write(AVIOContext *s, const unsigned char *buf, int size)
 {
     if (size <= 0)
         return;
-    if (s->direct && !s->update_checksum) {
+    /* Payloads at least as large as the buffer gain nothing from being
+     * copied into it first; pass them on as a single write to the protocol
+     * instead, unless the writes must not exceed max_packet_size. User
+     * supplied callbacks keep getting at most buffer_size bytes per call. */
+    if ((s->direct || (size >= s->buffer_size && !s->max_packet_size &&
+                       s->write_packet == ffurl_write2)) &&
+        !s->update_checksum) {
         avio_flush(s);
         writeout(s, buf, size);
         return;
@@ -681,6 +689,45 @@ int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size, const unsig
     }
 }
 
+/* mapping a range costs a few system calls and a page copy for the
+ * padding, which is only worth it for large reads */
+#define MAPPED_READ_MIN_SIZE (64 << 10)
+
+int ffio_read_mapped(AVIOContext *s, int size, int padding,
+                     AVBufferRef **buf, uint8_t **data)
+{
+    FFIOContext *const ctx = ffiocontext(s);
+    int64_t pos = avio_tell(s), ret;
+
+    if (s->write_flag || s->update_checksum || size < MAPPED_READ_MIN_SIZE ||
+        pos < 0)
+        return 0;
+
+    ret = ffurl_map_range(ffio_geturlcontext(s), pos, size, padding, buf);
+    if (ret == AVERROR(ENOSYS))
+        return 0;
+    if (ret < 0)
+        return ret;
+    *data = (*buf)->data;
+
+    if (size <= s->buf_end - s->buf_ptr) {
+        s->buf_ptr += size;
+    } else {
+        /* drop the buffer and continue after the data, seeking in the
+         * mapping is free */
+        ret = s->seek(s->opaque, pos + size, SEEK_SET);
+        if (ret < 0) {
+            av_buffer_unref(buf);
+            return ret;
+        }
+        s->buf_end = s->buf_ptr = s->buf_ptr_max = s->buffer;
+        s->pos = pos + size;
+        ctx->bytes_read += size;
+        s->bytes_read = ctx->bytes_read;
+    }
+    return size;
+}
+
 int avio_read_partial(AVIOContext *s, unsigned char *buf, int size)
 {
     int len;
@@ -991,7 +1038,8 @@ void ffio_write_lines(AVIOContext *s, const unsigned char *buf, int size,
 int ffio_copy_url_options(AVIOContext* pb, AVDictionary** avio_opts)
 {
     const char *opts[] = {
-        "headers", "user_agent", "cookies", "http_proxy", "referer", "rw_timeout", "icy", NULL };
+        "headers", "user_agent", "cookies", "http_proxy", "referer", "rw_timeout", "icy",
+        "connection_pool", "pool_idle_timeout", "pool_max_per_host", NULL };
     const char **opt = opts;
     uint8_t *buf = NULL;
     int ret = 0;
@@ -19,9 +19,12 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#define _GNU_SOURCE     /* Needed for fallocate() with glibc */
+
 #include "config_components.h"
 
 #include "libavutil/avstring.h"
+#include "libavutil/buffer.h"
 #include "libavutil/file_open.h"
 #include "libavutil/internal.h"
 #include "libavutil/mem.h"
@@ -31,6 +34,9 @@
 #include <dirent.h>
 #endif
 #include <fcntl.h>
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #if HAVE_IO_H
 #include <io.h>
 #endif
@@ -96,6 +102,9 @@ typedef struct FileContext {
     int blocksize;
     int follow;
     int seekable;
+    int use_mmap;
+    AVBufferRef *map;
+    int64_t map_pos;
 #if HAVE_DIRENT_H
     DIR *dir;
 #endif
@@ -106,6 +115,9 @@ static const AVOption file_options[] = {
     { "blocksize", "set I/O operation maximum block size", offsetof(FileContext, blocksize), AV_OPT_TYPE_INT, { .i64 = INT_MAX }, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
     { "follow", "Follow a file as it is being written", offsetof(FileContext, follow), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { "seekable", "Sets if the file is seekable", offsetof(FileContext, seekable), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, 0, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+#if HAVE_MMAP
+    { "mmap", "Map the file into memory and let packets reference it in place", offsetof(FileContext, use_mmap), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
+#endif
     { NULL }
 };
 
@@ -141,6 +153,14 @@ static int file_read(URLContext *h, unsigned char *buf, int size)
     FileContext *c = h->priv_data;
     int ret;
     size = FFMIN(size, c->blocksize);
+    if (c->map) {
+        if (c->map_pos >= c->map->size)
+            return AVERROR_EOF;
+        size = FFMIN(size, c->map->size - c->map_pos);
+        memcpy(buf, c->map->data + c->map_pos, size);
+        c->map_pos += size;
+        return size;
+    }
     ret = read(c->fd, buf, size);
     if (ret == 0 && c->follow)
         return AVERROR(EAGAIN);
@@ -221,7 +241,10 @@ static int fd_dup(URLContext *h, int oldfd)
 static int file_close(URLContext *h)
 {
     FileContext *c = h->priv_data;
-    int ret = close(c->fd);
+    int ret;
+
+    av_buffer_unref(&c->map);
+    ret = close(c->fd);
     return (ret == -1) ? AVERROR(errno) : 0;
 }
 
@@ -237,6 +260,18 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
         return ret < 0 ? AVERROR(errno) : (S_ISFIFO(st.st_mode) ? 0 : st.st_size);
     }
 
+    if (c->map) {
+        if (whence == SEEK_CUR)
+            pos += c->map_pos;
+        else if (whence == SEEK_END)
+            pos += c->map->size;
+        else if (whence != SEEK_SET)
+            return AVERROR(EINVAL);
+        if (pos < 0)
+            return AVERROR(EINVAL);
+        return c->map_pos = pos;
+    }
+
     ret = lseek(c->fd, pos, whence);
 
     return ret < 0 ? AVERROR(errno) : ret;
@@ -244,6 +279,76 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
 
 #if CONFIG_FILE_PROTOCOL
 
+#if HAVE_MMAP
+static void file_unmap(void *opaque, uint8_t *data)
+{
+    munmap(data, (uintptr_t)opaque);
+}
+
+static void file_unmap_range(void *opaque, uint8_t *data)
+{
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    munmap(data - ((uintptr_t)data & (page - 1)), (uintptr_t)opaque);
+}
+#endif
+
+static int file_map_range(URLContext *h, int64_t pos, int size, int padding,
+                          AVBufferRef **buf)
+{
+#if HAVE_MMAP
+    FileContext *c = h->priv_data;
+    int64_t page = sysconf(_SC_PAGESIZE);
+    int64_t offset = pos & ~(page - 1);
+    size_t len;
+    uint8_t *map;
+
+    if (!c->map || page <= 0 || pos < 0 ||
+        pos > (int64_t)c->map->size - size - padding)
+        return AVERROR(ENOSYS);
+
+    /* A private mapping of its own lets the packet get zeroed padding like
+     * any other packet; only the page holding the padding is copied. */
+    len = pos - offset + size + padding;
+    map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, c->fd, offset);
+    if (map == MAP_FAILED)
+        return AVERROR(ENOSYS);
+    map += pos - offset;
+    memset(map + size, 0, padding);
+
+    *buf = av_buffer_create(map, size + padding, file_unmap_range,
+                            (void *)(uintptr_t)len, 0);
+    if (!*buf) {
+        munmap(map - (pos - offset), len);
+        return AVERROR(ENOMEM);
+    }
+    return 0;
+#else
+    return AVERROR(ENOSYS);
+#endif
+}
+
+static int64_t file_insert_space(URLContext *h, int64_t offset, int64_t size)
+{
+#if HAVE_FALLOCATE && defined(FALLOC_FL_INSERT_RANGE)
+    FileContext *c = h->priv_data;
+    struct stat st;
+    int64_t blocksize;
+
+    if (c->map || fstat(c->fd, &st) < 0 || !S_ISREG(st.st_mode))
+        return AVERROR(ENOSYS);
+    /* the range must be aligned to the filesystem block size */
+    blocksize = st.st_blksize > 0 ? st.st_blksize : 4096;
+    if (offset % blocksize)
+        return AVERROR(EINVAL);
+    size = (size + blocksize - 1) / blocksize * blocksize;
+    if (fallocate(c->fd, FALLOC_FL_INSERT_RANGE, offset, size) < 0)
+        return AVERROR(errno);
+    return size;
+#else
+    return AVERROR(ENOSYS);
+#endif
+}
+
 static int file_delete(URLContext *h)
 {
 #if HAVE_UNISTD_H
@@ -318,6 +423,26 @@ static int file_open(URLContext *h, const char *filename, int flags)
     if (c->seekable >= 0)
         h->is_streamed = !c->seekable;
 
+#if HAVE_MMAP
+    if (c->use_mmap && !c->follow && !(flags & AVIO_FLAG_WRITE) &&
+        !fstat(fd, &st) && S_ISREG(st.st_mode) &&
+        st.st_size > 0 && (uint64_t)st.st_size <= SIZE_MAX) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            c->map = av_buffer_create(map, st.st_size, file_unmap,
+                                      (void *)(uintptr_t)st.st_size,
+                                      AV_BUFFER_FLAG_READONLY);
+            if (!c->map) {
+                munmap(map, st.st_size);
+                close(fd);
+                return AVERROR(ENOMEM);
+            }
+        } else {
+            av_log(h, AV_LOG_VERBOSE, "Could not map the file, reading it instead\n");
+        }
+    }
+#endif
+
     return 0;
 }
 
@@ -413,6 +538,8 @@ const URLProtocol ff_file_protocol = {
     .url_seek            = file_seek,
     .url_close           = file_close,
     .url_get_file_handle = file_get_handle,
+    .url_map_range       = file_map_range,
+    .url_insert_space    = file_insert_space,
     .url_check           = file_check,
     .url_delete          = file_delete,
     .url_move            = file_move,
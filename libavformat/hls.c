@@ -46,6 +46,7 @@
 #include "id3v2.h"
 #include "url.h"
 
+#include "hls_prefetch.h"
 #include "hls_sample_encryption.h"
 
 #define INITIAL_BUFFER_SIZE 32768
@@ -107,6 +108,7 @@ struct playlist {
     int input_read_done;
     AVIOContext *input_next;
     int input_next_requested;
+    HLSPrefetchSegment *prefetch_seg; /* used instead of input if prefetched */
     AVFormatContext *parent;
     int index;
     AVFormatContext *ctx;
@@ -228,6 +230,11 @@ typedef struct HLSContext {
     int http_multiple;
     int http_seekable;
     int seg_max_retry;
+    int prefetch_segments;
+    int prefetch_threads;
+    int64_t prefetch_max_size;
+    int64_t prefetch_split_size;
+    HLSPrefetch *prefetch;
     AVIOContext *playlist_pb;
     HLSCryptoContext  crypto_ctx;
 } HLSContext;
@@ -261,6 +268,14 @@ static void free_init_section_list(struct playlist *pls)
     pls->n_init_sections = 0;
 }
 
+static void flush_prefetch(HLSContext *c, struct playlist *pls)
+{
+    if (!c->prefetch)
+        return;
+    ff_hls_prefetch_release(c->prefetch, &pls->prefetch_seg);
+    ff_hls_prefetch_flush(c->prefetch, pls);
+}
+
 static void free_playlist_list(HLSContext *c)
 {
     int i;
@@ -280,6 +295,7 @@ static void free_playlist_list(HLSContext *c)
         pls->input_read_done = 0;
         ff_format_io_close(c->ctx, &pls->input_next);
         pls->input_next_requested = 0;
+        flush_prefetch(c, pls);
         if (pls->ctx) {
             pls->ctx->pb = NULL;
             avformat_close_input(&pls->ctx);
@@ -644,13 +660,10 @@ static int open_url_keepalive(AVFormatContext *s, AVIOContext **pb,
 #endif
 }
 
-static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
-                    AVDictionary **opts, AVDictionary *opts2, int *is_http_out)
+static int check_url(AVFormatContext *s, const char *url, int *is_http_out)
 {
     HLSContext *c = s->priv_data;
-    AVDictionary *tmp = NULL;
     const char *proto_name = NULL;
-    int ret;
     int is_http = 0;
 
     if (av_strstart(url, "crypto", NULL)) {
@@ -692,6 +705,21 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
     else if (strcmp(proto_name, "file") || !strncmp(url, "file,", 5))
         return AVERROR_INVALIDDATA;
 
+    *is_http_out = is_http;
+    return 0;
+}
+
+static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
+                    AVDictionary **opts, AVDictionary *opts2, int *is_http_out)
+{
+    HLSContext *c = s->priv_data;
+    AVDictionary *tmp = NULL;
+    int ret;
+    int is_http;
+
+    if ((ret = check_url(s, url, &is_http)) < 0)
+        return ret;
+
     av_dict_copy(&tmp, *opts, 0);
     av_dict_copy(&tmp, opts2, 0);
 
@@ -719,8 +747,12 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
         if (!(s->flags & AVFMT_FLAG_CUSTOM_IO))
             av_opt_get(*pb, "cookies", AV_OPT_SEARCH_CHILDREN, (uint8_t**)&new_cookies);
 
-        if (new_cookies)
+        if (new_cookies) {
+            // the download threads send the cookies of the demuxer as well
+            if (c->prefetch)
+                ff_hls_prefetch_set_cookies(c->prefetch, new_cookies);
             av_dict_set(opts, "cookies", new_cookies, AV_DICT_DONT_STRDUP_VAL);
+        }
     }
 
     av_dict_free(&tmp);
@@ -1072,7 +1104,12 @@ static int read_from_url(struct playlist *pls, struct segment *seg,
     if (seg->size >= 0)
         buf_size = FFMIN(buf_size, seg->size - pls->cur_seg_offset);
 
-    ret = avio_read(pls->input, buf, buf_size);
+    if (pls->prefetch_seg) {
+        HLSContext *c = pls->parent->priv_data;
+        ret = ff_hls_prefetch_read(c->prefetch, pls->prefetch_seg, buf, buf_size);
+    } else {
+        ret = avio_read(pls->input, buf, buf_size);
+    }
     if (ret > 0)
         pls->cur_seg_offset += ret;
 
@@ -1473,6 +1510,24 @@ static int playlist_needed(struct playlist *pls)
     return 0;
 }
 
+static void queue_prefetch(HLSContext *c, struct playlist *pls)
+{
+    int64_t last = FFMIN(pls->cur_seq_no + c->prefetch_segments,
+                         pls->start_seq_no + pls->n_segments - 1);
+    int is_http;
+
+    for (int64_t seq_no = pls->cur_seq_no + 1; seq_no <= last; seq_no++) {
+        struct segment *seg = pls->segments[seq_no - pls->start_seq_no];
+
+        /* encrypted segments need their key, open them as usual */
+        if (seg->key_type != KEY_NONE ||
+            check_url(pls->parent, seg->url, &is_http) < 0 ||
+            ff_hls_prefetch_add(c->prefetch, pls, seq_no, seg->url,
+                                seg->url_offset, seg->size) < 0)
+            break;
+    }
+}
+
 static int read_data(void *opaque, uint8_t *buf, int buf_size)
 {
     struct playlist *v = opaque;
@@ -1487,7 +1542,8 @@ restart:
     if (!v->needed)
         return AVERROR_EOF;
 
-    if (!v->input || (c->http_persistent && v->input_read_done)) {
+    if (!v->prefetch_seg &&
+        (!v->input || (c->http_persistent && v->input_read_done))) {
         int64_t reload_interval;
 
         /* Check that the playlist is still needed before opening a new
@@ -1550,7 +1606,6 @@ reload:
             goto reload;
         }
 
-        v->input_read_done = 0;
         seg = current_segment(v);
 
         /* load/update Media Initialization Section, if any */
@@ -1558,12 +1613,18 @@ reload:
         if (ret)
             return ret;
 
-        if (c->http_multiple == 1 && v->input_next_requested) {
+        if (c->prefetch &&
+            (v->prefetch_seg = ff_hls_prefetch_get(c->prefetch, v, v->cur_seq_no))) {
+            v->cur_seg_offset = 0;
+            ret = 0;
+        } else if (c->http_multiple == 1 && v->input_next_requested) {
+            v->input_read_done = 0;
             FFSWAP(AVIOContext *, v->input, v->input_next);
             v->cur_seg_offset = 0;
             v->input_next_requested = 0;
             ret = 0;
         } else {
+            v->input_read_done = 0;
             ret = open_input(c, v, seg, &v->input);
         }
         if (ret < 0) {
@@ -1611,6 +1672,9 @@ reload:
         }
     }
 
+    if (c->prefetch && just_opened)
+        queue_prefetch(c, v);
+
     if (v->init_sec_buf_read_offset < v->init_sec_data_len) {
         /* Push init section out first before first actual segment */
         int copy_size = FFMIN(v->init_sec_data_len - v->init_sec_buf_read_offset, buf_size);
@@ -1630,7 +1694,9 @@ reload:
 
         return ret;
     }
-    if (c->http_persistent &&
+    if (v->prefetch_seg) {
+        ff_hls_prefetch_release(c->prefetch, &v->prefetch_seg);
+    } else if (c->http_persistent &&
         seg->key_type == KEY_NONE && av_strstart(seg->url, "http", NULL)) {
         v->input_read_done = 1;
     } else {
@@ -1917,6 +1983,7 @@ static int hls_close(AVFormatContext *s)
     free_playlist_list(c);
     free_variant_list(c);
     free_rendition_list(c);
+    ff_hls_prefetch_uninit(&c->prefetch);
 
     if (c->crypto_ctx.aes_ctx)
         av_free(c->crypto_ctx.aes_ctx);
@@ -1948,6 +2015,20 @@ static int hls_read_header(AVFormatContext *s)
        the range header */
     av_dict_set_int(&c->avio_opts, "seekable", c->http_seekable, 0);
 
+    if (c->prefetch_segments > 0) {
+        ret = ff_hls_prefetch_init(&c->prefetch, s, c->prefetch_threads,
+                                   c->prefetch_max_size, c->prefetch_split_size,
+                                   c->avio_opts);
+        if (ret == AVERROR(ENOSYS)) {
+            av_log(s, AV_LOG_WARNING, "Segment prefetching requires threads\n");
+        } else if (ret < 0) {
+            return ret;
+        } else {
+            /* the next segment is prefetched by the download threads */
+            c->http_multiple = 0;
+        }
+    }
+
     if ((ret = parse_playlist(c, s->url, NULL, s->pb)) < 0)
         return ret;
 
@@ -2085,6 +2166,7 @@ static int hls_read_header(AVFormatContext *s)
             ff_format_io_close(pls->parent, &pls->input_next);
             pls->input_next = NULL;
             pls->input_next_requested = 0;
+            flush_prefetch(c, pls);
             pls->cur_seg_offset = 0;
             pls->cur_init_section = NULL;
             /* Reset EOF flag */
@@ -2242,6 +2324,7 @@ static int recheck_discard_flags(AVFormatContext *s, int first)
             pls->input_read_done = 0;
             ff_format_io_close(pls->parent, &pls->input_next);
             pls->input_next_requested = 0;
+            flush_prefetch(c, pls);
             pls->needed = 0;
             changed = 1;
             av_log(s, AV_LOG_INFO, "No longer receiving playlist %d\n", i);
@@ -2498,6 +2581,7 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
         pls->input_read_done = 0;
         ff_format_io_close(pls->parent, &pls->input_next);
         pls->input_next_requested = 0;
+        flush_prefetch(c, pls);
         av_packet_unref(pls->pkt);
         pb->eof_reached = 0;
         /* Clear any buffered data */
@@ -2590,6 +2674,14 @@ static const AVOption hls_options[] = {
         OFFSET(seg_format_opts), AV_OPT_TYPE_DICT, {.str = NULL}, 0, 0, FLAGS},
     {"seg_max_retry", "Maximum number of times to reload a segment on error.",
      OFFSET(seg_max_retry), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, FLAGS},
+    {"prefetch_segments", "Number of segments to download ahead in background threads",
+        OFFSET(prefetch_segments), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, FLAGS},
+    {"prefetch_threads", "Number of threads and connections for prefetching segments",
+        OFFSET(prefetch_threads), AV_OPT_TYPE_INT, {.i64 = 4}, 1, 64, FLAGS},
+    {"prefetch_max_size", "Maximum memory used for prefetched segments",
+        OFFSET(prefetch_max_size), AV_OPT_TYPE_INT64, {.i64 = 64 << 20}, 0, INT64_MAX, FLAGS},
+    {"prefetch_split_size", "Download larger segments as parallel byte ranges of this size, 0 = disable",
+        OFFSET(prefetch_split_size), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, FLAGS},
     {NULL}
 };
 
@@ -0,0 +1,704 @@
+/*
+ * Apple HTTP Live Streaming segment prefetching
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Download HLS segments ahead of the demuxer with a pool of threads.
+ *
+ * Each thread keeps a persistent HTTP connection and downloads one byte
+ * range of a segment at a time into memory. Segments that are being read
+ * are downloaded first; others are only started while the memory limit
+ * is not reached. The reader can consume a segment while it is still
+ * being downloaded.
+ */
+
+#include "config.h"
+#include "config_components.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/error.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/thread.h"
+#include "avio_internal.h"
+#include "hls_prefetch.h"
+#include "http.h"
+#include "url.h"
+
+#define PREFETCH_READ_SIZE (64 * 1024)
+
+typedef struct PrefetchPart {
+    int64_t start;      ///< offset of the part in the segment
+    int64_t end;        ///< end of the part, -1 if the segment size is unknown
+    int64_t filled;     ///< bytes downloaded so far
+    int started;
+} PrefetchPart;
+
+struct HLSPrefetchSegment {
+    const void *owner;
+    int64_t seq_no;
+    char *url;
+    int64_t url_offset;
+    int64_t size;       ///< -1 until known
+
+    uint8_t *data;
+    size_t data_size;   ///< allocated size of data
+
+    /* parts are contiguous and sorted by offset */
+    PrefetchPart *parts;
+    int nb_parts;
+    int nb_running;     ///< parts being downloaded
+
+    int opened;
+    int error;
+    int claimed;        ///< returned by ff_hls_prefetch_get()
+    atomic_int released;
+    int64_t read_pos;
+};
+
+typedef struct PrefetchWorker {
+    HLSPrefetch *pf;
+#if HAVE_THREADS
+    pthread_t thread;
+#endif
+    AVIOInterruptCB interrupt_callback;
+    HLSPrefetchSegment *seg;    ///< segment being downloaded
+    AVIOContext *conn;          ///< kept alive HTTP connection
+    char *conn_url;             ///< last URL requested on conn
+    unsigned cookies_gen;       ///< cookies_gen of the pool applied to conn
+} PrefetchWorker;
+
+struct HLSPrefetch {
+    AVFormatContext *s;
+    AVDictionary *opts;     ///< protected by mutex, cookies may be updated
+    unsigned cookies_gen;   ///< incremented when the cookies are updated
+    int64_t max_size;
+    int64_t split_size;
+    int64_t used;       ///< memory allocated for segments
+
+    HLSPrefetchSegment **segs;
+    int nb_segs;
+
+    PrefetchWorker *workers;
+    int nb_workers;
+
+    AVMutex mutex;
+    AVCond cond_worker;
+    AVCond cond_reader;
+    atomic_int abort;
+};
+
+static void free_segment(HLSPrefetch *pf, HLSPrefetchSegment *seg)
+{
+    pf->used -= seg->data_size;
+    av_freep(&seg->data);
+    av_freep(&seg->parts);
+    av_freep(&seg->url);
+    av_free(seg);
+}
+
+/* Remove seg from the queue; it is freed once no thread downloads it. */
+static void drop_segment(HLSPrefetch *pf, HLSPrefetchSegment *seg)
+{
+    for (int i = 0; i < pf->nb_segs; i++) {
+        if (pf->segs[i] == seg) {
+            memmove(pf->segs + i, pf->segs + i + 1,
+                    (pf->nb_segs - i - 1) * sizeof(*pf->segs));
+            pf->nb_segs--;
+            break;
+        }
+    }
+    atomic_store(&seg->released, 1);
+    if (!seg->nb_running)
+        free_segment(pf, seg);
+    ff_cond_broadcast(&pf->cond_worker);
+}
+
+static void set_segment_size(HLSPrefetch *pf, HLSPrefetchSegment *seg,
+                             int64_t size, int split)
+{
+    int64_t nb_parts = 1;
+
+    if (split && pf->split_size > 0 && size > pf->split_size)
+        nb_parts = (size + pf->split_size - 1) / pf->split_size;
+    if (nb_parts > 1 && nb_parts <= INT_MAX) {
+        PrefetchPart *parts = av_realloc_array(seg->parts, nb_parts, sizeof(*parts));
+        if (parts) {
+            seg->parts = parts;
+            for (int i = 1; i < nb_parts; i++)
+                parts[i] = (PrefetchPart) {
+                    .start = i * pf->split_size,
+                    .end   = FFMIN((i + 1) * pf->split_size, size),
+                };
+        } else {
+            nb_parts = 1;
+        }
+    } else {
+        nb_parts = 1;
+    }
+    seg->parts[0].end = nb_parts > 1 ? pf->split_size : size;
+    seg->nb_parts = nb_parts;
+    seg->size = size;
+}
+
+static int alloc_segment_data(HLSPrefetch *pf, HLSPrefetchSegment *seg)
+{
+    seg->data = av_malloc(FFMAX(seg->size, 1));
+    if (!seg->data)
+        return AVERROR(ENOMEM);
+    seg->data_size = FFMAX(seg->size, 1);
+    pf->used += seg->data_size;
+    return 0;
+}
+
+/* Return the segment with the next part to download, claimed ones first. */
+static HLSPrefetchSegment *next_part(HLSPrefetch *pf, int *idx)
+{
+    for (int claimed = 1; claimed >= 0; claimed--) {
+        if (!claimed && pf->used >= pf->max_size)
+            break;
+        for (int i = 0; i < pf->nb_segs; i++) {
+            HLSPrefetchSegment *seg = pf->segs[i];
+            if (seg->claimed != claimed || seg->error)
+                continue;
+            for (int j = 0; j < seg->nb_parts; j++) {
+                if (!seg->parts[j].started) {
+                    *idx = j;
+                    return seg;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+static int prefetch_interrupt_cb(void *opaque)
+{
+    PrefetchWorker *w = opaque;
+    HLSPrefetch *pf = w->pf;
+
+    return atomic_load(&pf->abort) ||
+           (w->seg && atomic_load(&w->seg->released)) ||
+           ff_check_interrupt(&pf->s->interrupt_callback);
+}
+
+static int same_host(const char *url1, const char *url2)
+{
+    char proto1[10], proto2[10], host1[1024], host2[1024];
+    int port1, port2;
+
+    av_url_split(proto1, sizeof(proto1), NULL, 0, host1, sizeof(host1),
+                 &port1, NULL, 0, url1);
+    av_url_split(proto2, sizeof(proto2), NULL, 0, host2, sizeof(host2),
+                 &port2, NULL, 0, url2);
+    return !strcmp(proto1, proto2) && !strcmp(host1, host2) && port1 == port2;
+}
+
+static void set_range(AVDictionary **opts, const HLSPrefetchSegment *seg,
+                      int64_t start, int64_t end)
+{
+    av_dict_set_int(opts, "offset", seg->url_offset + start, 0);
+    av_dict_set_int(opts, "end_offset", end >= 0 ? seg->url_offset + end : 0, 0);
+}
+
+/* Must be called with the mutex locked. Returns 1 if the cookies changed. */
+static int set_cookies(HLSPrefetch *pf, const char *cookies)
+{
+    const AVDictionaryEntry *e = av_dict_get(pf->opts, "cookies", NULL, 0);
+    int ret;
+
+    if (e && !strcmp(e->value, cookies))
+        return 0;
+    ret = av_dict_set(&pf->opts, "cookies", cookies, 0);
+    if (ret < 0)
+        return ret;
+    pf->cookies_gen++;
+    return 1;
+}
+
+/* Pass the cookies set by a response on to the other connections. */
+static void share_cookies(PrefetchWorker *w, AVIOContext *pb)
+{
+    HLSPrefetch *pf = w->pf;
+    uint8_t *cookies = NULL;
+
+    if (av_opt_get(pb, "cookies", AV_OPT_SEARCH_CHILDREN, &cookies) < 0 || !cookies)
+        return;
+
+    ff_mutex_lock(&pf->mutex);
+    /* this connection is up to date if it was before its own update */
+    if (w->cookies_gen == pf->cookies_gen && set_cookies(pf, cookies) > 0)
+        w->cookies_gen = pf->cookies_gen;
+    ff_mutex_unlock(&pf->mutex);
+    av_free(cookies);
+}
+
+static int open_part(PrefetchWorker *w, HLSPrefetchSegment *seg,
+                     int64_t start, int64_t end, AVIOContext **pb)
+{
+    HLSPrefetch *pf = w->pf;
+    AVDictionary *opts = NULL;
+    int is_http = av_strstart(seg->url, "http", NULL);
+    unsigned cookies_gen;
+    int ret;
+
+    ff_mutex_lock(&pf->mutex);
+    ret = av_dict_copy(&opts, pf->opts, 0);
+    cookies_gen = pf->cookies_gen;
+    ff_mutex_unlock(&pf->mutex);
+    if (ret < 0) {
+        av_dict_free(&opts);
+        return ret;
+    }
+
+#if CONFIG_HTTP_PROTOCOL
+    if (w->conn && is_http && same_host(w->conn_url, seg->url)) {
+        AVDictionary *req_opts = NULL;
+        const AVDictionaryEntry *cookies;
+
+        set_range(&req_opts, seg, start, end);
+        /* The connection keeps the cookies set by its own responses, unless
+         * newer ones were set since they were last passed to it. */
+        if (w->cookies_gen != cookies_gen &&
+            (cookies = av_dict_get(opts, "cookies", NULL, 0)))
+            av_dict_set(&req_opts, "cookies", cookies->value, 0);
+        w->conn->eof_reached = 0;
+        ret = ff_http_do_new_request2(ffio_geturlcontext(w->conn), seg->url, &req_opts);
+        av_dict_free(&req_opts);
+        if (ret >= 0) {
+            w->cookies_gen = cookies_gen;
+            av_dict_free(&opts);
+            *pb = w->conn;
+            w->conn = NULL;
+            share_cookies(w, *pb);
+            return 0;
+        }
+    }
+#endif
+    avio_closep(&w->conn);
+
+    if (is_http) {
+        av_dict_set(&opts, "multiple_requests", "1", 0);
+        set_range(&opts, seg, start, end);
+    }
+    ret = ffio_open_whitelist(pb, seg->url, AVIO_FLAG_READ, &w->interrupt_callback,
+                              &opts, pf->s->protocol_whitelist,
+                              pf->s->protocol_blacklist);
+    av_dict_free(&opts);
+    if (ret < 0)
+        return ret;
+    w->cookies_gen = cookies_gen;
+    if (is_http)
+        share_cookies(w, *pb);
+
+    if (!is_http && seg->url_offset + start) {
+        int64_t pos = avio_seek(*pb, seg->url_offset + start, SEEK_SET);
+        if (pos < 0) {
+            avio_closep(pb);
+            return pos;
+        }
+    }
+    return 0;
+}
+
+static int download_part(PrefetchWorker *w, HLSPrefetchSegment *seg, int idx)
+{
+    HLSPrefetch *pf = w->pf;
+    AVIOContext *pb = NULL;
+    int64_t split_end = pf->split_size ? pf->split_size : -1;
+    int64_t start, end, size = -1;
+    int ret;
+
+    ff_mutex_lock(&pf->mutex);
+    start = seg->parts[idx].start;
+    end   = seg->parts[idx].end;
+    ff_mutex_unlock(&pf->mutex);
+
+    /* If the segment may be split, ask for the first part only; the size
+     * of the whole segment is still known from the response. */
+    ret = open_part(w, seg, start, end < 0 ? split_end : end, &pb);
+    if (ret >= 0 && end < 0) {
+        size = avio_size(pb);
+        if (size < 0 && split_end >= 0) {
+            avio_closep(&pb);
+            ret = open_part(w, seg, start, -1, &pb);
+        }
+    }
+    if (ret < 0)
+        return ret;
+    if (size >= 0)
+        size = FFMAX(size - seg->url_offset, 0);
+
+    ff_mutex_lock(&pf->mutex);
+    seg->opened = 1;
+    if (size >= 0) {
+        set_segment_size(pf, seg, size, pb->seekable & AVIO_SEEKABLE_NORMAL);
+        if ((ret = alloc_segment_data(pf, seg)) < 0)
+            seg->error = ret;
+        ff_cond_broadcast(&pf->cond_worker);
+    }
+    ff_cond_broadcast(&pf->cond_reader);
+    ff_mutex_unlock(&pf->mutex);
+
+    while (ret >= 0) {
+        PrefetchPart *part;
+        int64_t pos, len;
+        uint8_t *dst;
+
+        ff_mutex_lock(&pf->mutex);
+        part = &seg->parts[idx];
+        pos  = part->start + part->filled;
+        if (part->end >= 0) {
+            len = FFMIN(part->end - pos, PREFETCH_READ_SIZE);
+        } else {
+            len = PREFETCH_READ_SIZE;
+            if (pos + len > seg->data_size) {
+                size_t new_size = FFMAX(2 * seg->data_size, pos + len);
+                uint8_t *data   = av_realloc(seg->data, new_size);
+                if (!data) {
+                    ret = AVERROR(ENOMEM);
+                    ff_mutex_unlock(&pf->mutex);
+                    break;
+                }
+                pf->used       += new_size - seg->data_size;
+                seg->data       = data;
+                seg->data_size  = new_size;
+            }
+        }
+        dst = seg->data + pos;
+        ff_mutex_unlock(&pf->mutex);
+
+        if (!len)
+            break;
+
+        ret = avio_read(pb, dst, len);
+        ff_mutex_lock(&pf->mutex);
+        if (ret > 0) {
+            part->filled += ret;
+        } else if (ret == AVERROR_EOF && part->end < 0) {
+            /* the end of a segment of unknown size */
+            part->end = seg->size = pos;
+            ret = 0;
+        } else if (ret >= 0 || ret == AVERROR_EOF) {
+            ret = AVERROR(EIO);
+        }
+        ff_cond_broadcast(&pf->cond_reader);
+        ff_mutex_unlock(&pf->mutex);
+    }
+
+    /* Keep the connection only if the response has been read completely. */
+    if (ret >= 0 && av_strstart(seg->url, "http", NULL) &&
+        (avio_feof(pb) || (avio_r8(pb), avio_feof(pb)))) {
+        av_freep(&w->conn_url);
+        w->conn_url = av_strdup(seg->url);
+        if (w->conn_url) {
+            w->conn = pb;
+            pb = NULL;
+        }
+    }
+    avio_closep(&pb);
+    return ret < 0 ? ret : 0;
+}
+
+static void *prefetch_worker(void *arg)
+{
+    PrefetchWorker *w = arg;
+    HLSPrefetch *pf = w->pf;
+
+    ff_thread_setname("hls-prefetch");
+
+    ff_mutex_lock(&pf->mutex);
+    while (!atomic_load(&pf->abort)) {
+        HLSPrefetchSegment *seg;
+        int idx, ret;
+
+        seg = next_part(pf, &idx);
+        if (!seg) {
+            ff_cond_wait(&pf->cond_worker, &pf->mutex);
+            continue;
+        }
+        if (seg->size >= 0 && !seg->data &&
+            (ret = alloc_segment_data(pf, seg)) < 0) {
+            seg->error = ret;
+            ff_cond_broadcast(&pf->cond_reader);
+            continue;
+        }
+        seg->parts[idx].started = 1;
+        seg->nb_running++;
+        w->seg = seg;
+        ff_mutex_unlock(&pf->mutex);
+
+        ret = download_part(w, seg, idx);
+
+        ff_mutex_lock(&pf->mutex);
+        w->seg = NULL;
+        if (ret < 0 && !seg->error)
+            seg->error = ret;
+        if (!--seg->nb_running && atomic_load(&seg->released))
+            free_segment(pf, seg);
+        ff_cond_broadcast(&pf->cond_reader);
+    }
+    ff_mutex_unlock(&pf->mutex);
+
+    avio_closep(&w->conn);
+    av_freep(&w->conn_url);
+    return NULL;
+}
+
+int ff_hls_prefetch_init(HLSPrefetch **ppf, AVFormatContext *s, int nb_threads,
+                         int64_t max_size, int64_t split_size,
+                         const AVDictionary *opts)
+{
+#if HAVE_THREADS
+    HLSPrefetch *pf;
+    int ret;
+
+    pf = av_mallocz(sizeof(*pf));
+    if (!pf)
+        return AVERROR(ENOMEM);
+    pf->s          = s;
+    pf->max_size   = max_size;
+    pf->split_size = split_size > 0 ? FFMAX(split_size, PREFETCH_READ_SIZE) : 0;
+    atomic_init(&pf->abort, 0);
+
+    pf->workers = av_calloc(nb_threads, sizeof(*pf->workers));
+    if (!pf->workers || av_dict_copy(&pf->opts, opts, 0) < 0) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    ret = ff_mutex_init(&pf->mutex, NULL);
+    if (ret) {
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    ret = ff_cond_init(&pf->cond_worker, NULL);
+    if (ret) {
+        ret = AVERROR(ret);
+        goto cond_worker_fail;
+    }
+    ret = ff_cond_init(&pf->cond_reader, NULL);
+    if (ret) {
+        ret = AVERROR(ret);
+        goto cond_reader_fail;
+    }
+
+    *ppf = pf;
+    for (int i = 0; i < nb_threads; i++) {
+        PrefetchWorker *w = &pf->workers[i];
+
+        w->pf = pf;
+        w->interrupt_callback.callback = prefetch_interrupt_cb;
+        w->interrupt_callback.opaque   = w;
+        ret = pthread_create(&w->thread, NULL, prefetch_worker, w);
+        if (ret) {
+            av_log(s, AV_LOG_ERROR, "pthread_create failed: %s\n",
+                   av_err2str(AVERROR(ret)));
+            ff_hls_prefetch_uninit(ppf);
+            return AVERROR(ret);
+        }
+        pf->nb_workers++;
+    }
+    return 0;
+
+cond_reader_fail:
+    ff_cond_destroy(&pf->cond_worker);
+cond_worker_fail:
+    ff_mutex_destroy(&pf->mutex);
+fail:
+    av_dict_free(&pf->opts);
+    av_free(pf->workers);
+    av_free(pf);
+    return ret;
+#else
+    return AVERROR(ENOSYS);
+#endif
+}
+
+void ff_hls_prefetch_uninit(HLSPrefetch **ppf)
+{
+    HLSPrefetch *pf = *ppf;
+
+    if (!pf)
+        return;
+
+    ff_mutex_lock(&pf->mutex);
+    atomic_store(&pf->abort, 1);
+    ff_cond_broadcast(&pf->cond_worker);
+    ff_mutex_unlock(&pf->mutex);
+
+#if HAVE_THREADS
+    for (int i = 0; i < pf->nb_workers; i++)
+        pthread_join(pf->workers[i].thread, NULL);
+#endif
+
+    for (int i = 0; i < pf->nb_segs; i++)
+        free_segment(pf, pf->segs[i]);
+    av_freep(&pf->segs);
+    av_freep(&pf->workers);
+    av_dict_free(&pf->opts);
+    ff_cond_destroy(&pf->cond_reader);
+    ff_cond_destroy(&pf->cond_worker);
+    ff_mutex_destroy(&pf->mutex);
+    av_freep(ppf);
+}
+
+int ff_hls_prefetch_add(HLSPrefetch *pf, const void *owner, int64_t seq_no,
+                        const char *url, int64_t offset, int64_t size)
+{
+    HLSPrefetchSegment *seg;
+    int ret = 0;
+
+    ff_mutex_lock(&pf->mutex);
+    for (int i = 0; i < pf->nb_segs; i++)
+        if (pf->segs[i]->owner == owner && pf->segs[i]->seq_no == seq_no)
+            goto end;
+
+    seg = av_mallocz(sizeof(*seg));
+    if (!seg) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    seg->owner      = owner;
+    seg->seq_no     = seq_no;
+    seg->url_offset = offset;
+    seg->size       = -1;
+    seg->url        = av_strdup(url);
+    seg->parts      = av_mallocz(sizeof(*seg->parts));
+    atomic_init(&seg->released, 0);
+    if (!seg->url || !seg->parts) {
+        ret = AVERROR(ENOMEM);
+        free_segment(pf, seg);
+        goto end;
+    }
+    seg->nb_parts = 1;
+    seg->parts[0].end = -1;
+    /* Byte ranges given in the playlist are assumed to be supported. */
+    if (size >= 0)
+        set_segment_size(pf, seg, size, 1);
+
+    ret = av_dynarray_add_nofree(&pf->segs, &pf->nb_segs, seg);
+    if (ret < 0) {
+        free_segment(pf, seg);
+        goto end;
+    }
+    ff_cond_broadcast(&pf->cond_worker);
+end:
+    ff_mutex_unlock(&pf->mutex);
+    return ret;
+}
+
+HLSPrefetchSegment *ff_hls_prefetch_get(HLSPrefetch *pf, const void *owner,
+                                        int64_t seq_no)
+{
+    HLSPrefetchSegment *seg = NULL;
+
+    ff_mutex_lock(&pf->mutex);
+    for (int i = pf->nb_segs - 1; i >= 0; i--) {
+        HLSPrefetchSegment *cur = pf->segs[i];
+        if (cur->owner != owner || cur->seq_no > seq_no)
+            continue;
+        if (cur->seq_no == seq_no)
+            seg = cur;
+        else
+            drop_segment(pf, cur);
+    }
+
+    if (seg) {
+        seg->claimed = 1;
+        ff_cond_broadcast(&pf->cond_worker);
+        while (!seg->opened && !seg->error)
+            ff_cond_wait(&pf->cond_reader, &pf->mutex);
+        if (!seg->opened) {
+            drop_segment(pf, seg);
+            seg = NULL;
+        }
+    }
+    ff_mutex_unlock(&pf->mutex);
+    return seg;
+}
+
+int ff_hls_prefetch_read(HLSPrefetch *pf, HLSPrefetchSegment *seg,
+                         uint8_t *buf, int buf_size)
+{
+    int ret;
+
+    ff_mutex_lock(&pf->mutex);
+    for (;;) {
+        const PrefetchPart *part;
+        int64_t avail;
+        int i = seg->nb_parts - 1;
+
+        if (seg->size >= 0 && seg->read_pos >= seg->size) {
+            ret = AVERROR_EOF;
+            break;
+        }
+        while (i > 0 && seg->parts[i].start > seg->read_pos)
+            i--;
+        part  = &seg->parts[i];
+        avail = part->start + part->filled - seg->read_pos;
+        if (avail > 0) {
+            ret = FFMIN(avail, buf_size);
+            memcpy(buf, seg->data + seg->read_pos, ret);
+            seg->read_pos += ret;
+            break;
+        }
+        if (seg->error) {
+            ret = seg->error;
+            break;
+        }
+        ff_cond_wait(&pf->cond_reader, &pf->mutex);
+    }
+    ff_mutex_unlock(&pf->mutex);
+    return ret;
+}
+
+void ff_hls_prefetch_release(HLSPrefetch *pf, HLSPrefetchSegment **seg)
+{
+    if (!*seg)
+        return;
+    ff_mutex_lock(&pf->mutex);
+    drop_segment(pf, *seg);
+    ff_mutex_unlock(&pf->mutex);
+    *seg = NULL;
+}
+
+void ff_hls_prefetch_flush(HLSPrefetch *pf, const void *owner)
+{
+    ff_mutex_lock(&pf->mutex);
+    for (int i = pf->nb_segs - 1; i >= 0; i--)
+        if (pf->segs[i]->owner == owner)
+            drop_segment(pf, pf->segs[i]);
+    ff_mutex_unlock(&pf->mutex);
+}
+
+int ff_hls_prefetch_set_cookies(HLSPrefetch *pf, const char *cookies)
+{
+    int ret;
+
+    ff_mutex_lock(&pf->mutex);
+    ret = set_cookies(pf, cookies);
+    ff_mutex_unlock(&pf->mutex);
+
+    return FFMIN(ret, 0);
+}
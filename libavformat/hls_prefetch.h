@@ -0,0 +1,98 @@
+/*
+ * Apple HTTP Live Streaming segment prefetching
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_HLS_PREFETCH_H
+#define AVFORMAT_HLS_PREFETCH_H
+
+#include <stdint.h>
+
+#include "libavutil/dict.h"
+#include "avformat.h"
+
+typedef struct HLSPrefetch HLSPrefetch;
+typedef struct HLSPrefetchSegment HLSPrefetchSegment;
+
+/**
+ * Start the download threads.
+ *
+ * Segments are opened with the protocol layer directly, using the
+ * interrupt callback and protocol white-/blacklists of s.
+ *
+ * @param nb_threads number of download threads, each of which keeps its
+ *                   own persistent HTTP connection
+ * @param max_size   memory limit for segments that are not read yet; a
+ *                   download is only started while the limit is not reached
+ * @param split_size if > 0, segments larger than this are downloaded as
+ *                   parallel byte ranges of this size
+ * @param opts       options for opening the segments
+ */
+int ff_hls_prefetch_init(HLSPrefetch **ppf, AVFormatContext *s, int nb_threads,
+                         int64_t max_size, int64_t split_size,
+                         const AVDictionary *opts);
+
+void ff_hls_prefetch_uninit(HLSPrefetch **ppf);
+
+/**
+ * Queue the download of a segment unless it is queued already.
+ *
+ * @param owner  identifies the playlist of the segment together with seq_no
+ * @param size   size of the segment starting at offset, or -1 for the
+ *               whole resource
+ */
+int ff_hls_prefetch_add(HLSPrefetch *pf, const void *owner, int64_t seq_no,
+                        const char *url, int64_t offset, int64_t size);
+
+/**
+ * Take a queued segment for reading. Queued segments of owner that
+ * precede seq_no are dropped. Waits until the segment is opened.
+ *
+ * @return the segment, or NULL if it was not queued or could not be opened
+ */
+HLSPrefetchSegment *ff_hls_prefetch_get(HLSPrefetch *pf, const void *owner,
+                                        int64_t seq_no);
+
+/**
+ * Read from a segment returned by ff_hls_prefetch_get(), waiting for the
+ * download if needed.
+ *
+ * @return number of bytes read, AVERROR_EOF at the end of the segment or
+ *         the error of the download
+ */
+int ff_hls_prefetch_read(HLSPrefetch *pf, HLSPrefetchSegment *seg,
+                         uint8_t *buf, int buf_size);
+
+/**
+ * Release a segment returned by ff_hls_prefetch_get() and set *seg to NULL.
+ */
+void ff_hls_prefetch_release(HLSPrefetch *pf, HLSPrefetchSegment **seg);
+
+/**
+ * Drop all queued segments of owner.
+ */
+void ff_hls_prefetch_flush(HLSPrefetch *pf, const void *owner);
+
+/**
+ * Update the cookies sent with the segment requests, e.g. after the demuxer
+ * got new ones in a response. Cookies set by the responses to the segment
+ * requests are shared between the download threads the same way.
+ */
+int ff_hls_prefetch_set_cookies(HLSPrefetch *pf, const char *cookies);
+
+#endif /* AVFORMAT_HLS_PREFETCH_H */
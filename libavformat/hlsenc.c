@@ -92,6 +92,13 @@ typedef struct HLSSegment {
     double discont_program_date_time;
 } HLSSegment;
 
+typedef struct HLSPart {
+    char *url;          /* final path of the part file */
+    double duration;    /* in seconds */
+    int64_t sequence;   /* media sequence number of the parent segment */
+    int independent;
+} HLSPart;
+
 typedef enum HLSFlags {
     // Generate a single media file and use byte ranges in the playlist.
     HLS_SINGLE_FILE = (1 << 0),
@@ -159,6 +166,13 @@ typedef struct VariantStream {
     HLSSegment *last_segment;
     HLSSegment *old_segments;
 
+    HLSPart *parts;       // parts of the listed segments and of the current one
+    int nb_parts;
+    unsigned int parts_size;
+    int64_t part_start_pts;
+    int part_start_pos;   // offset of the current part in the segment buffer
+    int part_independent;
+
     char *basename_tmp;
     char *basename;
     char *vtt_basename;
@@ -218,6 +232,8 @@ typedef struct HLSContext {
     int allowcache;
     int64_t recording_time;
     int64_t max_seg_size; // every segment file max size
+    int64_t part_time;    // partial segment length, enables low-latency HLS
+    int can_block_reload;
 
     char *baseurl;
     char *vtt_format_options_str;
@@ -254,6 +270,7 @@ typedef struct HLSContext {
     char *master_pl_name;
     unsigned int master_publish_rate;
     int http_persistent;
+    AVDictionary *http_opts;
     AVIOContext *m3u8_out;
     AVIOContext *sub_m3u8_out;
     AVIOContext *http_delete;
@@ -337,6 +354,7 @@ static void set_http_options(AVFormatContext *s, AVDictionary **options, HLSCont
     } else if (http_base_proto) {
         av_dict_set(options, "method", "PUT", 0);
     }
+    av_dict_copy(options, c->http_opts, 0);
     if (c->user_agent)
         av_dict_set(options, "user_agent", c->user_agent, 0);
     if (c->http_persistent)
@@ -710,6 +728,59 @@ fail:
     return ret;
 }
 
+static char *get_part_filename(HLSContext *hls, const char *url, int index)
+{
+    size_t len = strlen(url);
+    const char *ext;
+
+    /* parts are named after the final name of their segment */
+    if ((hls->flags & HLS_TEMP_FILE) && len > 4 && !strcmp(url + len - 4, ".tmp"))
+        len -= 4;
+    for (ext = url + len; ext > url && ext[-1] != '.' && ext[-1] != '/'; ext--);
+    if (ext == url || ext[-1] != '.')
+        return av_asprintf("%.*s.part%d", (int)len, url, index);
+    ext--;
+    return av_asprintf("%.*s.part%d%.*s", (int)(ext - url), url, index,
+                       (int)(url + len - ext), ext);
+}
+
+static int count_segment_parts(VariantStream *vs, int64_t sequence)
+{
+    int i = vs->nb_parts;
+
+    while (i > 0 && vs->parts[i - 1].sequence == sequence)
+        i--;
+    return vs->nb_parts - i;
+}
+
+static int hls_drop_old_parts(AVFormatContext *s, HLSContext *hls,
+                              VariantStream *vs)
+{
+    int64_t first_sequence = vs->sequence - vs->nb_entries;
+    const char *proto = avio_find_protocol_name(s->url);
+    int i, ret = 0;
+
+    for (i = 0; i < vs->nb_parts && vs->parts[i].sequence < first_sequence; i++) {
+        if ((hls->flags & HLS_DELETE_SEGMENTS) && !ret) {
+            av_log(hls, AV_LOG_DEBUG, "deleting old part %s\n", vs->parts[i].url);
+            ret = hls_delete_file(hls, s, vs->parts[i].url, proto);
+        }
+        av_freep(&vs->parts[i].url);
+    }
+    vs->nb_parts -= i;
+    memmove(vs->parts, vs->parts + i, vs->nb_parts * sizeof(*vs->parts));
+
+    return FFMIN(ret, 0);
+}
+
+static void hls_free_parts(VariantStream *vs)
+{
+    for (int i = 0; i < vs->nb_parts; i++)
+        av_freep(&vs->parts[i].url);
+    av_freep(&vs->parts);
+    vs->nb_parts = vs->parts_size = 0;
+}
+
 static int do_encrypt(AVFormatContext *s, VariantStream *vs)
 {
     HLSContext *hls = s->priv_data;
@@ -1199,6 +1270,9 @@ static int hls_append_segment(struct AVFormatContext *s, HLSContext *hls,
     }
     vs->sequence++;
 
+    if (hls->part_time > 0)
+        return hls_drop_old_parts(s, hls, vs);
+
     return 0;
 }
 
@@ -1556,6 +1630,57 @@ fail:
     return ret;
 }
 
+static int write_preload_hint(AVFormatContext *s, VariantStream *vs)
+{
+    HLSContext *hls = s->priv_data;
+    char *filename = get_part_filename(hls, vs->avf->url,
+                                       count_segment_parts(vs, vs->sequence));
+
+    if (!filename)
+        return AVERROR(ENOMEM);
+    ff_hls_write_preload_hint(vs->out, hls->baseurl,
+                              hls->use_localtime_mkdir ? filename : av_basename(filename));
+    av_free(filename);
+    return 0;
+}
+
+static int write_rendition_reports(AVFormatContext *s, VariantStream *vs)
+{
+    HLSContext *hls = s->priv_data;
+    AVBPrint url;
+
+    av_bprint_init(&url, 0, AV_BPRINT_SIZE_UNLIMITED);
+    for (int i = 0; i < hls->nb_varstreams; i++) {
+        VariantStream *other = &hls->var_streams[i];
+        const char *from = vs->m3u8_name, *to = other->m3u8_name, *p;
+        size_t prefix = 0;
+        int64_t last_msn;
+
+        if (other == vs || !other->nb_parts)
+            continue;
+
+        /* the URI is relative to the playlist that carries the report */
+        for (size_t j = 0; from[j] && from[j] == to[j]; j++)
+            if (from[j] == '/')
+                prefix = j + 1;
+        av_bprint_clear(&url);
+        for (p = from + prefix; (p = strchr(p, '/')); p++)
+            av_bprintf(&url, "../");
+        av_bprintf(&url, "%s", to + prefix);
+        if (!av_bprint_is_complete(&url)) {
+            av_bprint_finalize(&url, NULL);
+            return AVERROR(ENOMEM);
+        }
+
+        last_msn = other->parts[other->nb_parts - 1].sequence;
+        ff_hls_write_rendition_report(vs->out, url.str, last_msn,
+                                      count_segment_parts(other, last_msn) - 1);
+    }
+    av_bprint_finalize(&url, NULL);
+
+    return 0;
+}
+
 static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
 {
     HLSContext *hls = s->priv_data;
@@ -1575,6 +1700,10 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     double prog_date_time = vs->initial_prog_date_time;
     double *prog_date_time_p = (hls->flags & HLS_PROGRAM_DATE_TIME) ? &prog_date_time : NULL;
     int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
+    double part_target = hls->part_time / (double)AV_TIME_BASE;
+    double parts_start = 0;
+    int64_t msn = vs->sequence - vs->nb_entries;
+    int part = 0;
 
     hls->version = 2;
     if (!(hls->flags & HLS_ROUND_DURATIONS)) {
@@ -1612,6 +1741,12 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     for (en = vs->segments; en; en = en->next) {
         if (target_duration <= en->duration)
             target_duration = lrint(en->duration);
+        parts_start += en->duration;
+    }
+    if (hls->part_time > 0) {
+        /* parts are only listed for the last three target durations */
+        target_duration = FFMAX(target_duration, lrint(hls->time / (double)AV_TIME_BASE));
+        parts_start -= 3 * target_duration;
     }
 
     vs->discontinuity_set = 0;
@@ -1625,7 +1760,9 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     if (vs->has_video && (hls->flags & HLS_INDEPENDENT_SEGMENTS)) {
         avio_printf(byterange_mode ? hls->m3u8_out : vs->out, "#EXT-X-INDEPENDENT-SEGMENTS\n");
     }
-    for (en = vs->segments; en; en = en->next) {
+    if (hls->part_time > 0)
+        ff_hls_write_part_info(vs->out, part_target, hls->can_block_reload);
+    for (en = vs->segments; en; en = en->next, msn++) {
         if ((hls->encrypt || hls->key_info_file) && (!key_uri || strcmp(en->key_uri, key_uri) ||
                                     av_strcasecmp(en->iv_string, iv_string))) {
             avio_printf(byterange_mode ? hls->m3u8_out : vs->out, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"", en->key_uri);
@@ -1641,6 +1778,15 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
                                    hls->flags & HLS_SINGLE_FILE, vs->init_range_length, 0);
         }
 
+        for (; part < vs->nb_parts && vs->parts[part].sequence <= msn; part++) {
+            const HLSPart *p = &vs->parts[part];
+            if (p->sequence == msn && parts_start < en->duration)
+                ff_hls_write_part(vs->out, p->duration, hls->baseurl,
+                                  hls->use_localtime_mkdir ? p->url : av_basename(p->url),
+                                  p->independent);
+        }
+        parts_start -= en->duration;
+
         ret = ff_hls_write_file_entry(byterange_mode ? hls->m3u8_out : vs->out, en->discont, byterange_mode,
                                       en->duration, hls->flags & HLS_ROUND_DURATIONS,
                                       en->size, en->pos, hls->baseurl,
@@ -1654,6 +1800,24 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
         }
     }
 
+    if (hls->part_time > 0) {
+        if (!vs->segments && vs->nb_parts)
+            ff_hls_write_init_file(vs->out, vs->fmp4_init_filename, 0, 0, 0);
+        for (; part < vs->nb_parts; part++) {
+            const HLSPart *p = &vs->parts[part];
+            ff_hls_write_part(vs->out, p->duration, hls->baseurl,
+                              hls->use_localtime_mkdir ? p->url : av_basename(p->url),
+                              p->independent);
+        }
+        if (!last) {
+            ret = write_preload_hint(s, vs);
+            if (ret >= 0)
+                ret = write_rendition_reports(s, vs);
+            if (ret < 0)
+                goto fail;
+        }
+    }
+
     if (last && (hls->flags & HLS_OMIT_ENDLIST)==0)
         ff_hls_write_end_list(byterange_mode ? hls->m3u8_out : vs->out);
 
@@ -2401,6 +2565,125 @@ static int hls_init_file_resend(AVFormatContext *s, VariantStream *vs)
     return ret;
 }
 
+static int write_init_buffer(AVFormatContext *s, VariantStream *vs)
+{
+    HLSContext *hls = s->priv_data;
+    AVFormatContext *oc = vs->avf;
+    int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
+    int range_length;
+
+    range_length = avio_close_dyn_buf(oc->pb, &vs->init_buffer);
+    if (range_length <= 0)
+        return AVERROR(EINVAL);
+    avio_write(vs->out, vs->init_buffer, range_length);
+    if (!hls->resend_init_file)
+        av_freep(&vs->init_buffer);
+    vs->init_range_length = range_length;
+    avio_open_dyn_buf(&oc->pb);
+    vs->packets_written = 0;
+    vs->start_pos = range_length;
+    if (!byterange_mode) {
+        hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
+    }
+    return 0;
+}
+
+static int hls_update_playlist(AVFormatContext *s, VariantStream *vs)
+{
+    int ret;
+
+    if ((ret = hls_window(s, 0, vs)) < 0) {
+        av_log(s, AV_LOG_WARNING, "upload playlist failed, will retry with a new http session.\n");
+        ff_format_io_close(s, &vs->out);
+        ret = hls_window(s, 0, vs);
+    }
+    return ret;
+}
+
+/**
+ * Flush the pending samples as a fragment and write it out as the next
+ * partial segment of the current segment. The segment buffer keeps the
+ * data, so that the whole segment is written at its end as usual and is
+ * the concatenation of its parts.
+ */
+static int hls_write_part(AVFormatContext *s, VariantStream *vs,
+                          double duration, int update_playlist)
+{
+    HLSContext *hls = s->priv_data;
+    AVFormatContext *oc = vs->avf;
+    AVDictionary *options = NULL;
+    const char *proto;
+    char *url, *filename;
+    uint8_t *buf;
+    HLSPart *parts;
+    int size, use_temp_file, ret;
+
+    av_write_frame(oc, NULL); /* Flush any buffered data */
+    if (!vs->init_range_length) {
+        /* the first flush only produces the init section */
+        ret = write_init_buffer(s, vs);
+        if (ret < 0)
+            return ret;
+        vs->part_start_pos = 0;
+        av_write_frame(oc, NULL);
+    }
+    size = avio_get_dyn_buf(oc->pb, &buf);
+    if (size <= vs->part_start_pos)
+        return 0;
+
+    url = get_part_filename(hls, oc->url, count_segment_parts(vs, vs->sequence));
+    if (!url)
+        return AVERROR(ENOMEM);
+    proto = avio_find_protocol_name(url);
+    use_temp_file = proto && !strcmp(proto, "file") && (hls->flags & HLS_TEMP_FILE);
+    filename = use_temp_file ? av_asprintf("%s.tmp", url) : av_strdup(url);
+    if (!filename) {
+        av_free(url);
+        return AVERROR(ENOMEM);
+    }
+
+    set_http_options(s, &options, hls);
+    ret = hlsenc_io_open(s, &vs->out, filename, &options);
+    av_dict_free(&options);
+    if (ret >= 0) {
+        /* the segment file starts with a styp, so the first part does too */
+        if (!vs->part_start_pos)
+            write_styp(vs->out);
+        avio_write(vs->out, buf + vs->part_start_pos, size - vs->part_start_pos);
+        ret = hlsenc_io_close(s, &vs->out, filename);
+    }
+    if (ret >= 0 && use_temp_file)
+        ret = ff_rename(filename, url, s);
+    av_free(filename);
+    if (ret < 0) {
+        av_log(s, hls->ignore_io_errors ? AV_LOG_WARNING : AV_LOG_ERROR,
+               "Failed to write part '%s'\n", url);
+        if (!hls->ignore_io_errors) {
+            av_free(url);
+            return ret;
+        }
+    }
+    vs->part_start_pos = size;
+
+    parts = av_fast_realloc(vs->parts, &vs->parts_size,
+                            (vs->nb_parts + 1) * sizeof(*vs->parts));
+    if (!parts) {
+        av_free(url);
+        return AVERROR(ENOMEM);
+    }
+    vs->parts = parts;
+    parts[vs->nb_parts++] = (HLSPart) {
+        .url         = url,
+        .duration    = duration,
+        .sequence    = vs->sequence,
+        .independent = vs->part_independent,
+    };
+
+    if (update_playlist && hls->pl_type != PLAYLIST_TYPE_VOD)
+        return hls_update_playlist(s, vs);
+    return 0;
+}
+
 static int64_t append_single_file(AVFormatContext *s, VariantStream *vs)
 {
     int64_t ret = 0;
@@ -2529,25 +2812,21 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
         double cur_duration;
 
+        if (hls->part_time > 0 && vs->part_start_pts != AV_NOPTS_VALUE) {
+            ret = hls_write_part(s, vs, (pkt->pts - vs->part_start_pts) * av_q2d(st->time_base), 0);
+            if (ret < 0)
+                return ret;
+        }
+
         av_write_frame(oc, NULL); /* Flush any buffered data */
         new_start_pos = avio_tell(oc->pb);
         vs->size = new_start_pos - vs->start_pos;
         avio_flush(oc->pb);
         if (hls->segment_type == SEGMENT_TYPE_FMP4) {
             if (!vs->init_range_length) {
-                range_length = avio_close_dyn_buf(oc->pb, &vs->init_buffer);
-                if (range_length <= 0)
-                    return AVERROR(EINVAL);
-                avio_write(vs->out, vs->init_buffer, range_length);
-                if (!hls->resend_init_file)
-                    av_freep(&vs->init_buffer);
-                vs->init_range_length = range_length;
-                avio_open_dyn_buf(&oc->pb);
-                vs->packets_written = 0;
-                vs->start_pos = range_length;
-                if (!byterange_mode) {
-                    hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
-                }
+                ret = write_init_buffer(s, vs);
+                if (ret < 0)
+                    return ret;
             }
         }
         if (!byterange_mode) {
@@ -2649,14 +2928,11 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         }
 
         // if we're building a VOD playlist, skip writing the manifest multiple times, and just wait until the end
-        if (hls->pl_type != PLAYLIST_TYPE_VOD) {
-            if ((ret = hls_window(s, 0, vs)) < 0) {
-                av_log(s, AV_LOG_WARNING, "upload playlist failed, will retry with a new http session.\n");
-                ff_format_io_close(s, &vs->out);
-                if ((ret = hls_window(s, 0, vs)) < 0) {
-                    av_freep(&old_filename);
-                    return ret;
-                }
+        // with partial segments, wait for the next segment to be started for its preload hint
+        if (hls->pl_type != PLAYLIST_TYPE_VOD && !hls->part_time) {
+            if ((ret = hls_update_playlist(s, vs)) < 0) {
+                av_freep(&old_filename);
+                return ret;
             }
         }
 
@@ -2697,6 +2973,28 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         if (ret < 0) {
             return ret;
         }
+
+        if (hls->part_time > 0) {
+            vs->part_start_pts = AV_NOPTS_VALUE;
+            vs->part_start_pos = 0;
+            if (hls->pl_type != PLAYLIST_TYPE_VOD &&
+                (ret = hls_update_playlist(s, vs)) < 0)
+                return ret;
+        }
+    } else if (hls->part_time > 0 && is_ref_pkt && vs->packets_written &&
+               vs->part_start_pts != AV_NOPTS_VALUE && pkt->pts > vs->part_start_pts &&
+               av_compare_ts(pkt->pts + pkt->duration - vs->part_start_pts, st->time_base,
+                             hls->part_time, AV_TIME_BASE_Q) > 0) {
+        /* cut before the packet that would make the part exceed its target */
+        ret = hls_write_part(s, vs, (pkt->pts - vs->part_start_pts) * av_q2d(st->time_base), 1);
+        if (ret < 0)
+            return ret;
+        vs->part_start_pts = AV_NOPTS_VALUE;
+    }
+
+    if (hls->part_time > 0 && is_ref_pkt && vs->part_start_pts == AV_NOPTS_VALUE) {
+        vs->part_start_pts   = pkt->pts;
+        vs->part_independent = !vs->has_video || (pkt->flags & AV_PKT_FLAG_KEY);
     }
 
     vs->packets_written++;
@@ -2736,6 +3034,7 @@ static void hls_deinit(AVFormatContext *s)
             av_freep(&vs->init_buffer);
         hls_free_segments(vs->segments);
         hls_free_segments(vs->old_segments);
+        hls_free_parts(vs);
         av_freep(&vs->m3u8_name);
         av_freep(&vs->streams);
     }
@@ -2787,6 +3086,15 @@ static int hls_write_trailer(struct AVFormatContext *s)
             return AVERROR(ENOMEM);
         }
 
+        if (hls->part_time > 0) {
+            double duration = vs->duration + vs->dpp;
+            for (int j = vs->nb_parts - count_segment_parts(vs, vs->sequence); j < vs->nb_parts; j++)
+                duration -= vs->parts[j].duration;
+            ret = hls_write_part(s, vs, FFMAX(duration, 0), 0);
+            if (ret < 0)
+                goto failed;
+        }
+
         if (hls->segment_type == SEGMENT_TYPE_FMP4) {
             int range_length = 0;
             if (!vs->init_range_length) {
@@ -2977,6 +3285,24 @@ static int hls_init(AVFormatContext *s)
 
     hls->recording_time = hls->init_time && hls->max_nb_segments > 0 ? hls->init_time : hls->time;
 
+    if (hls->part_time > 0) {
+        if (hls->segment_type != SEGMENT_TYPE_FMP4) {
+            av_log(s, AV_LOG_ERROR, "Partial segments require hls_segment_type fmp4\n");
+            return AVERROR(EINVAL);
+        }
+        if ((hls->flags & (HLS_SINGLE_FILE | HLS_I_FRAMES_ONLY |
+                           HLS_SECOND_LEVEL_SEGMENT_DURATION | HLS_SECOND_LEVEL_SEGMENT_SIZE)) ||
+            hls->max_seg_size > 0) {
+            av_log(s, AV_LOG_ERROR, "Partial segments cannot be used with byte range, "
+                   "I-frame only or renamed segments\n");
+            return AVERROR(EINVAL);
+        }
+        if (hls->part_time > hls->time) {
+            av_log(s, AV_LOG_ERROR, "hls_part_time must not be larger than hls_time\n");
+            return AVERROR(EINVAL);
+        }
+    }
+
     if (hls->flags & HLS_SPLIT_BY_TIME && hls->flags & HLS_INDEPENDENT_SEGMENTS) {
         // Independent segments cannot be guaranteed when splitting by time
         hls->flags &= ~HLS_INDEPENDENT_SEGMENTS;
@@ -2995,6 +3321,7 @@ static int hls_init(AVFormatContext *s)
         vs->sequence  = hls->start_sequence;
         vs->start_pts = AV_NOPTS_VALUE;
         vs->end_pts   = AV_NOPTS_VALUE;
+        vs->part_start_pts = AV_NOPTS_VALUE;
         vs->current_segment_final_filename_fmt[0] = '\0';
         vs->initial_prog_date_time = initial_program_date_time;
 
@@ -3154,6 +3481,8 @@ static const AVOption options[] = {
     {"hls_segment_filename", "filename template for segment files", OFFSET(segment_filename),   AV_OPT_TYPE_STRING, {.str = NULL},            0,       0,         E},
     {"hls_segment_options","set segments files format options of hls", OFFSET(format_options), AV_OPT_TYPE_DICT, {.str = NULL},  0, 0,    E},
     {"hls_segment_size", "maximum size per segment file, (in bytes)",  OFFSET(max_seg_size),    AV_OPT_TYPE_INT,    {.i64 = 0},               0,       INT_MAX,   E},
+    {"hls_part_time", "set partial segment length, enables low-latency HLS", OFFSET(part_time), AV_OPT_TYPE_DURATION, {.i64 = 0}, 0, INT64_MAX, E},
+    {"hls_can_block_reload", "announce that the server supports blocking playlist reloads", OFFSET(can_block_reload), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, E},
     {"hls_key_info_file",    "file with key URI and key file path", OFFSET(key_info_file),      AV_OPT_TYPE_STRING, {.str = NULL},            0,       0,         E},
     {"hls_enc",    "enable AES128 encryption support", OFFSET(encrypt),      AV_OPT_TYPE_BOOL, {.i64 = 0},            0,       1,         E},
     {"hls_enc_key",    "hex-coded 16 byte key to encrypt the segments", OFFSET(key),      AV_OPT_TYPE_STRING, .flags = E},
@@ -3198,6 +3527,7 @@ static const AVOption options[] = {
     {"master_pl_name", "Create HLS master playlist with this name", OFFSET(master_pl_name), AV_OPT_TYPE_STRING, {.str = NULL},  0, 0,    E},
     {"master_pl_publish_rate", "Publish master play list every after this many segment intervals", OFFSET(master_publish_rate), AV_OPT_TYPE_INT, {.i64 = 0}, 0, UINT_MAX, E},
     {"http_persistent", "Use persistent HTTP connections", OFFSET(http_persistent), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, E },
+    {"http_opts", "HTTP protocol options", OFFSET(http_opts), AV_OPT_TYPE_DICT, { .str = NULL }, 0, 0, E },
     {"timeout", "set timeout for socket I/O operations", OFFSET(timeout), AV_OPT_TYPE_DURATION, { .i64 = -1 }, -1, INT_MAX, .flags = E },
     {"ignore_io_errors", "Ignore IO errors for stable long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     {"headers", "set custom HTTP headers, can override built in default headers", OFFSET(headers), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, E },
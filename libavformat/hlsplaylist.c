@@ -193,6 +193,43 @@ int ff_hls_write_file_entry(AVIOContext *out, int insert_discont,
     return 0;
 }
 
+void ff_hls_write_part_info(AVIOContext *out, double part_target,
+                            int can_block_reload)
+{
+    if (!out)
+        return;
+    avio_printf(out, "#EXT-X-SERVER-CONTROL:%sPART-HOLD-BACK=%.3f\n",
+                can_block_reload ? "CAN-BLOCK-RELOAD=YES," : "", 3 * part_target);
+    avio_printf(out, "#EXT-X-PART-INF:PART-TARGET=%.3f\n", part_target);
+}
+
+void ff_hls_write_part(AVIOContext *out, double duration, const char *baseurl,
+                       const char *filename, int independent)
+{
+    if (!out || !filename)
+        return;
+    avio_printf(out, "#EXT-X-PART:DURATION=%.5f,URI=\"%s%s\"%s\n", duration,
+                baseurl ? baseurl : "", filename, independent ? ",INDEPENDENT=YES" : "");
+}
+
+void ff_hls_write_preload_hint(AVIOContext *out, const char *baseurl,
+                               const char *filename)
+{
+    if (!out || !filename)
+        return;
+    avio_printf(out, "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"%s%s\"\n",
+                baseurl ? baseurl : "", filename);
+}
+
+void ff_hls_write_rendition_report(AVIOContext *out, const char *filename,
+                                   int64_t last_msn, int last_part)
+{
+    if (!out || !filename)
+        return;
+    avio_printf(out, "#EXT-X-RENDITION-REPORT:URI=\"%s\",LAST-MSN=%"PRId64",LAST-PART=%d\n",
+                filename, last_msn, last_part);
+}
+
 void ff_hls_write_end_list(AVIOContext *out)
 {
     if (!out)
@@ -35,6 +35,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/time.h"
+#include "libavutil/thread.h"
 #include "libavutil/parseutils.h"
 
 #include "avformat.h"
@@ -59,6 +60,8 @@
 #define HTTP_MUTLI    2
 #define MAX_DATE_LEN  19
 #define WHITESPACES " \n\t\r"
+/* max number of bytes of a response body skipped to reuse the connection */
+#define POOL_MAX_DRAIN (64 * 1024)
 typedef enum {
     LOWER_PROTO,
     READ_HEADERS,
@@ -66,6 +69,17 @@ typedef enum {
     FINISH
 }HandshakeState;
 
+/* A lower level connection that can be shared between HTTP contexts. */
+typedef struct HTTPPoolConn {
+    URLContext *hd;                      ///< set while the connection is idle
+    char *key;
+    /* interrupt callback of the current user, forwarded to by the callback
+     * the connection was opened with */
+    AVIOInterruptCB interrupt_callback;
+    int64_t expires;
+    struct HTTPPoolConn *next;
+} HTTPPoolConn;
+
 typedef struct HTTPContext {
     const AVClass *class;
     URLContext *hd;
@@ -143,6 +157,13 @@ typedef struct HTTPContext {
     unsigned int retry_after;
     int reconnect_max_retries;
     int reconnect_delay_total_max;
+    int connection_pool;
+    int pool_idle_timeout;
+    int pool_max_per_host;
+    /* set if hd is taken from or can be returned to the connection pool */
+    HTTPPoolConn *pool_conn;
+    /* Content-Length of the last response and the offset it ends at */
+    uint64_t content_length, body_end;
 } HTTPContext;
 
 #define OFFSET(x) offsetof(HTTPContext, x)
@@ -188,6 +209,9 @@ static const AVOption options[] = {
     { "resource", "The resource requested by a client", OFFSET(resource), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, E },
     { "reply_code", "The http status code to return to a client", OFFSET(reply_code), AV_OPT_TYPE_INT, { .i64 = 200}, INT_MIN, 599, E},
     { "short_seek_size", "Threshold to favor readahead over seek.", OFFSET(short_seek_size), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, D },
+    { "connection_pool", "share persistent connections with other HTTP contexts", OFFSET(connection_pool), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, D | E },
+    { "pool_idle_timeout", "do not reuse pooled connections that are idle for longer than this (in seconds)", OFFSET(pool_idle_timeout), AV_OPT_TYPE_INT, { .i64 = 30 }, 0, INT_MAX / 1000000, D | E },
+    { "pool_max_per_host", "max number of idle pooled connections per server", OFFSET(pool_max_per_host), AV_OPT_TYPE_INT, { .i64 = 6 }, 0, INT_MAX, D | E },
     { NULL }
 };
 
@@ -196,6 +220,7 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
                         const char *proxyauth);
 static int http_read_header(URLContext *h);
 static int http_shutdown(URLContext *h, int flags);
+static void http_release_cnx(URLContext *h);
 
 void ff_http_init_auth_state(URLContext *dest, const URLContext *src)
 {
@@ -207,6 +232,159 @@ void ff_http_init_auth_state(URLContext *dest, const URLContext *src)
            sizeof(HTTPAuthState));
 }
 
+/* Idle connections of all HTTP contexts, most recently used first. */
+static AVMutex pool_mutex = AV_MUTEX_INITIALIZER;
+static HTTPPoolConn *pool_idle;
+
+static int pool_interrupt_cb(void *opaque)
+{
+    HTTPPoolConn *conn = opaque;
+    return ff_check_interrupt(&conn->interrupt_callback);
+}
+
+static void pool_conn_free(HTTPPoolConn **pconn)
+{
+    HTTPPoolConn *conn = *pconn;
+
+    if (!conn)
+        return;
+    /* the connection must be closed first, it uses conn in its
+     * interrupt callback */
+    ffurl_closep(&conn->hd);
+    av_freep(&conn->key);
+    av_freep(pconn);
+}
+
+static void pool_free_list(HTTPPoolConn *conn)
+{
+    while (conn) {
+        HTTPPoolConn *next = conn->next;
+        pool_conn_free(&conn);
+        conn = next;
+    }
+}
+
+/**
+ * Unlink the expired connections and, if key is set, the connections
+ * for key exceeding max_idle from the pool. Must be called with pool_mutex
+ * locked.
+ *
+ * @return the unlinked connections
+ */
+static HTTPPoolConn *pool_evict(const char *key, int max_idle)
+{
+    HTTPPoolConn *evicted = NULL, **p = &pool_idle;
+    int64_t now = av_gettime_relative();
+    int nb_idle = 0;
+
+    while (*p) {
+        HTTPPoolConn *conn = *p;
+        if (conn->expires < now ||
+            (key && !strcmp(conn->key, key) && ++nb_idle > max_idle)) {
+            *p         = conn->next;
+            conn->next = evicted;
+            evicted    = conn;
+        } else {
+            p = &conn->next;
+        }
+    }
+    return evicted;
+}
+
+void ff_http_pool_close(void)
+{
+    HTTPPoolConn *conns;
+
+    ff_mutex_lock(&pool_mutex);
+    conns     = pool_idle;
+    pool_idle = NULL;
+    ff_mutex_unlock(&pool_mutex);
+    pool_free_list(conns);
+}
+
+static char *pool_key(URLContext *h, const char *url, const AVDictionary *options)
+{
+    char *opts = NULL, *key;
+
+    if (av_dict_get_string(options, &opts, '=', ',') < 0)
+        return NULL;
+    key = av_asprintf("%s|%s|%s|%"PRId64"|%s", url,
+                      h->protocol_whitelist ? h->protocol_whitelist : "",
+                      h->protocol_blacklist ? h->protocol_blacklist : "",
+                      h->rw_timeout, opts);
+    av_free(opts);
+    return key;
+}
+
+/**
+ * Open the lower level connection to url, taking an idle one from the
+ * pool if reuse is set and one with the same options is available.
+ *
+ * @return 1 if a pooled connection is used, 0 if a new connection is
+ *         opened, a negative error code otherwise
+ */
+static int http_pool_open(URLContext *h, const char *url,
+                          AVDictionary **options, int reuse)
+{
+    HTTPContext *s = h->priv_data;
+    HTTPPoolConn *conn = NULL, *evicted, **p;
+    char *key;
+    int ret;
+
+    av_assert0(!s->hd && !s->pool_conn);
+
+    if (!(key = pool_key(h, url, *options)))
+        return AVERROR(ENOMEM);
+
+    ff_mutex_lock(&pool_mutex);
+    evicted = pool_evict(NULL, 0);
+    for (p = &pool_idle; reuse && *p; p = &(*p)->next) {
+        if (!strcmp((*p)->key, key)) {
+            conn       = *p;
+            *p         = conn->next;
+            conn->next = NULL;
+            break;
+        }
+    }
+    ff_mutex_unlock(&pool_mutex);
+    pool_free_list(evicted);
+
+    if (conn) {
+        av_free(key);
+        conn->interrupt_callback = h->interrupt_callback;
+        s->hd        = conn->hd;
+        s->pool_conn = conn;
+        conn->hd     = NULL;
+        av_log(h, AV_LOG_DEBUG, "Reusing pooled connection to %s\n", url);
+        return 1;
+    }
+
+    conn = av_mallocz(sizeof(*conn));
+    if (!conn) {
+        av_free(key);
+        return AVERROR(ENOMEM);
+    }
+    conn->key                = key;
+    conn->interrupt_callback = h->interrupt_callback;
+    ret = ffurl_open_whitelist(&s->hd, url, AVIO_FLAG_READ_WRITE,
+                               &(AVIOInterruptCB){ pool_interrupt_cb, conn },
+                               options, h->protocol_whitelist,
+                               h->protocol_blacklist, h);
+    if (ret < 0) {
+        pool_conn_free(&conn);
+        return ret;
+    }
+    s->pool_conn = conn;
+    return 0;
+}
+
+/* Close the lower level connection without returning it to the pool. */
+static void http_close_cnx(HTTPContext *s)
+{
+    ffurl_closep(&s->hd);
+    pool_conn_free(&s->pool_conn);
+}
+
 static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
 {
     const char *path, *proxy_path, *lower_proto = "tcp", *local_path;
@@ -216,7 +394,7 @@ static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
     char auth[1024], proxyauth[1024] = "";
     char path1[MAX_URL_SIZE], sanitized_path[MAX_URL_SIZE + 1];
     char buf[1024], urlbuf[MAX_URL_SIZE];
-    int port, use_proxy, err = 0;
+    int port, use_proxy, err = 0, reused = 0;
     HTTPContext *s = h->priv_data;
 
     av_url_split(proto, sizeof(proto), auth, sizeof(auth),
@@ -273,15 +451,31 @@ static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
     ff_url_join(buf, sizeof(buf), lower_proto, NULL, hostname, port, NULL);
 
     if (!s->hd) {
-        err = ffurl_open_whitelist(&s->hd, buf, AVIO_FLAG_READ_WRITE,
-                                   &h->interrupt_callback, options,
-                                   h->protocol_whitelist, h->protocol_blacklist, h);
+        if (s->connection_pool) {
+            err = reused = http_pool_open(h, buf, options, 1);
+        } else {
+            err = ffurl_open_whitelist(&s->hd, buf, AVIO_FLAG_READ_WRITE,
+                                       &h->interrupt_callback, options,
+                                       h->protocol_whitelist, h->protocol_blacklist, h);
+        }
     }
 
 end:
     freeenv_utf8(env_http_proxy);
-    return err < 0 ? err : http_connect(
-        h, path, local_path, hoststr, auth, proxyauth);
+    if (err < 0)
+        return err;
+
+    s->line_count = 0;
+    err = http_connect(h, path, local_path, hoststr, auth, proxyauth);
+    if (err < 0 && reused > 0 && !s->line_count && err != AVERROR_EXIT) {
+        /* The server may have closed the idle connection meanwhile. */
+        av_log(h, AV_LOG_DEBUG, "Pooled connection failed, opening a new one\n");
+        http_close_cnx(s);
+        err = http_pool_open(h, buf, options, 0);
+        if (err >= 0)
+            err = http_connect(h, path, local_path, hoststr, auth, proxyauth);
+    }
+    return err;
 }
 
 static int http_should_reconnect(HTTPContext *s, int err)
@@ -416,7 +610,7 @@ redo:
         /* restore the offset (http_connect resets it) */
         s->off = off;
 
-        ffurl_closep(&s->hd);
+        http_close_cnx(s);
         goto redo;
     }
 
@@ -424,7 +618,7 @@ redo:
     if (s->http_code == 401) {
         if ((cur_auth_type == HTTP_AUTH_NONE || s->auth_state.stale) &&
             s->auth_state.auth_type != HTTP_AUTH_NONE && auth_attempts < 4) {
-            ffurl_closep(&s->hd);
+            http_release_cnx(h);
             goto redo;
         } else
             goto fail;
@@ -432,7 +626,7 @@ redo:
     if (s->http_code == 407) {
         if ((cur_proxy_auth_type == HTTP_AUTH_NONE || s->proxy_auth_state.stale) &&
             s->proxy_auth_state.auth_type != HTTP_AUTH_NONE && auth_attempts < 4) {
-            ffurl_closep(&s->hd);
+            http_release_cnx(h);
             goto redo;
         } else
             goto fail;
@@ -441,7 +635,7 @@ redo:
          s->http_code == 303 || s->http_code == 307 || s->http_code == 308) &&
         s->new_location) {
         /* url moved, get next */
-        ffurl_closep(&s->hd);
+        http_release_cnx(h);
         if (redirects++ >= MAX_REDIRECTS)
             return AVERROR(EIO);
 
@@ -467,7 +661,7 @@ redo:
 
 fail:
     if (s->hd)
-        ffurl_closep(&s->hd);
+        http_release_cnx(h);
     if (ret < 0)
         return ret;
     return ff_http_averror(s->http_code, AVERROR(EIO));
@@ -510,8 +704,13 @@ int ff_http_do_new_request2(URLContext *h, const char *uri, AVDictionary **opts)
             return ret;
     }
 
-    if (s->willclose)
+    if (s->pool_conn) {
+        /* continue with this connection if it can be reused, or with
+         * another one from the pool */
+        http_release_cnx(h);
+    } else if (s->willclose) {
         return AVERROR_EOF;
+    }
 
     s->end_chunked_post = 0;
     s->chunkend      = 0;
@@ -749,6 +948,9 @@ static int http_open(URLContext *h, const char *uri, int flags,
     if (s->listen) {
         return http_listen(h, uri, flags, options);
     }
+    /* pooled connections are only useful if they are kept alive */
+    if (s->connection_pool)
+        s->multiple_requests = 1;
     ret = http_open_cnx(h, options);
 bail_out:
     if (ret < 0) {
@@ -1207,9 +1409,10 @@ static int process_line(URLContext *h, char *line, int line_count, int *parsed_h
         if (!av_strcasecmp(tag, "Location")) {
             if ((ret = parse_location(s, p)) < 0)
                 return ret;
-        } else if (!av_strcasecmp(tag, "Content-Length") &&
-                   s->filesize == UINT64_MAX) {
-            s->filesize = strtoull(p, NULL, 10);
+        } else if (!av_strcasecmp(tag, "Content-Length")) {
+            s->content_length = strtoull(p, NULL, 10);
+            if (s->filesize == UINT64_MAX)
+                s->filesize = s->content_length;
         } else if (!av_strcasecmp(tag, "Content-Range")) {
             parse_content_range(h, p);
         } else if (!av_strcasecmp(tag, "Accept-Ranges") &&
@@ -1379,6 +1582,8 @@ static int http_read_header(URLContext *h)
     av_freep(&s->new_location);
     s->expires = 0;
     s->chunksize = UINT64_MAX;
+    s->chunkend  = 0;
+    s->content_length = UINT64_MAX;
     s->filesize_from_content_range = UINT64_MAX;
 
     for (;;) {
@@ -1405,6 +1610,14 @@ static int http_read_header(URLContext *h)
             break;
         s->line_count++;
     }
+    /* responses to HEAD requests and 204/304 responses have no body */
+    if ((s->method && !av_strcasecmp(s->method, "HEAD")) ||
+        s->http_code == 204 || s->http_code == 304)
+        s->body_end = s->off;
+    else if (s->chunksize == UINT64_MAX && s->content_length != UINT64_MAX)
+        s->body_end = s->off + s->content_length;
+    else
+        s->body_end = UINT64_MAX;
     if (http_err)
         return http_err;
 
@@ -1644,7 +1857,7 @@ static int http_buf_read(URLContext *h, uint8_t *buf, int size)
             }
             else if (!s->chunksize) {
                 av_log(h, AV_LOG_DEBUG, "Last chunk received, closing conn\n");
-                ffurl_closep(&s->hd);
+                http_close_cnx(s);
                 return 0;
             }
             else if (s->chunksize == UINT64_MAX) {
@@ -1915,8 +2128,9 @@ static int http_shutdown(URLContext *h, int flags)
         ((flags & AVIO_FLAG_READ) && s->chunked_post && s->listen)) {
         ret = ffurl_write(s->hd, footer, sizeof(footer) - 1);
         ret = ret > 0 ? 0 : ret;
-        /* flush the receive buffer when it is write only mode */
-        if (!(flags & AVIO_FLAG_READ)) {
+        /* flush the receive buffer when it is write only mode, pooled
+         * connections read the reply instead before they are reused */
+        if (!(flags & AVIO_FLAG_READ) && !s->pool_conn) {
             char buf[1024];
             int read_ret;
             s->hd->flags |= AVIO_FLAG_NONBLOCK;
@@ -1933,6 +2147,66 @@ static int http_shutdown(URLContext *h, int flags)
     return ret;
 }
 
+/* Return 1 if the response has been read completely and the connection
+ * can be used for another request. */
+static int http_cnx_reusable(HTTPContext *s)
+{
+    if (s->willclose || !s->end_header || s->buf_ptr != s->buf_end)
+        return 0;
+    if (s->off == s->body_end)
+        return 1;
+    return s->chunksize != UINT64_MAX && s->chunkend;
+}
+
+static void http_release_cnx(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+    HTTPPoolConn *conn = s->pool_conn, *evicted;
+    uint8_t buf[4096];
+    int64_t drained = 0;
+
+    /* an upload has to be finished to know where the reply starts */
+    if (!conn || s->pool_max_per_host <= 0 ||
+        ((h->flags & AVIO_FLAG_WRITE) && !s->post_data && !s->end_chunked_post)) {
+        http_close_cnx(s);
+        return;
+    }
+
+    /* read the reply to a finished upload */
+    if (s->end_chunked_post && !s->end_header)
+        http_read_header(h);
+
+    /* skip the rest of a short response body */
+    if (s->end_header && !s->willclose &&
+        (s->chunksize != UINT64_MAX ||
+         (s->body_end != UINT64_MAX && s->body_end - s->off <= POOL_MAX_DRAIN))) {
+        while (!http_cnx_reusable(s) && drained < POOL_MAX_DRAIN) {
+            int ret = http_buf_read(h, buf, sizeof(buf));
+            if (ret <= 0)
+                break;
+            drained += ret;
+        }
+    }
+    if (!http_cnx_reusable(s)) {
+        http_close_cnx(s);
+        return;
+    }
+
+    conn->hd                 = s->hd;
+    conn->interrupt_callback = (AVIOInterruptCB){ 0 };
+    conn->expires            = av_gettime_relative() +
+                               s->pool_idle_timeout * INT64_C(1000000);
+    s->hd        = NULL;
+    s->pool_conn = NULL;
+
+    ff_mutex_lock(&pool_mutex);
+    evicted = pool_evict(conn->key, s->pool_max_per_host - 1);
+    conn->next = pool_idle;
+    pool_idle  = conn;
+    ff_mutex_unlock(&pool_mutex);
+    pool_free_list(evicted);
+}
+
 static int http_close(URLContext *h)
 {
     int ret = 0;
@@ -1948,7 +2222,7 @@ static int http_close(URLContext *h)
         ret = http_shutdown(h, h->flags);
 
     if (s->hd)
-        ffurl_closep(&s->hd);
+        http_release_cnx(h);
     av_dict_free(&s->chained_options);
     av_dict_free(&s->cookie_dict);
     av_dict_free(&s->redirect_cache);
@@ -1961,6 +2235,7 @@ static int64_t http_seek_internal(URLContext *h, int64_t off, int whence, int fo
 {
     HTTPContext *s = h->priv_data;
     URLContext *old_hd = s->hd;
+    HTTPPoolConn *old_pool_conn = s->pool_conn;
     uint64_t old_off = s->off;
     uint8_t old_buf[BUFFER_SIZE];
     int old_buf_size, ret;
@@ -2008,7 +2283,8 @@ static int64_t http_seek_internal(URLContext *h, int64_t off, int whence, int fo
     /* we save the old context in case the seek fails */
     old_buf_size = s->buf_end - s->buf_ptr;
     memcpy(old_buf, s->buf_ptr, old_buf_size);
-    s->hd = NULL;
+    s->hd        = NULL;
+    s->pool_conn = NULL;
 
     /* if it fails, continue on old connection */
     if ((ret = http_open_cnx(h, &options)) < 0) {
@@ -2016,12 +2292,16 @@ static int64_t http_seek_internal(URLContext *h, int64_t off, int whence, int fo
         memcpy(s->buffer, old_buf, old_buf_size);
         s->buf_ptr = s->buffer;
         s->buf_end = s->buffer + old_buf_size;
-        s->hd      = old_hd;
-        s->off     = old_off;
+        s->hd        = old_hd;
+        s->pool_conn = old_pool_conn;
+        s->off       = old_off;
+        /* the response state is lost, do not reuse the connection */
+        s->body_end  = UINT64_MAX;
         return ret;
     }
     av_dict_free(&options);
     ffurl_close(old_hd);
+    pool_conn_free(&old_pool_conn);
     return off;
 }
 
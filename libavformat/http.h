@@ -62,4 +62,9 @@ int ff_http_do_new_request2(URLContext *h, const char *uri, AVDictionary **optio
 
 int ff_http_averror(int status_code, int default_averror);
 
+/**
+ * Close all idle connections of the shared HTTP connection pool.
+ */
+void ff_http_pool_close(void);
+
 #endif /* AVFORMAT_HTTP_H */
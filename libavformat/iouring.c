@@ -0,0 +1,620 @@
+/*
+ * io_uring based file I/O
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * File protocol keeping several reads or writes in flight through io_uring.
+ *
+ * Reading keeps queue_depth blocks of read-ahead queued behind the current
+ * position; writing copies data into blocks that are handed to the kernel
+ * as soon as they are full, so the caller never waits for the disk unless
+ * all blocks are busy. Seeking while writing waits for all queued writes so
+ * that overwrites are ordered after the data they replace.
+ *
+ * If io_uring is unavailable, the same code paths run with synchronous
+ * pread()/pwrite() calls and a single block.
+ */
+
+#define _DEFAULT_SOURCE /* syscall(), MAP_POPULATE */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <linux/io_uring.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/file_open.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "avio.h"
+#include "url.h"
+
+#define FSYNC_USER_DATA UINT64_MAX
+
+enum BlockState {
+    BLOCK_FREE,
+    BLOCK_PENDING,
+    BLOCK_DONE,
+};
+
+typedef struct IOUringBlock {
+    uint8_t *data;
+    int64_t offset;         ///< file offset of data[0]
+    int len;                ///< bytes requested (read) or filled (write)
+    int size;               ///< bytes read, or bytes already written;
+                            ///< requests start at data + size
+    int error;
+    enum BlockState state;
+} IOUringBlock;
+
+typedef struct IOUringContext {
+    const AVClass *class;
+    int queue_depth;
+    int block_size;
+    int64_t fsync_interval;
+    int trunc;
+    int seekable;
+    int use_ring;
+
+    int fd;
+    int write;
+    int64_t pos;            ///< logical position seen by the caller
+    int64_t read_end;       ///< offset of the next read-ahead request
+    int64_t unsynced;       ///< bytes written since the last data sync
+    int sync_pending;       ///< a data sync is queued and not completed
+    int error;              ///< sticky error of an asynchronous write or sync
+
+    IOUringBlock *blocks;
+    int nb_blocks;
+    int cur;                ///< block being filled when writing, or -1
+
+    int ring_fd;            ///< -1 when falling back to synchronous I/O
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned to_submit;
+    int inflight;
+} IOUringContext;
+
+#define OFFSET(x) offsetof(IOUringContext, x)
+#define D AV_OPT_FLAG_DECODING_PARAM
+#define E AV_OPT_FLAG_ENCODING_PARAM
+static const AVOption options[] = {
+    { "queue_depth", "number of blocks kept in flight", OFFSET(queue_depth), AV_OPT_TYPE_INT, { .i64 = 8 }, 1, 256, D|E },
+    { "block_size", "size of each read or write request", OFFSET(block_size), AV_OPT_TYPE_INT, { .i64 = 262144 }, 4096, 64 << 20, D|E },
+    { "fsync_interval", "flush written data to storage every this many bytes, 0 to only rely on close", OFFSET(fsync_interval), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E },
+    { "truncate", "truncate existing files on write", OFFSET(trunc), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, E },
+    { "seekable", "Sets if the file is seekable", OFFSET(seekable), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, 0, D|E },
+    { "io_uring", "use io_uring, synchronous I/O is used if disabled or unavailable", OFFSET(use_ring), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, D|E },
+    { NULL }
+};
+
+static const AVClass iouring_class = {
+    .class_name = "iouring",
+    .item_name  = av_default_item_name,
+    .option     = options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
+static int ring_init(URLContext *h)
+{
+    IOUringContext *c = h->priv_data;
+    struct io_uring_params p = { 0 };
+    int ret;
+
+    /* one entry per block plus one for a data sync */
+    c->ring_fd = syscall(__NR_io_uring_setup, c->nb_blocks + 1, &p);
+    if (c->ring_fd < 0)
+        return AVERROR(errno);
+    /* IORING_OP_READ/WRITE appeared together with this feature */
+    if (!(p.features & IORING_FEAT_RW_CUR_POS))
+        return AVERROR(ENOSYS);
+
+    c->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    c->cq_ring_size = p.cq_off.cqes  + p.cq_entries * sizeof(struct io_uring_cqe);
+    c->sqes_size    = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    c->sq_ring = mmap(NULL, c->sq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, c->ring_fd, IORING_OFF_SQ_RING);
+    if (c->sq_ring == MAP_FAILED)
+        goto fail;
+    c->cq_ring = mmap(NULL, c->cq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, c->ring_fd, IORING_OFF_CQ_RING);
+    if (c->cq_ring == MAP_FAILED)
+        goto fail;
+    c->sqes    = mmap(NULL, c->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, c->ring_fd, IORING_OFF_SQES);
+    if (c->sqes == MAP_FAILED)
+        goto fail;
+
+    c->sq_tail  = (unsigned *)((uint8_t *)c->sq_ring + p.sq_off.tail);
+    c->sq_mask  = (unsigned *)((uint8_t *)c->sq_ring + p.sq_off.ring_mask);
+    c->sq_array = (unsigned *)((uint8_t *)c->sq_ring + p.sq_off.array);
+    c->cq_head  = (unsigned *)((uint8_t *)c->cq_ring + p.cq_off.head);
+    c->cq_tail  = (unsigned *)((uint8_t *)c->cq_ring + p.cq_off.tail);
+    c->cq_mask  = (unsigned *)((uint8_t *)c->cq_ring + p.cq_off.ring_mask);
+    c->cqes     = (struct io_uring_cqe *)((uint8_t *)c->cq_ring + p.cq_off.cqes);
+    return 0;
+
+fail:
+    ret = AVERROR(errno);
+    if (c->sq_ring == MAP_FAILED)
+        c->sq_ring = NULL;
+    if (c->cq_ring == MAP_FAILED)
+        c->cq_ring = NULL;
+    if (c->sqes == MAP_FAILED)
+        c->sqes = NULL;
+    return ret;
+}
+
+static void ring_uninit(IOUringContext *c)
+{
+    if (c->sqes)
+        munmap(c->sqes, c->sqes_size);
+    if (c->cq_ring)
+        munmap(c->cq_ring, c->cq_ring_size);
+    if (c->sq_ring)
+        munmap(c->sq_ring, c->sq_ring_size);
+    if (c->ring_fd >= 0)
+        close(c->ring_fd);
+    c->sqes    = NULL;
+    c->cq_ring = c->sq_ring = NULL;
+    c->ring_fd = -1;
+}
+
+static int ring_enter(IOUringContext *c, unsigned min_complete)
+{
+    while (c->to_submit || min_complete) {
+        int ret = syscall(__NR_io_uring_enter, c->ring_fd, c->to_submit,
+                          min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0,
+                          NULL, 0);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                continue;
+            return AVERROR(errno);
+        }
+        c->to_submit -= ret;
+        if (min_complete)
+            break;
+    }
+    return 0;
+}
+
+static void complete(IOUringContext *c, uint64_t user_data, int res);
+
+/**
+ * Queue a request, or run it right away when there is no ring.
+ *
+ * @param sqe_flags IOSQE_* flags of the request, ignored without a ring
+ */
+static void queue_request(IOUringContext *c, int opcode, uint64_t user_data,
+                          int sqe_flags)
+{
+    IOUringBlock *b = user_data != FSYNC_USER_DATA ? &c->blocks[user_data] : NULL;
+
+    if (c->ring_fd >= 0) {
+        unsigned tail = *c->sq_tail;
+        unsigned idx  = tail & *c->sq_mask;
+        struct io_uring_sqe *sqe = &c->sqes[idx];
+
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode    = opcode;
+        sqe->fd        = c->fd;
+        sqe->flags     = sqe_flags;
+        sqe->user_data = user_data;
+        if (b) {
+            sqe->addr = (uintptr_t)(b->data + b->size);
+            sqe->len  = b->len - b->size;
+            sqe->off  = b->offset + b->size;
+        } else {
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        }
+        c->sq_array[idx] = idx;
+        atomic_store_explicit((_Atomic unsigned *)c->sq_tail, tail + 1,
+                              memory_order_release);
+        c->to_submit++;
+        c->inflight++;
+    } else {
+        int res;
+        if (!b)
+            res = fdatasync(c->fd);
+        else if (c->write)
+            res = pwrite(c->fd, b->data + b->size, b->len - b->size, b->offset + b->size);
+        else
+            res = pread(c->fd, b->data + b->size, b->len - b->size, b->offset + b->size);
+        c->inflight++;
+        complete(c, user_data, res < 0 ? AVERROR(errno) : res);
+    }
+}
+
+static void complete(IOUringContext *c, uint64_t user_data, int res)
+{
+    IOUringBlock *b;
+
+    c->inflight--;
+    if (user_data == FSYNC_USER_DATA) {
+        /* A sync is canceled when the write it is linked to was short or
+         * failed; the failure is reported by the write, and the data is
+         * synced with the next one or on close. */
+        if (res < 0 && res != AVERROR(ECANCELED) && !c->error)
+            c->error = res;
+        c->sync_pending = 0;
+        return;
+    }
+
+    b = &c->blocks[user_data];
+    if (!c->write) {
+        b->size  = FFMAX(res, 0);
+        b->error = FFMIN(res, 0);
+        b->state = BLOCK_DONE;
+        return;
+    }
+
+    if (res <= 0) {
+        if (!c->error)
+            c->error = res ? res : AVERROR(EIO);
+    } else if (b->size + res < b->len) {
+        /* short write, queue the remainder */
+        b->size += res;
+        queue_request(c, IORING_OP_WRITE, user_data, 0);
+        return;
+    }
+    b->state = BLOCK_FREE;
+}
+
+/**
+ * Wait for at least one request to complete and process all completions.
+ */
+static int reap(IOUringContext *c)
+{
+    unsigned head = *c->cq_head, tail;
+    int ret;
+
+    tail = atomic_load_explicit((_Atomic unsigned *)c->cq_tail, memory_order_acquire);
+    if (head == tail) {
+        if ((ret = ring_enter(c, 1)) < 0)
+            return ret;
+        tail = atomic_load_explicit((_Atomic unsigned *)c->cq_tail, memory_order_acquire);
+    }
+    while (head != tail) {
+        const struct io_uring_cqe *cqe = &c->cqes[head & *c->cq_mask];
+        uint64_t user_data = cqe->user_data;
+        int res = cqe->res;
+
+        head++;
+        atomic_store_explicit((_Atomic unsigned *)c->cq_head, head,
+                              memory_order_release);
+        complete(c, user_data, res);
+    }
+    return 0;
+}
+
+static int drain(IOUringContext *c)
+{
+    int ret;
+    if (c->ring_fd >= 0 && (ret = ring_enter(c, 0)) < 0)
+        return ret;
+    while (c->inflight)
+        if ((ret = reap(c)) < 0)
+            return ret;
+    return 0;
+}
+
+static int fill_read_ahead(IOUringContext *c)
+{
+    for (int i = 0; i < c->nb_blocks; i++) {
+        IOUringBlock *b = &c->blocks[i];
+
+        if (b->state == BLOCK_DONE && b->offset + b->len <= c->pos)
+            b->state = BLOCK_FREE;
+        if (b->state != BLOCK_FREE)
+            continue;
+        b->offset   = c->read_end;
+        b->len      = c->block_size;
+        b->size     = 0;
+        b->state    = BLOCK_PENDING;
+        c->read_end += c->block_size;
+        queue_request(c, IORING_OP_READ, i, 0);
+    }
+    return c->ring_fd >= 0 ? ring_enter(c, 0) : 0;
+}
+
+static int restart_read(IOUringContext *c)
+{
+    int ret = drain(c);
+    if (ret < 0)
+        return ret;
+    for (int i = 0; i < c->nb_blocks; i++)
+        c->blocks[i].state = BLOCK_FREE;
+    c->read_end = c->pos;
+    return fill_read_ahead(c);
+}
+
+static IOUringBlock *find_block(IOUringContext *c)
+{
+    for (int i = 0; i < c->nb_blocks; i++) {
+        IOUringBlock *b = &c->blocks[i];
+        if (b->state != BLOCK_FREE &&
+            b->offset <= c->pos && c->pos < b->offset + b->len)
+            return b;
+    }
+    return NULL;
+}
+
+static int iouring_read(URLContext *h, unsigned char *buf, int size)
+{
+    IOUringContext *c = h->priv_data;
+    IOUringBlock *b;
+    int ret;
+
+    while (!(b = find_block(c)) || b->state != BLOCK_DONE ||
+           c->pos >= b->offset + b->size) {
+        if (!b) {
+            ret = restart_read(c);
+        } else if (b->state == BLOCK_PENDING) {
+            ret = reap(c);
+        } else if (b->error < 0) {
+            ret = b->error;
+            b->state = BLOCK_FREE;
+            return ret;
+        } else if (!b->size) {
+            return AVERROR_EOF;
+        } else {
+            /* short read, start again at the current position */
+            b->state = BLOCK_FREE;
+            ret = restart_read(c);
+        }
+        if (ret < 0)
+            return ret;
+    }
+
+    size = FFMIN(size, b->offset + b->size - c->pos);
+    memcpy(buf, b->data + c->pos - b->offset, size);
+    c->pos += size;
+    if (c->pos == b->offset + b->size) {
+        b->state = BLOCK_FREE;
+        if ((ret = fill_read_ahead(c)) < 0)
+            return ret;
+    }
+    return size;
+}
+
+static void submit_write(IOUringContext *c)
+{
+    IOUringBlock *b = &c->blocks[c->cur];
+    int sync;
+
+    c->unsynced += b->len;
+    sync = c->fsync_interval && c->unsynced >= c->fsync_interval &&
+           !c->sync_pending;
+
+    /* The sync is linked to this write only, so it starts once this block
+     * is on disk but neither waits for nor holds back any other write. */
+    b->state = BLOCK_PENDING;
+    queue_request(c, IORING_OP_WRITE, c->cur, sync ? IOSQE_IO_LINK : 0);
+    c->cur = -1;
+
+    if (sync) {
+        c->sync_pending = 1;
+        c->unsynced     = 0;
+        queue_request(c, IORING_OP_FSYNC, FSYNC_USER_DATA, 0);
+    }
+}
+
+static int iouring_write(URLContext *h, const unsigned char *buf, int size)
+{
+    IOUringContext *c = h->priv_data;
+    int written = 0, ret;
+
+    while (written < size) {
+        IOUringBlock *b;
+        int len;
+
+        if (c->error)
+            return c->error;
+
+        if (c->cur < 0) {
+            for (int i = 0; i < c->nb_blocks && c->cur < 0; i++)
+                if (c->blocks[i].state == BLOCK_FREE)
+                    c->cur = i;
+            if (c->cur < 0) {
+                if ((ret = reap(c)) < 0)
+                    return ret;
+                continue;
+            }
+            b = &c->blocks[c->cur];
+            b->offset = c->pos;
+            b->len    = 0;
+            b->size   = 0;
+        }
+        b = &c->blocks[c->cur];
+
+        len = FFMIN(size - written, c->block_size - b->len);
+        memcpy(b->data + b->len, buf + written, len);
+        b->len  += len;
+        c->pos  += len;
+        written += len;
+
+        if (b->len == c->block_size)
+            submit_write(c);
+    }
+    if (c->ring_fd >= 0 && (ret = ring_enter(c, 0)) < 0)
+        return ret;
+    return written;
+}
+
+/**
+ * Hand the partially filled block to the kernel and wait for all writes.
+ */
+static int flush_writes(IOUringContext *c)
+{
+    int ret;
+    if (c->cur >= 0 && c->blocks[c->cur].len)
+        submit_write(c);
+    c->cur = -1;
+    ret = drain(c);
+    return ret < 0 ? ret : c->error;
+}
+
+static int64_t iouring_seek(URLContext *h, int64_t pos, int whence)
+{
+    IOUringContext *c = h->priv_data;
+    struct stat st;
+    int ret;
+
+    if (c->write && (ret = flush_writes(c)) < 0)
+        return ret;
+
+    if (whence == AVSEEK_SIZE || whence == SEEK_END) {
+        if (fstat(c->fd, &st) < 0)
+            return AVERROR(errno);
+        if (whence == AVSEEK_SIZE)
+            return st.st_size;
+        pos += st.st_size;
+    } else if (whence == SEEK_CUR) {
+        pos += c->pos;
+    } else if (whence != SEEK_SET) {
+        return AVERROR(EINVAL);
+    }
+    if (pos < 0)
+        return AVERROR(EINVAL);
+
+    c->pos = pos;
+    return pos;
+}
+
+static int iouring_close(URLContext *h)
+{
+    IOUringContext *c = h->priv_data;
+    int ret = 0;
+
+    if (c->write) {
+        ret = flush_writes(c);
+        if (ret >= 0 && c->fsync_interval && fdatasync(c->fd) < 0)
+            ret = AVERROR(errno);
+    } else {
+        ret = drain(c);
+    }
+    if (ret < 0)
+        av_log(h, AV_LOG_ERROR, "Error finishing I/O: %s\n", av_err2str(ret));
+
+    ring_uninit(c);
+    if (c->blocks)
+        for (int i = 0; i < c->nb_blocks; i++)
+            av_freep(&c->blocks[i].data);
+    av_freep(&c->blocks);
+    if (c->fd >= 0 && close(c->fd) < 0 && ret >= 0)
+        ret = AVERROR(errno);
+    c->fd = -1;
+    return ret;
+}
+
+static int iouring_open(URLContext *h, const char *filename, int flags)
+{
+    IOUringContext *c = h->priv_data;
+    int access, ret;
+    struct stat st;
+
+    c->fd      = -1;
+    c->ring_fd = -1;
+    c->cur     = -1;
+
+    if ((flags & AVIO_FLAG_READ_WRITE) == AVIO_FLAG_READ_WRITE) {
+        av_log(h, AV_LOG_ERROR, "Opening for both reading and writing is not supported\n");
+        return AVERROR(ENOSYS);
+    }
+    c->write = !!(flags & AVIO_FLAG_WRITE);
+
+    av_strstart(filename, "iouring:", &filename);
+
+    access = c->write ? O_CREAT | O_WRONLY | (c->trunc ? O_TRUNC : 0) : O_RDONLY;
+    c->fd = avpriv_open(filename, access, 0666);
+    if (c->fd < 0)
+        return AVERROR(errno);
+
+    if (fstat(c->fd, &st) < 0) {
+        ret = AVERROR(errno);
+        goto fail;
+    }
+    if (!S_ISREG(st.st_mode) && !S_ISBLK(st.st_mode)) {
+        av_log(h, AV_LOG_ERROR, "%s is not a regular file or block device\n", filename);
+        ret = AVERROR(EINVAL);
+        goto fail;
+    }
+
+    c->nb_blocks = c->queue_depth;
+    if (c->use_ring && (ret = ring_init(h)) < 0) {
+        av_log(h, AV_LOG_VERBOSE, "io_uring unavailable (%s), using synchronous I/O\n",
+               av_err2str(ret));
+        ring_uninit(c);
+    }
+    if (c->ring_fd < 0)
+        c->nb_blocks = 1;
+
+    c->blocks = av_calloc(c->nb_blocks, sizeof(*c->blocks));
+    if (!c->blocks) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    for (int i = 0; i < c->nb_blocks; i++) {
+        c->blocks[i].data = av_malloc(c->block_size);
+        if (!c->blocks[i].data) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+    }
+
+    h->min_packet_size = h->max_packet_size = c->block_size;
+    h->is_streamed = c->seekable == 0;
+    return 0;
+
+fail:
+    iouring_close(h);
+    return ret;
+}
+
+static int iouring_get_handle(URLContext *h)
+{
+    IOUringContext *c = h->priv_data;
+    return c->fd;
+}
+
+const URLProtocol ff_iouring_protocol = {
+    .name                = "iouring",
+    .url_open            = iouring_open,
+    .url_read            = iouring_read,
+    .url_write           = iouring_write,
+    .url_seek            = iouring_seek,
+    .url_close           = iouring_close,
+    .url_get_file_handle = iouring_get_handle,
+    .priv_data_size      = sizeof(IOUringContext),
+    .priv_data_class     = &iouring_class,
+    .default_whitelist   = "file,iouring,crypto,data",
+};
@@ -164,6 +164,53 @@ typedef struct MOVIndexRange {
     int64_t end;
 } MOVIndexRange;
 
+/**
+ * Position in the sample tables (stsc/stco/stsz/stts/stss) of a track,
+ * pointing before the sample with number 'sample'.
+ */
+typedef struct MOVSampleCursor {
+    int64_t pos;
+    int64_t dts;
+    unsigned int sample;
+    unsigned int chunk;
+    unsigned int chunk_sample;  ///< number of samples already read from chunk
+    unsigned int stsc_index;
+    unsigned int stts_index;
+    unsigned int stts_sample;
+    unsigned int stss_index;
+    unsigned int stps_index;
+    unsigned int rap_group_index;
+    unsigned int rap_group_sample;
+    unsigned int distance;
+} MOVSampleCursor;
+
+/**
+ * Minimum number of samples between two seek points of a MOVCompactIndex.
+ * Seeking walks the samples from the preceding point, and a point costs
+ * about three times the memory of an index entry.
+ */
+#define MOV_COMPACT_POINT_SPACING 16
+
+/**
+ * Sample index resolved on demand from the sample tables instead of being
+ * expanded into one AVIndexEntry per sample. The AVIndex of the stream only
+ * holds seek points, keyframes starting a chunk or listed in stss/stps that
+ * are at least MOV_COMPACT_POINT_SPACING samples apart; points[] are the
+ * matching cursors.
+ */
+typedef struct MOVCompactIndex {
+    unsigned int nb_samples;
+    int key_off;
+    int is_audio;
+    MOVSampleCursor start;
+    MOVSampleCursor *points;
+    int nb_points;
+    MOVSampleCursor cur;        ///< cursor after entry
+    AVIndexEntry entry;         ///< entry of the current sample
+    MOVSampleCursor prev;
+    AVIndexEntry prev_entry;
+} MOVCompactIndex;
+
 typedef struct MOVStreamContext {
     AVIOContext *pb;
     int refcount;
@@ -204,6 +251,7 @@ typedef struct MOVStreamContext {
     int64_t current_index;
     MOVIndexRange* index_ranges;
     MOVIndexRange* current_index_range;
+    MOVCompactIndex *compact_index;  ///< set if the sample tables are not expanded into the AVIndex
     unsigned int bytes_per_frame;
     unsigned int samples_per_frame;
     int dv_audio_container;
@@ -362,6 +410,7 @@ typedef struct MOVContext {
     int thmb_item_id;
     int64_t idat_offset;
     int interleaved_read;
+    int compact_index;
 } MOVContext;
 
 int ff_mp4_read_descr_len(AVIOContext *pb);
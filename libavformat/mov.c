@@ -4033,6 +4033,184 @@ static int64_t add_ctts_entry(MOVCtts** ctts_data, unsigned int* ctts_count, uns
     return *ctts_count;
 }
 
+static void mov_cursor_enter_chunk(const MOVStreamContext *sc, MOVSampleCursor *c)
+{
+    while (mov_stsc_index_valid(c->stsc_index, sc->stsc_count) &&
+           c->chunk + 1 == sc->stsc_data[c->stsc_index + 1].first)
+        c->stsc_index++;
+    c->pos = sc->chunk_offsets[c->chunk];
+    c->chunk_sample = 0;
+}
+
+static void mov_cursor_init(const MOVStreamContext *sc, MOVSampleCursor *c, int64_t dts)
+{
+    memset(c, 0, sizeof(*c));
+    c->dts = dts;
+    mov_cursor_enter_chunk(sc, c);
+}
+
+/**
+ * Read the index entry of the sample the cursor points to and advance the
+ * cursor to the next sample. This follows the logic mov_build_index() uses
+ * to create the index entries.
+ */
+static int mov_cursor_read(const MOVStreamContext *sc, MOVSampleCursor *c, AVIndexEntry *e)
+{
+    const MOVCompactIndex *ci = sc->compact_index;
+    const int rap_group_present = sc->rap_group_count && sc->rap_group;
+    unsigned int sample_size;
+    int keyframe = 0;
+
+    if (c->sample >= ci->nb_samples)
+        return AVERROR_EOF;
+    while (c->chunk_sample >= sc->stsc_data[c->stsc_index].count) {
+        if (++c->chunk >= sc->chunk_count)
+            return AVERROR_EOF;
+        mov_cursor_enter_chunk(sc, c);
+    }
+
+    if (!sc->keyframe_absent && (!sc->keyframe_count || c->sample + ci->key_off == sc->keyframes[c->stss_index])) {
+        keyframe = 1;
+        if (c->stss_index + 1 < sc->keyframe_count)
+            c->stss_index++;
+    } else if (sc->stps_count && c->sample + ci->key_off == sc->stps_data[c->stps_index]) {
+        keyframe = 1;
+        if (c->stps_index + 1 < sc->stps_count)
+            c->stps_index++;
+    }
+    if (rap_group_present && c->rap_group_index < sc->rap_group_count) {
+        if (sc->rap_group[c->rap_group_index].index > 0)
+            keyframe = 1;
+        if (++c->rap_group_sample == sc->rap_group[c->rap_group_index].count) {
+            c->rap_group_sample = 0;
+            c->rap_group_index++;
+        }
+    }
+    if (sc->keyframe_absent
+        && !sc->stps_count
+        && !rap_group_present
+        && (ci->is_audio || (c->chunk == 0 && c->chunk_sample == 0)))
+         keyframe = 1;
+    if (keyframe)
+        c->distance = 0;
+    sample_size = sc->stsz_sample_size > 0 ? sc->stsz_sample_size : sc->sample_sizes[c->sample];
+    if (c->pos > INT64_MAX - sample_size)
+        return AVERROR_INVALIDDATA;
+
+    e->pos          = c->pos;
+    e->timestamp    = c->dts;
+    e->size         = sample_size;
+    e->min_distance = c->distance;
+    e->flags        = keyframe ? AVINDEX_KEYFRAME : 0;
+
+    c->pos += sample_size;
+    c->dts += sc->stts_data[c->stts_index].duration;
+    c->distance++;
+    c->stts_sample++;
+    c->sample++;
+    c->chunk_sample++;
+    if (c->stts_index + 1 < sc->stts_count && c->stts_sample == sc->stts_data[c->stts_index].count) {
+        c->stts_sample = 0;
+        c->stts_index++;
+    }
+    return 0;
+}
+
+/**
+ * Advance the cursor by n samples of the current chunk, without updating the
+ * keyframe state. Only usable if all samples are keyframes.
+ */
+static void mov_cursor_skip(const MOVStreamContext *sc, MOVSampleCursor *c, unsigned int n)
+{
+    if (sc->stsz_sample_size > 0) {
+        c->pos += (int64_t)n * sc->stsz_sample_size;
+    } else {
+        for (unsigned int i = 0; i < n; i++)
+            c->pos += sc->sample_sizes[c->sample + i];
+    }
+    c->sample       += n;
+    c->chunk_sample += n;
+    c->distance     += n;
+    while (n) {
+        const MOVStts *stts = &sc->stts_data[c->stts_index];
+        unsigned int step = n;
+
+        if (c->stts_index + 1 < sc->stts_count && c->stts_sample < stts->count)
+            step = FFMIN(n, stts->count - c->stts_sample);
+        c->dts         += (int64_t)step * stts->duration;
+        c->stts_sample += step;
+        n              -= step;
+        if (c->stts_index + 1 < sc->stts_count && c->stts_sample == stts->count) {
+            c->stts_sample = 0;
+            c->stts_index++;
+        }
+    }
+}
+
+/**
+ * Position a cursor at the given sample, starting from the closest
+ * preceding point of the sparse index, and read its entry.
+ */
+static int mov_cursor_seek(const MOVStreamContext *sc, unsigned int sample,
+                           MOVSampleCursor *c, AVIndexEntry *e)
+{
+    const MOVCompactIndex *ci = sc->compact_index;
+    int a = -1, b = ci->nb_points;
+    int ret;
+
+    if (sample >= ci->nb_samples)
+        return AVERROR_EOF;
+
+    while (b - a > 1) {
+        int m = (a + b) >> 1;
+        if (ci->points[m].sample <= sample)
+            a = m;
+        else
+            b = m;
+    }
+    *c = a >= 0 ? ci->points[a] : ci->start;
+    do {
+        ret = mov_cursor_read(sc, c, e);
+        if (ret < 0)
+            return ret;
+    } while (c->sample <= sample);
+    return 0;
+}
+
+/**
+ * Get the index entry of the given sample.
+ */
+static int mov_get_sample_entry(AVStream *st, int sample, AVIndexEntry *e)
+{
+    const MOVStreamContext *sc = st->priv_data;
+    const FFStream *const sti = ffstream(st);
+
+    if (sc->compact_index) {
+        MOVSampleCursor c;
+        return mov_cursor_seek(sc, sample, &c, e);
+    }
+    if (sample < 0 || sample >= sti->nb_index_entries)
+        return AVERROR_EOF;
+    *e = sti->index_entries[sample];
+    return 0;
+}
+
+/**
+ * Get the index entry of the current sample of the stream,
+ * NULL if all samples have been read.
+ */
+static AVIndexEntry *mov_get_current_entry(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+
+    if (sc->compact_index)
+        return sc->current_sample < sc->compact_index->nb_samples ?
+               &sc->compact_index->entry : NULL;
+    return sc->current_sample < sti->nb_index_entries ?
+           &sti->index_entries[sc->current_sample] : NULL;
+}
+
 #define MAX_REORDER_DELAY 16
 static void mov_estimate_video_delay(MOVContext *c, AVStream* st)
 {
@@ -4043,21 +4221,36 @@ static void mov_estimate_video_delay(MOVContext *c, AVStream* st)
     int64_t pts_buf[MAX_REORDER_DELAY + 1]; // Circular buffer to sort pts.
     int buf_start = 0;
     int j, r, num_swaps;
+    MOVSampleCursor cursor;
+    AVIndexEntry entry;
+    int64_t nb_entries = sti->nb_index_entries;
 
     for (j = 0; j < MAX_REORDER_DELAY + 1; j++)
         pts_buf[j] = INT64_MIN;
 
+    if (msc->compact_index) {
+        cursor     = msc->compact_index->start;
+        nb_entries = msc->compact_index->nb_samples;
+    }
+
     if (st->codecpar->video_delay <= 0 && msc->ctts_data &&
         st->codecpar->codec_id == AV_CODEC_ID_H264) {
         st->codecpar->video_delay = 0;
-        for (int ind = 0; ind < sti->nb_index_entries && ctts_ind < msc->ctts_count; ++ind) {
+        for (int64_t ind = 0; ind < nb_entries && ctts_ind < msc->ctts_count; ++ind) {
+            const AVIndexEntry *e = &entry;
+
+            if (!msc->compact_index)
+                e = &sti->index_entries[ind];
+            else if (mov_cursor_read(msc, &cursor, &entry) < 0)
+                break;
+
             // Point j to the last elem of the buffer and insert the current pts there.
             j = buf_start;
             buf_start = (buf_start + 1);
             if (buf_start == MAX_REORDER_DELAY + 1)
                 buf_start = 0;
 
-            pts_buf[j] = sti->index_entries[ind].timestamp + msc->ctts_data[ctts_ind].duration;
+            pts_buf[j] = e->timestamp + msc->ctts_data[ctts_ind].duration;
 
             // The timestamps that are already in the sorted buffer, and are greater than the
             // current pts, are exactly the timestamps that need to be buffered to output PTS
@@ -4092,6 +4285,13 @@ static void mov_estimate_video_delay(MOVContext *c, AVStream* st)
 
 static void mov_current_sample_inc(MOVStreamContext *sc)
 {
+    MOVCompactIndex *ci = sc->compact_index;
+
+    if (ci) {
+        ci->prev       = ci->cur;
+        ci->prev_entry = ci->entry;
+        mov_cursor_read(sc, &ci->cur, &ci->entry);
+    }
     sc->current_sample++;
     sc->current_index++;
     if (sc->index_ranges &&
@@ -4104,6 +4304,12 @@ static void mov_current_sample_inc(MOVStreamContext *sc)
 
 static void mov_current_sample_dec(MOVStreamContext *sc)
 {
+    MOVCompactIndex *ci = sc->compact_index;
+
+    if (ci) {
+        ci->cur   = ci->prev;
+        ci->entry = ci->prev_entry;
+    }
     sc->current_sample--;
     sc->current_index--;
     if (sc->index_ranges &&
@@ -4116,8 +4322,14 @@ static void mov_current_sample_dec(MOVStreamContext *sc)
 
 static void mov_current_sample_set(MOVStreamContext *sc, int current_sample)
 {
+    MOVCompactIndex *ci = sc->compact_index;
     int64_t range_size;
 
+    if (ci) {
+        mov_cursor_seek(sc, current_sample, &ci->cur, &ci->entry);
+        ci->prev       = ci->cur;
+        ci->prev_entry = ci->entry;
+    }
     sc->current_sample = current_sample;
     sc->current_index = current_sample;
     if (!sc->index_ranges) {
@@ -4518,6 +4730,236 @@ static int build_open_gop_key_points(AVStream *st)
     return 0;
 }
 
+/**
+ * Expand ctts entries such that we have a 1-1 mapping with samples.
+ */
+static int mov_expand_ctts(MOVStreamContext *sc)
+{
+    MOVCtts *ctts_data_old = sc->ctts_data;
+    unsigned int ctts_count_old = sc->ctts_count;
+
+    if (!ctts_data_old)
+        return 0;
+    if (sc->sample_count >= UINT_MAX / sizeof(*sc->ctts_data))
+        return AVERROR(ENOMEM);
+    sc->ctts_count = 0;
+    sc->ctts_allocated_size = 0;
+    sc->ctts_data = av_fast_realloc(NULL, &sc->ctts_allocated_size,
+                            sc->sample_count * sizeof(*sc->ctts_data));
+    if (!sc->ctts_data) {
+        av_free(ctts_data_old);
+        return AVERROR(ENOMEM);
+    }
+
+    memset((uint8_t*)(sc->ctts_data), 0, sc->ctts_allocated_size);
+
+    for (unsigned int i = 0; i < ctts_count_old &&
+                sc->ctts_count < sc->sample_count; i++)
+        for (unsigned int j = 0; j < ctts_data_old[i].count &&
+                    sc->ctts_count < sc->sample_count; j++)
+            add_ctts_entry(&sc->ctts_data, &sc->ctts_count,
+                           &sc->ctts_allocated_size, 1,
+                           ctts_data_old[i].duration);
+    av_free(ctts_data_old);
+    return 0;
+}
+
+/**
+ * Check whether the samples of a track can be indexed with a MOVCompactIndex.
+ *
+ * @return number of samples to index, 0 if the full index must be built
+ */
+static unsigned int mov_compact_index_samples(MOVContext *mov, AVStream *st,
+                                              uint64_t *stream_size)
+{
+    MOVStreamContext *sc = st->priv_data;
+    unsigned int stsc_index = 0, sample = 0, edit_start_index = 0;
+    uint64_t size = 0;
+
+    if (!mov->compact_index ||
+        (st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO &&
+         st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO) ||
+        mov->trex_count || mov->frag_index.nb_items || sc->iamf ||
+        ffstream(st)->nb_index_entries ||
+        !sc->sample_count || !sc->chunk_count || !sc->stsc_count || !sc->stts_count)
+        return 0;
+    /* uncompressed audio is indexed per chunk */
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+        sc->stts_count == 1 && sc->stts_data[0].duration == 1)
+        return 0;
+    /* samples of other sample descriptions would have to be skipped */
+    if (sc->pseudo_stream_id != -1)
+        for (unsigned int i = 0; i < sc->stsc_count; i++)
+            if (sc->stsc_data[i].id - 1 != sc->pseudo_stream_id)
+                return 0;
+    /* edit lists are applied as without advanced_editlist, which does not
+     * support multiple edits */
+    for (unsigned int i = 0; i < sc->elst_count; i++) {
+        const MOVElst *e = &sc->elst_data[i];
+        if (i == 0 && e->time == -1)
+            edit_start_index = 1;
+        else if (i != edit_start_index || e->time < 0)
+            return 0;
+    }
+
+    for (unsigned int i = 0; i < sc->chunk_count && sample < sc->sample_count; i++) {
+        int64_t next_offset = i+1 < sc->chunk_count ? sc->chunk_offsets[i+1] : INT64_MAX;
+        int64_t current_offset = sc->chunk_offsets[i];
+        unsigned int count;
+        uint64_t chunk_size = 0;
+
+        while (mov_stsc_index_valid(stsc_index, sc->stsc_count) &&
+            i + 1 == sc->stsc_data[stsc_index + 1].first)
+            stsc_index++;
+        count = FFMIN(sc->stsc_data[stsc_index].count, sc->sample_count - sample);
+
+        /* the invalid stsz sample size handling of mov_build_index()
+         * applies from the middle of the track */
+        if (next_offset > current_offset && sc->sample_size>0 && sc->sample_size < sc->stsz_sample_size &&
+            sc->stsc_data[stsc_index].count * (int64_t)sc->stsz_sample_size > next_offset - current_offset)
+            return 0;
+        if (sc->stsz_sample_size>0 && sc->stsz_sample_size < sc->sample_size)
+            return 0;
+
+        if (sc->stsz_sample_size > 0) {
+            if (sc->stsz_sample_size > 0x3FFFFFFF)
+                return 0;
+            chunk_size = (uint64_t)count * sc->stsz_sample_size;
+        } else {
+            for (unsigned int j = 0; j < count; j++) {
+                if (sc->sample_sizes[sample + j] > 0x3FFFFFFF)
+                    return 0;
+                chunk_size += sc->sample_sizes[sample + j];
+            }
+        }
+        if (current_offset < 0 || chunk_size > INT64_MAX - current_offset)
+            return 0;
+        size   += chunk_size;
+        sample += count;
+    }
+    *stream_size = size;
+    return sample;
+}
+
+static int mov_build_compact_index(MOVContext *mov, AVStream *st, int64_t current_dts,
+                                   unsigned int nb_samples, uint64_t stream_size)
+{
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    const int rap_group_present = sc->rap_group_count && sc->rap_group;
+    MOVCompactIndex *ci;
+    MOVSampleCursor c;
+    AVIndexEntry e, *entries;
+    unsigned int last_chunk = UINT_MAX, next_point = 0;
+    int all_key, nb_points = 0;
+    /* at most one seek point per chunk and per listed sync sample, and no
+     * more than the spacing allows */
+    size_t max_points = FFMIN((size_t)sc->chunk_count + sc->keyframe_count + sc->stps_count,
+                              nb_samples / MOV_COMPACT_POINT_SPACING + 1);
+
+    ci = av_mallocz(sizeof(*ci));
+    if (!ci)
+        return AVERROR(ENOMEM);
+    ci->nb_samples = nb_samples;
+    ci->key_off    = (sc->keyframe_count && sc->keyframes[0] > 0) || (sc->stps_count && sc->stps_data[0] > 0);
+    ci->is_audio   = st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO;
+    mov_cursor_init(sc, &ci->start, current_dts);
+    sc->compact_index = ci;
+
+    ci->points = av_malloc_array(max_points, sizeof(*ci->points));
+    entries    = av_malloc_array(max_points, sizeof(*entries));
+    if (!ci->points || !entries)
+        goto fail;
+
+    /* When every sample is a keyframe, the seek points can be found without
+     * reading the samples of the chunks. */
+    all_key = !sc->stps_count && !rap_group_present &&
+              (sc->keyframe_absent ? ci->is_audio : !sc->keyframe_count);
+
+    c = ci->start;
+    for (;;) {
+        MOVSampleCursor point = c;
+        if (mov_cursor_read(sc, &c, &e) < 0)
+            break;
+        if ((e.flags & AVINDEX_KEYFRAME) && point.sample >= next_point &&
+            (c.chunk != last_chunk || c.stss_index != point.stss_index ||
+             c.stps_index != point.stps_index) && nb_points < max_points) {
+            ci->points[nb_points] = point;
+            entries[nb_points++]  = e;
+            last_chunk = c.chunk;
+            next_point = point.sample + MOV_COMPACT_POINT_SPACING;
+        }
+        if (all_key)
+            mov_cursor_skip(sc, &c, FFMIN(sc->stsc_data[c.stsc_index].count - c.chunk_sample,
+                                          nb_samples - c.sample));
+    }
+    ci->nb_points = nb_points;
+    sti->index_entries = entries;
+    sti->nb_index_entries = nb_points;
+    sti->index_entries_allocated_size = max_points * sizeof(*entries);
+
+    av_log(mov->fc, AV_LOG_DEBUG, "stream %d: compact index of %u samples, %d seek points\n",
+           st->index, nb_samples, nb_points);
+
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+        c = ci->start;
+        for (int i = 0; i < 99 && mov_cursor_read(sc, &c, &e) >= 0; i++)
+            ff_rfps_add_frame(mov->fc, st, e.timestamp);
+    }
+    if (st->duration > 0)
+        st->codecpar->bit_rate = stream_size*8*sc->time_scale/st->duration;
+
+    ci->cur = ci->start;
+    mov_cursor_read(sc, &ci->cur, &ci->entry);
+    ci->prev       = ci->cur;
+    ci->prev_entry = ci->entry;
+    return 0;
+
+fail:
+    av_freep(&ci->points);
+    av_freep(&sc->compact_index);
+    av_free(entries);
+    return AVERROR(ENOMEM);
+}
+
+/**
+ * Replace the compact index by one index entry per sample, as needed to
+ * merge the samples of fragments.
+ */
+static int mov_expand_compact_index(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    FFStream *const sti = ffstream(st);
+    MOVCompactIndex *ci = sc->compact_index;
+    const unsigned int nb_samples = ci->nb_samples;
+    MOVSampleCursor c = ci->start;
+    AVIndexEntry *entries;
+    unsigned int nb = 0;
+    int ret;
+
+    entries = av_malloc_array(nb_samples, sizeof(*entries));
+    if (!entries)
+        return AVERROR(ENOMEM);
+    while (nb < nb_samples && mov_cursor_read(sc, &c, &entries[nb]) >= 0)
+        nb++;
+
+    av_freep(&ci->points);
+    av_freep(&sc->compact_index);
+    av_free(sti->index_entries);
+    sti->index_entries = entries;
+    sti->nb_index_entries = nb;
+    sti->index_entries_allocated_size = nb_samples * sizeof(*entries);
+
+    ret = mov_expand_ctts(sc);
+    if (ret < 0)
+        return ret;
+    if (sc->ctts_data) {
+        sc->ctts_index  = sc->current_sample;
+        sc->ctts_sample = 0;
+    }
+    return 0;
+}
+
 static void mov_build_index(MOVContext *mov, AVStream *st)
 {
     MOVStreamContext *sc = st->priv_data;
@@ -4530,13 +4972,15 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
     unsigned int stps_index = 0;
     unsigned int i, j;
     uint64_t stream_size = 0;
-    MOVCtts *ctts_data_old = sc->ctts_data;
-    unsigned int ctts_count_old = sc->ctts_count;
+    unsigned int compact_samples;
+    AVIndexEntry first;
 
     int ret = build_open_gop_key_points(st);
     if (ret < 0)
         return;
 
+    compact_samples = mov_compact_index_samples(mov, st, &stream_size);
+
     if (sc->elst_count) {
         int i, edit_start_index = 0, multiple_edits = 0;
         int64_t empty_duration = 0; // empty duration of the first edit list entry
@@ -4576,18 +5020,22 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
 
             sc->time_offset = start_time -  (uint64_t)empty_duration;
             sc->min_corrected_pts = start_time;
-            if (!mov->advanced_editlist)
+            if (!mov->advanced_editlist || compact_samples)
                 current_dts = -sc->time_offset;
         }
 
-        if (!multiple_edits && !mov->advanced_editlist &&
+        if (!multiple_edits && (!mov->advanced_editlist || compact_samples) &&
             st->codecpar->codec_id == AV_CODEC_ID_AAC && start_time > 0)
             sc->start_pad = start_time;
     }
 
+    if (compact_samples) {
+        if (mov_build_compact_index(mov, st, current_dts - sc->dts_shift,
+                                    compact_samples, stream_size) < 0)
+            return;
     /* only use old uncompressed audio chunk demuxing when stts specifies it */
-    if (!(st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
-          sc->stts_count == 1 && sc->stts_data[0].duration == 1)) {
+    } else if (!(st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+                 sc->stts_count == 1 && sc->stts_data[0].duration == 1)) {
         unsigned int current_sample = 0;
         unsigned int stts_sample = 0;
         unsigned int sample_size;
@@ -4611,30 +5059,8 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
         }
         sti->index_entries_allocated_size = (sti->nb_index_entries + sc->sample_count) * sizeof(*sti->index_entries);
 
-        if (ctts_data_old) {
-            // Expand ctts entries such that we have a 1-1 mapping with samples
-            if (sc->sample_count >= UINT_MAX / sizeof(*sc->ctts_data))
-                return;
-            sc->ctts_count = 0;
-            sc->ctts_allocated_size = 0;
-            sc->ctts_data = av_fast_realloc(NULL, &sc->ctts_allocated_size,
-                                    sc->sample_count * sizeof(*sc->ctts_data));
-            if (!sc->ctts_data) {
-                av_free(ctts_data_old);
-                return;
-            }
-
-            memset((uint8_t*)(sc->ctts_data), 0, sc->ctts_allocated_size);
-
-            for (i = 0; i < ctts_count_old &&
-                        sc->ctts_count < sc->sample_count; i++)
-                for (j = 0; j < ctts_data_old[i].count &&
-                            sc->ctts_count < sc->sample_count; j++)
-                    add_ctts_entry(&sc->ctts_data, &sc->ctts_count,
-                                   &sc->ctts_allocated_size, 1,
-                                   ctts_data_old[i].duration);
-            av_free(ctts_data_old);
-        }
+        if (mov_expand_ctts(sc) < 0)
+            return;
 
         for (i = 0; i < sc->chunk_count; i++) {
             int64_t next_offset = i+1 < sc->chunk_count ? sc->chunk_offsets[i+1] : INT64_MAX;
@@ -4830,14 +5256,15 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
         }
     }
 
-    if (!mov->ignore_editlist && mov->advanced_editlist) {
+    if (!mov->ignore_editlist && mov->advanced_editlist && !sc->compact_index) {
         // Fix index according to edit lists.
         mov_fix_index(mov, st);
     }
 
     // Update start time of the stream.
-    if (st->start_time == AV_NOPTS_VALUE && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && sti->nb_index_entries > 0) {
-        st->start_time = sti->index_entries[0].timestamp + sc->dts_shift;
+    if (st->start_time == AV_NOPTS_VALUE && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO &&
+        mov_get_sample_entry(st, 0, &first) >= 0) {
+        st->start_time = first.timestamp + sc->dts_shift;
         if (sc->ctts_data) {
             st->start_time += sc->ctts_data[0].duration;
         }
@@ -5148,14 +5575,16 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         && sc->time_scale == st->codecpar->sample_rate) {
             ffstream(st)->need_parsing = AVSTREAM_PARSE_FULL;
     }
-    /* Do not need those anymore. */
-    av_freep(&sc->chunk_offsets);
-    av_freep(&sc->sample_sizes);
-    av_freep(&sc->keyframes);
-    av_freep(&sc->stts_data);
-    av_freep(&sc->stps_data);
+    /* Do not need those anymore, unless samples are read from them. */
+    if (!sc->compact_index) {
+        av_freep(&sc->chunk_offsets);
+        av_freep(&sc->sample_sizes);
+        av_freep(&sc->keyframes);
+        av_freep(&sc->stts_data);
+        av_freep(&sc->stps_data);
+        av_freep(&sc->rap_group);
+    }
     av_freep(&sc->elst_data);
-    av_freep(&sc->rap_group);
     av_freep(&sc->sync_group);
     av_freep(&sc->sgpd_sync);
 
@@ -5659,6 +6088,12 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     if (sc->pseudo_stream_id+1 != frag->stsd_id && sc->pseudo_stream_id != -1)
         return 0;
 
+    if (sc->compact_index) {
+        int ret = mov_expand_compact_index(st);
+        if (ret < 0)
+            return ret;
+    }
+
     // Find the next frag_index index that has a valid index_entry for
     // the current track_id.
     //
@@ -9393,6 +9828,7 @@ static void mov_read_chapters(AVFormatContext *s)
     for (j = 0; j < mov->nb_chapter_tracks; j++) {
         AVStream *st = NULL;
         FFStream *sti = NULL;
+        AVIndexEntry first;
         chapter_track = mov->chapter_tracks[j];
         for (i = 0; i < s->nb_streams; i++) {
             sc = mov->fc->streams[i]->priv_data;
@@ -9412,21 +9848,22 @@ static void mov_read_chapters(AVFormatContext *s)
 
         if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
             st->disposition |= AV_DISPOSITION_ATTACHED_PIC | AV_DISPOSITION_TIMED_THUMBNAILS;
-            if (!st->attached_pic.data && sti->nb_index_entries) {
+            if (!st->attached_pic.data && mov_get_sample_entry(st, 0, &first) >= 0) {
                 // Retrieve the first frame, if possible
-                AVIndexEntry *sample = &sti->index_entries[0];
-                if (avio_seek(sc->pb, sample->pos, SEEK_SET) != sample->pos) {
+                if (avio_seek(sc->pb, first.pos, SEEK_SET) != first.pos) {
                     av_log(s, AV_LOG_ERROR, "Failed to retrieve first frame\n");
                     goto finish;
                 }
 
-                if (ff_add_attached_pic(s, st, sc->pb, NULL, sample->size) < 0)
+                if (ff_add_attached_pic(s, st, sc->pb, NULL, first.size) < 0)
                     goto finish;
             }
         } else {
             st->codecpar->codec_type = AVMEDIA_TYPE_DATA;
             st->codecpar->codec_id = AV_CODEC_ID_BIN_DATA;
             st->discard = AVDISCARD_ALL;
+            if (sc->compact_index && mov_expand_compact_index(st) < 0)
+                goto finish;
             for (int i = 0; i < sti->nb_index_entries; i++) {
                 AVIndexEntry *sample = &sti->index_entries[i];
                 int64_t end = i+1 < sti->nb_index_entries ? sti->index_entries[i+1].timestamp : st->duration;
@@ -9617,6 +10054,9 @@ static void mov_free_stream_context(AVFormatContext *s, AVStream *st)
     av_freep(&sc->open_key_samples);
     av_freep(&sc->display_matrix);
     av_freep(&sc->index_ranges);
+    if (sc->compact_index)
+        av_freep(&sc->compact_index->points);
+    av_freep(&sc->compact_index);
 
     if (sc->extradata)
         for (int i = 0; i < sc->stsd_count; i++)
@@ -10377,10 +10817,9 @@ static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
     int no_interleave = !mov->interleaved_read || !(s->pb->seekable & AVIO_SEEKABLE_NORMAL);
     for (i = 0; i < s->nb_streams; i++) {
         AVStream *avst = s->streams[i];
-        FFStream *const avsti = ffstream(avst);
         MOVStreamContext *msc = avst->priv_data;
-        if (msc->pb && msc->current_sample < avsti->nb_index_entries) {
-            AVIndexEntry *current_sample = &avsti->index_entries[msc->current_sample];
+        AVIndexEntry *current_sample;
+        if (msc->pb && (current_sample = mov_get_current_entry(avst))) {
             int64_t dts = av_rescale(current_sample->timestamp, AV_TIME_BASE, msc->time_scale);
             uint64_t dtsdiff = best_dts > dts ? best_dts - (uint64_t)dts : ((uint64_t)dts - best_dts);
             av_log(s, AV_LOG_TRACE, "stream %d, sample %d, dts %"PRId64"\n", i, msc->current_sample, dts);
@@ -10506,8 +10945,8 @@ static int mov_finalize_packet(AVFormatContext *s, AVStream *st, AVIndexEntry *s
             sc->ctts_sample = 0;
         }
     } else {
-        int64_t next_dts = (sc->current_sample < ffstream(st)->nb_index_entries) ?
-            ffstream(st)->index_entries[sc->current_sample].timestamp : st->duration;
+        const AVIndexEntry *next = mov_get_current_entry(st);
+        int64_t next_dts = next ? next->timestamp : st->duration;
 
         if (next_dts >= pkt->dts)
             pkt->duration = next_dts - pkt->dts;
@@ -10566,6 +11005,8 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
     /* must be done just before reading, to avoid infinite loop on sample */
     current_index = sc->current_index;
     mov_current_sample_inc(sc);
+    if (sc->compact_index)
+        sample = &sc->compact_index->prev_entry;
 
     if (mov->next_root_atom) {
         sample->pos = FFMIN(sample->pos, mov->next_root_atom);
@@ -10710,16 +11151,16 @@ static int is_open_key_sample(const MOVStreamContext *sc, int sample)
 static int can_seek_to_key_sample(AVStream *st, int sample, int64_t requested_pts)
 {
     MOVStreamContext *sc = st->priv_data;
-    FFStream *const sti = ffstream(st);
+    AVIndexEntry e;
     int64_t key_sample_dts, key_sample_pts;
 
     if (st->codecpar->codec_id != AV_CODEC_ID_HEVC)
         return 1;
 
-    if (sample >= sc->sample_offsets_count)
+    if (sample >= sc->sample_offsets_count || mov_get_sample_entry(st, sample, &e) < 0)
         return 1;
 
-    key_sample_dts = sti->index_entries[sample].timestamp;
+    key_sample_dts = e.timestamp;
     key_sample_pts = key_sample_dts + sc->sample_offsets[sample] + sc->dts_shift;
 
     /*
@@ -10733,11 +11174,48 @@ static int can_seek_to_key_sample(AVStream *st, int sample, int64_t requested_pt
     return 1;
 }
 
-static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp, int flags)
+/**
+ * Search the sample of a stream for the given timestamp and flags, like
+ * av_index_search_timestamp() does with the full index.
+ */
+static int mov_search_timestamp(AVStream *st, int64_t wanted_timestamp, int flags)
 {
     MOVStreamContext *sc = st->priv_data;
     FFStream *const sti = ffstream(st);
+    MOVCompactIndex *ci = sc->compact_index;
+    MOVSampleCursor c;
+    AVIndexEntry e;
+    int backward = flags & AVSEEK_FLAG_BACKWARD;
+    int any = flags & AVSEEK_FLAG_ANY;
+    int index, sample = -1;
+
+    if (!ci)
+        return av_index_search_timestamp(st, wanted_timestamp, flags);
+
+    /* walk the samples from the last seek point before the timestamp */
+    index = ff_index_search_timestamp(sti->index_entries, sti->nb_index_entries,
+                                      wanted_timestamp, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_ANY);
+    c = index >= 0 ? ci->points[index] : ci->start;
+    while (mov_cursor_read(sc, &c, &e) >= 0) {
+        if (backward) {
+            if (e.timestamp > wanted_timestamp)
+                break;
+            if (any || (e.flags & AVINDEX_KEYFRAME))
+                sample = c.sample - 1;
+        } else if (e.timestamp >= wanted_timestamp &&
+                   (any || (e.flags & AVINDEX_KEYFRAME))) {
+            sample = c.sample - 1;
+            break;
+        }
+    }
+    return sample;
+}
+
+static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp, int flags)
+{
+    MOVStreamContext *sc = st->priv_data;
     int sample, time_sample, ret, next_ts, requested_sample;
+    AVIndexEntry first;
     unsigned int i;
 
     // Here we consider timestamp to be PTS, hence try to offset it so that we
@@ -10749,9 +11227,9 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
         return ret;
 
     for (;;) {
-        sample = av_index_search_timestamp(st, timestamp, flags);
+        sample = mov_search_timestamp(st, timestamp, flags);
         av_log(s, AV_LOG_TRACE, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
-        if (sample < 0 && sti->nb_index_entries && timestamp < sti->index_entries[0].timestamp)
+        if (sample < 0 && mov_get_sample_entry(st, 0, &first) >= 0 && timestamp < first.timestamp)
             sample = 0;
         if (sample < 0) /* not sure what to do */
             return AVERROR_INVALIDDATA;
@@ -10760,7 +11238,7 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
             break;
 
         next_ts = timestamp - FFMAX(sc->min_sample_duration, 1);
-        requested_sample = av_index_search_timestamp(st, next_ts, flags);
+        requested_sample = mov_search_timestamp(st, next_ts, flags);
 
         // If we've reached a different sample trying to find a good pts to
         // seek to, give up searching because we'll end up seeking back to
@@ -10808,13 +11286,16 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
 static int64_t mov_get_skip_samples(AVStream *st, int sample)
 {
     MOVStreamContext *sc = st->priv_data;
-    FFStream *const sti = ffstream(st);
-    int64_t first_ts = sti->index_entries[0].timestamp;
-    int64_t ts = sti->index_entries[sample].timestamp;
+    AVIndexEntry first, e;
+    int64_t first_ts, ts;
     int64_t off;
 
-    if (st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
+    if (st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO ||
+        mov_get_sample_entry(st, 0, &first) < 0 ||
+        mov_get_sample_entry(st, sample, &e) < 0)
         return 0;
+    first_ts = first.timestamp;
+    ts = e.timestamp;
 
     /* compute skip samples according to stream start_pad, seek ts and first ts */
     off = av_rescale_q(ts - first_ts, st->time_base,
@@ -10827,6 +11308,7 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
     MOVContext *mc = s->priv_data;
     AVStream *st;
     FFStream *sti;
+    AVIndexEntry e;
     int sample;
     int i;
 
@@ -10841,7 +11323,10 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
 
     if (mc->seek_individually) {
         /* adjust seek timestamp to found sample timestamp */
-        int64_t seek_timestamp = sti->index_entries[sample].timestamp;
+        int64_t seek_timestamp;
+        if (mov_get_sample_entry(st, sample, &e) < 0)
+            return AVERROR_INVALIDDATA;
+        seek_timestamp = e.timestamp;
         sti->skip_samples = mov_get_skip_samples(st, sample);
 
         for (i = 0; i < s->nb_streams; i++) {
@@ -10897,6 +11382,10 @@ static const AVOption mov_options[] = {
         0, 1, FLAGS},
     {"ignore_chapters", "", OFFSET(ignore_chapters), AV_OPT_TYPE_BOOL, {.i64 = 0},
         0, 1, FLAGS},
+    {"compact_index",
+        "Read the samples from the sample tables instead of building an index entry for each sample.",
+        OFFSET(compact_index), AV_OPT_TYPE_BOOL, {.i64 = 0},
+        0, 1, FLAGS},
     {"use_mfra_for",
         "use mfra for fragment timestamps",
         OFFSET(use_mfra_for), AV_OPT_TYPE_INT, {.i64 = FF_MOV_FLAG_MFRA_AUTO},
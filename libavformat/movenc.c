@@ -79,8 +79,11 @@ static const AVOption options[] = {
     { "encryption_key", "The media encryption key (hex)", offsetof(MOVMuxContext, encryption_key), AV_OPT_TYPE_BINARY, .flags = AV_OPT_FLAG_ENCODING_PARAM },
     { "encryption_kid", "The media encryption key identifier (hex)", offsetof(MOVMuxContext, encryption_kid), AV_OPT_TYPE_BINARY, .flags = AV_OPT_FLAG_ENCODING_PARAM },
     { "encryption_scheme",    "Configures the encryption scheme, allowed values are none, cenc-aes-ctr", offsetof(MOVMuxContext, encryption_scheme_str),   AV_OPT_TYPE_STRING, {.str = NULL}, .flags = AV_OPT_FLAG_ENCODING_PARAM },
+    { "faststart_insert", "Insert the space for the moov atom in place instead of rewriting the file with faststart, if the file system supports it", offsetof(MOVMuxContext, faststart_insert), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
+    { "faststart_reserve", "Reserve space for the moov atom based on the stream durations with faststart", offsetof(MOVMuxContext, faststart_reserve), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
     { "frag_duration", "Maximum fragment duration", offsetof(MOVMuxContext, max_fragment_duration), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM},
     { "frag_interleave", "Interleave samples within fragments (max number of consecutive samples, lower is tighter interleaving, but with more overhead)", offsetof(MOVMuxContext, frag_interleave), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
+    { "frag_reserve", "Write the samples of fragments directly to the (seekable) output, reserving this much space for the moof atom", offsetof(MOVMuxContext, frag_reserve), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM},
     { "frag_size", "Maximum fragment size", offsetof(MOVMuxContext, max_fragment_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM},
     { "fragment_index", "Fragment number of the next fragment", offsetof(MOVMuxContext, fragments), AV_OPT_TYPE_INT, {.i64 = 1}, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM},
     { "iods_audio_profile", "iods audio profile atom.", offsetof(MOVMuxContext, iods_audio_profile), AV_OPT_TYPE_INT, {.i64 = -1}, -1, 255, AV_OPT_FLAG_ENCODING_PARAM},
@@ -6248,6 +6251,111 @@ static int mov_finish_fragment(MOVMuxContext *mov, MOVTrack *track,
     return 0;
 }
 
+/* Upper bounds of the atoms in front of a streamed fragment's mdat */
+#define STREAMED_MOOF_SIZE      (8 + 16)        /* moof, mfhd */
+#define STREAMED_PRFT_SIZE      32
+#define STREAMED_TRAF_SIZE      (8 + 40 + 20)   /* traf, tfhd, tfdt */
+#define STREAMED_SIDX_SIZE      52
+#define STREAMED_TRUN_SIZE      24
+#define STREAMED_SAMPLE_SIZE    16
+
+static int streamed_fragment_base_size(MOVMuxContext *mov)
+{
+    return STREAMED_MOOF_SIZE +
+           (mov->write_prft > MOV_PRFT_NONE ? STREAMED_PRFT_SIZE : 0);
+}
+
+/**
+ * Return how much the header of the streamed fragment can grow when the
+ * next sample of track is written at the current output position.
+ */
+static int streamed_fragment_sample_size(AVFormatContext *s, MOVTrack *track)
+{
+    MOVMuxContext *mov = s->priv_data;
+    int size = STREAMED_SAMPLE_SIZE;
+
+    if (!track->entry) {
+        size += STREAMED_TRAF_SIZE + STREAMED_TRUN_SIZE;
+        if (mov->flags & FF_MOV_FLAG_DASH &&
+            !(mov->flags & (FF_MOV_FLAG_GLOBAL_SIDX | FF_MOV_FLAG_SKIP_SIDX)))
+            size += STREAMED_SIDX_SIZE;
+    } else if (track->cluster[track->entry - 1].pos +
+               track->cluster[track->entry - 1].size != avio_tell(s->pb)) {
+        /* samples that are not contiguous start a new trun */
+        size += STREAMED_TRUN_SIZE;
+    }
+    return size;
+}
+
+static int get_streamed_fragment_header_size(MOVMuxContext *mov, int64_t mdat_size)
+{
+    AVIOContext *buf;
+    int ret, moof_size;
+
+    if ((ret = ffio_open_null_buf(&buf)) < 0)
+        return ret;
+    mov_write_moof_tag_internal(buf, mov, -1, 0);
+    moof_size = ffio_close_null_buf(buf);
+
+    if ((ret = ffio_open_null_buf(&buf)) < 0)
+        return ret;
+    if (mov->flags & FF_MOV_FLAG_DASH &&
+        !(mov->flags & (FF_MOV_FLAG_GLOBAL_SIDX | FF_MOV_FLAG_SKIP_SIDX)))
+        mov_write_sidx_tags(buf, mov, -1, moof_size + 8 + mdat_size);
+    if (mov->write_prft > MOV_PRFT_NONE && mov->write_prft < MOV_PRFT_NB)
+        mov_write_prft_tag(buf, mov, -1);
+
+    return moof_size + ffio_close_null_buf(buf);
+}
+
+/**
+ * Write the moof of a fragment whose samples have already been written
+ * to the output into the space reserved in front of them, padding it
+ * with a free atom.
+ */
+static int mov_flush_streamed_fragment(AVFormatContext *s)
+{
+    MOVMuxContext *mov = s->priv_data;
+    AVIOContext *pb = s->pb;
+    int64_t end = avio_tell(pb);
+    int64_t mdat_start = mov->frag_stream_pos + mov->frag_reserve + 8;
+    int64_t mdat_size = end - mdat_start;
+    int i, header_size, ret;
+
+    for (i = 0; i < mov->nb_tracks; i++)
+        mov->tracks[i].data_offset = -mdat_start;
+
+    header_size = get_streamed_fragment_header_size(mov, mdat_size);
+    if (header_size < 0)
+        return header_size;
+    if (header_size != mov->frag_reserve && header_size + 8 > mov->frag_reserve) {
+        av_log(s, AV_LOG_ERROR, "Fragment header of %d bytes does not fit "
+               "into the reserved space\n", header_size);
+        return AVERROR_BUG;
+    }
+
+    avio_seek(pb, mov->frag_stream_pos, SEEK_SET);
+    if (header_size < mov->frag_reserve) {
+        avio_wb32(pb, mov->frag_reserve - header_size);
+        ffio_wfourcc(pb, "free");
+        ffio_fill(pb, 0, mov->frag_reserve - header_size - 8);
+    }
+    if ((ret = mov_write_moof_tag(pb, mov, -1, mdat_size)) < 0)
+        return ret;
+    mov->fragments++;
+    avio_wb32(pb, mdat_size + 8);
+    ffio_wfourcc(pb, "mdat");
+    avio_seek(pb, end, SEEK_SET);
+
+    for (i = 0; i < mov->nb_tracks; i++)
+        mov_finish_fragment(mov, &mov->tracks[i], mdat_start);
+    mov->frag_stream_pos = -1;
+    mov->mdat_size = 0;
+
+    avio_write_marker(pb, AV_NOPTS_VALUE, AVIO_DATA_MARKER_FLUSH_POINT);
+    return 0;
+}
+
 static int mov_flush_fragment(AVFormatContext *s, int force)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -6363,6 +6471,9 @@ static int mov_flush_fragment(AVFormatContext *s, int force)
         return 0;
     }
 
+    if (mov->frag_stream_pos >= 0)
+        return mov_flush_streamed_fragment(s);
+
     if (mov->frag_interleave) {
         for (i = 0; i < mov->nb_tracks; i++) {
             MOVTrack *track = &mov->tracks[i];
@@ -6467,6 +6578,25 @@ static int mov_auto_flush_fragment(AVFormatContext *s, int force)
     return ret;
 }
 
+static void mov_set_track_end(MOVTrack *trk, const AVPacket *pkt)
+{
+    if (!trk->entry)
+        return;
+    // Set the duration of this track to line up with the next
+    // sample in this track. This avoids relying on AVPacket
+    // duration, but only helps for this particular track, not
+    // for the other ones that are flushed at the same time.
+    //
+    // If we have trk->entry == 0, no fragment will be written
+    // for this track, and we can't adjust the track end here.
+    trk->track_duration = pkt->dts - trk->start_dts;
+    if (pkt->pts != AV_NOPTS_VALUE)
+        trk->end_pts = pkt->pts;
+    else
+        trk->end_pts = pkt->dts;
+    trk->end_reliable = 1;
+}
+
 static int check_pkt(AVFormatContext *s, MOVTrack *trk, AVPacket *pkt)
 {
     int64_t ref;
@@ -6540,11 +6670,29 @@ int ff_mov_write_packet(AVFormatContext *s, AVPacket *pkt)
                 }
             }
 
-            if (!trk->mdat_buf) {
-                if ((ret = avio_open_dyn_buf(&trk->mdat_buf)) < 0)
-                    return ret;
+            if (mov->frag_reserve && mov->moov_written) {
+                /* Cut the fragment early if its moof might not fit into
+                 * the reserved space anymore. */
+                if (mov->frag_stream_pos >= 0 &&
+                    mov->frag_header_size + streamed_fragment_sample_size(s, trk) + 8 >
+                    mov->frag_reserve) {
+                    mov_set_track_end(trk, pkt);
+                    if ((ret = mov_auto_flush_fragment(s, 0)) < 0)
+                        return ret;
+                }
+                if (mov->frag_stream_pos < 0) {
+                    mov->frag_stream_pos  = avio_tell(pb);
+                    mov->frag_header_size = streamed_fragment_base_size(mov);
+                    ffio_fill(pb, 0, mov->frag_reserve + 8);
+                }
+                mov->frag_header_size += streamed_fragment_sample_size(s, trk);
+            } else {
+                if (!trk->mdat_buf) {
+                    if ((ret = avio_open_dyn_buf(&trk->mdat_buf)) < 0)
+                        return ret;
+                }
+                pb = trk->mdat_buf;
             }
-            pb = trk->mdat_buf;
         } else {
             if (!mov->mdat_buf) {
                 if ((ret = avio_open_dyn_buf(&mov->mdat_buf)) < 0)
@@ -6942,21 +7090,7 @@ static int mov_write_single_packet(AVFormatContext *s, AVPacket *pkt)
              trk->entry && pkt->flags & AV_PKT_FLAG_KEY) ||
             (mov->flags & FF_MOV_FLAG_FRAG_EVERY_FRAME)) {
         if (frag_duration >= mov->min_fragment_duration) {
-            if (trk->entry) {
-                // Set the duration of this track to line up with the next
-                // sample in this track. This avoids relying on AVPacket
-                // duration, but only helps for this particular track, not
-                // for the other ones that are flushed at the same time.
-                //
-                // If we have trk->entry == 0, no fragment will be written
-                // for this track, and we can't adjust the track end here.
-                trk->track_duration = pkt->dts - trk->start_dts;
-                if (pkt->pts != AV_NOPTS_VALUE)
-                    trk->end_pts = pkt->pts;
-                else
-                    trk->end_pts = pkt->dts;
-                trk->end_reliable = 1;
-            }
+            mov_set_track_end(trk, pkt);
             mov_auto_flush_fragment(s, 0);
         }
     }
@@ -7586,6 +7720,65 @@ static int mov_init_iamf_track(AVFormatContext *s)
 }
 #endif
 
+/* Estimates above this are not trusted, the moov atom is then moved after
+ * writing as without faststart_reserve. */
+#define MAX_RESERVED_MOOV_SIZE  (8 << 20)
+
+/**
+ * Estimate the size of the moov atom from the durations the caller set on
+ * the streams as a hint, limited to the output duration if that is set.
+ * Return 0 if they are not known or the estimate is implausibly large.
+ */
+static int mov_estimate_moov_size(AVFormatContext *s)
+{
+    double size = 4096;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        const AVStream *st = s->streams[i];
+        const AVCodecParameters *par = st->codecpar;
+        double duration = st->duration * av_q2d(st->time_base);
+        double nb_samples;
+
+        if (st->duration <= 0)
+            return 0;
+        /* the stream duration hints do not account for trimming */
+        if (s->duration > 0)
+            duration = FFMIN(duration, s->duration / (double)AV_TIME_BASE);
+        switch (par->codec_type) {
+        case AVMEDIA_TYPE_VIDEO:
+            if (is_cover_image(st)) {
+                nb_samples = 1;
+            } else if (st->avg_frame_rate.num > 0 && st->avg_frame_rate.den > 0) {
+                nb_samples = duration * av_q2d(st->avg_frame_rate);
+            } else {
+                return 0;
+            }
+            /* stsz, ctts, stss and chunk tables */
+            size += 20 * nb_samples;
+            break;
+        case AVMEDIA_TYPE_AUDIO:
+            if (par->sample_rate <= 0)
+                return 0;
+            nb_samples = duration * par->sample_rate /
+                         (par->frame_size > 0 ? par->frame_size : 1024);
+            size += 12 * nb_samples;
+            break;
+        default:
+            /* subtitles and data are sparse, assume one sample per second */
+            size += 20 * duration;
+            break;
+        }
+        size += 1024;
+    }
+    size += size / 8;
+
+    if (size > MAX_RESERVED_MOOV_SIZE) {
+        av_log(s, AV_LOG_VERBOSE, "Not reserving an estimated %.0f bytes for the moov atom\n", size);
+        return 0;
+    }
+    return size;
+}
+
 static int mov_init(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -7650,6 +7843,11 @@ static int mov_init(AVFormatContext *s)
 
     if (mov->flags & FF_MOV_FLAG_FASTSTART) {
         mov->reserved_moov_size = -1;
+        if (mov->faststart_reserve && !(mov->flags & FF_MOV_FLAG_FRAGMENT)) {
+            int size = mov_estimate_moov_size(s);
+            if (size > 0)
+                mov->reserved_moov_size = size;
+        }
     }
 
     if (mov->use_editlist < 0) {
@@ -8059,6 +8257,32 @@ static int mov_init(AVFormatContext *s)
         }
     }
 
+    mov->frag_stream_pos = -1;
+    if (mov->frag_reserve) {
+        int min_reserve = streamed_fragment_base_size(mov) + 8;
+
+        /* The samples of all tracks are interleaved in one mdat and the
+         * fragments are not consecutive because of the padding. */
+        if (!(mov->flags & FF_MOV_FLAG_FRAGMENT) ||
+            mov->flags & (FF_MOV_FLAG_SEPARATE_MOOF | FF_MOV_FLAG_HYBRID_FRAGMENTED |
+                          FF_MOV_FLAG_GLOBAL_SIDX | FF_MOV_FLAG_RTP_HINT) ||
+            (mov->flags & FF_MOV_FLAG_OMIT_TFHD_OFFSET &&
+             !(mov->flags & FF_MOV_FLAG_DEFAULT_BASE_MOOF)) ||
+            mov->frag_interleave || mov->mode == MODE_ISM ||
+            !(s->pb->seekable & AVIO_SEEKABLE_NORMAL)) {
+            av_log(s, AV_LOG_WARNING, "frag_reserve is not supported with these "
+                   "options or a non-seekable output, buffering the fragments\n");
+            mov->frag_reserve = 0;
+        }
+        for (i = 0; i < mov->nb_tracks; i++)
+            min_reserve += STREAMED_TRAF_SIZE + STREAMED_SIDX_SIZE +
+                           STREAMED_TRUN_SIZE + STREAMED_SAMPLE_SIZE;
+        if (mov->frag_reserve && mov->frag_reserve < min_reserve) {
+            av_log(s, AV_LOG_ERROR, "frag_reserve must be at least %d\n", min_reserve);
+            return AVERROR(EINVAL);
+        }
+    }
+
     enable_tracks(s);
     return 0;
 }
@@ -8162,8 +8386,6 @@ static int mov_write_header(AVFormatContext *s)
             mov->mdat_pos = avio_tell(pb);
         }
     } else if (mov->mode != MODE_AVIF) {
-        if (mov->flags & FF_MOV_FLAG_FASTSTART)
-            mov->reserved_header_pos = avio_tell(pb);
         mov_write_mdat_tag(pb, mov);
     }
 
@@ -8256,59 +8478,110 @@ static int get_sidx_size(AVFormatContext *s)
  * entries) when the moov is moved to the beginning, so the size of the moov
  * would change. It also updates the chunk offset tables.
  */
-static int compute_moov_size(AVFormatContext *s)
+static int compute_sidx_size(AVFormatContext *s)
 {
-    int i, moov_size, moov_size2;
+    int i, sidx_size;
     MOVMuxContext *mov = s->priv_data;
 
-    moov_size = get_moov_size(s);
-    if (moov_size < 0)
-        return moov_size;
+    sidx_size = get_sidx_size(s);
+    if (sidx_size < 0)
+        return sidx_size;
 
     for (i = 0; i < mov->nb_tracks; i++)
-        mov->tracks[i].data_offset += moov_size;
-
-    moov_size2 = get_moov_size(s);
-    if (moov_size2 < 0)
-        return moov_size2;
-
-    /* if the size changed, we just switched from stco to co64 and need to
-     * update the offsets */
-    if (moov_size2 != moov_size)
-        for (i = 0; i < mov->nb_tracks; i++)
-            mov->tracks[i].data_offset += moov_size2 - moov_size;
+        mov->tracks[i].data_offset += sidx_size;
 
-    return moov_size2;
+    return sidx_size;
 }
 
-static int compute_sidx_size(AVFormatContext *s)
+static int shift_data(AVFormatContext *s)
 {
-    int i, sidx_size;
+    int sidx_size;
     MOVMuxContext *mov = s->priv_data;
 
-    sidx_size = get_sidx_size(s);
+    sidx_size = compute_sidx_size(s);
     if (sidx_size < 0)
         return sidx_size;
 
-    for (i = 0; i < mov->nb_tracks; i++)
-        mov->tracks[i].data_offset += sidx_size;
+    return ff_format_shift_data(s, mov->reserved_header_pos, sidx_size);
+}
 
-    return sidx_size;
+static void shift_data_offsets(MOVMuxContext *mov, int64_t shift)
+{
+    for (int i = 0; i < mov->nb_tracks; i++)
+        mov->tracks[i].data_offset += shift;
 }
 
-static int shift_data(AVFormatContext *s)
+/* The moov atom fits if it fills the space exactly or leaves room for a
+ * free atom. */
+static int moov_fits(int moov_size, int64_t space)
+{
+    return moov_size == space || moov_size + 8 <= space;
+}
+
+/**
+ * Write the moov atom in front of the mdat: into the reserved space if it
+ * fits, otherwise after making room by inserting space into the file in
+ * place or, failing that, by shifting the data.
+ */
+static int mov_write_faststart_moov(AVFormatContext *s, int64_t end)
 {
-    int moov_size;
     MOVMuxContext *mov = s->priv_data;
+    AVIOContext *pb = s->pb;
+    int64_t space = FFMAX(mov->reserved_moov_size, 0);
+    int moov_size, ret;
 
-    if (mov->flags & FF_MOV_FLAG_FRAGMENT)
-        moov_size = compute_sidx_size(s);
-    else
-        moov_size = compute_moov_size(s);
+    moov_size = get_moov_size(s);
     if (moov_size < 0)
         return moov_size;
 
-    return ff_format_shift_data(s, mov->reserved_header_pos, moov_size);
+    if (!moov_fits(moov_size, space) && mov->faststart_insert) {
+        int64_t inserted = ff_format_insert_space(s, mov->reserved_header_pos,
+                                                  moov_size + 8 - space);
+        if (inserted >= 0) {
+            av_log(s, AV_LOG_VERBOSE, "Inserted %"PRId64" bytes for the moov atom\n", inserted);
+            space += inserted;
+            end   += inserted;
+            shift_data_offsets(mov, inserted);
+            moov_size = get_moov_size(s);
+            if (moov_size < 0)
+                return moov_size;
+        } else {
+            av_log(s, AV_LOG_VERBOSE, "Cannot insert space in place: %s\n", av_err2str(inserted));
+        }
+    }
+
+    if (!moov_fits(moov_size, space)) {
+        int shift = moov_size > space ? moov_size - space : moov_size + 8 - space;
+        int moov_size2;
+
+        av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
+        shift_data_offsets(mov, shift);
+        moov_size2 = get_moov_size(s);
+        if (moov_size2 < 0)
+            return moov_size2;
+        /* if the size changed, we just switched from stco to co64 and need to
+         * update the offsets */
+        if (moov_size2 != moov_size) {
+            shift_data_offsets(mov, moov_size2 - moov_size);
+            shift    += moov_size2 - moov_size;
+            moov_size = moov_size2;
+        }
+        avio_seek(pb, end, SEEK_SET);
+        ret = ff_format_shift_data(s, mov->reserved_header_pos + space, shift);
+        if (ret < 0)
+            return ret;
+        space += shift;
+    }
+
+    avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
+    if ((ret = mov_write_moov_tag(pb, mov, s)) < 0)
+        return ret;
+    if (space > moov_size) {
+        avio_wb32(pb, space - moov_size);
+        ffio_wfourcc(pb, "free");
+        ffio_fill(pb, 0, space - moov_size - 8);
+    }
+    return 0;
 }
 
 static int mov_write_trailer(AVFormatContext *s)
@@ -8404,12 +8677,7 @@ static int mov_write_trailer(AVFormatContext *s)
         avio_seek(pb, mov->reserved_moov_size > 0 ? mov->reserved_header_pos : moov_pos, SEEK_SET);
 
         if (mov->flags & FF_MOV_FLAG_FASTSTART) {
-            av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
-            res = shift_data(s);
-            if (res < 0)
-                return res;
-            avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
-            if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
+            if ((res = mov_write_faststart_moov(s, moov_pos)) < 0)
                 return res;
         } else if (mov->reserved_moov_size > 0) {
             int64_t size;
@@ -222,6 +222,8 @@ typedef struct MOVMuxContext {
 
     int reserved_moov_size; ///< 0 for disabled, -1 for automatic, size otherwise
     int64_t reserved_header_pos;
+    int faststart_reserve;
+    int faststart_insert;
 
     char *major_brand;
 
@@ -253,6 +255,10 @@ typedef struct MOVMuxContext {
     int empty_hdlr_name;
     int movie_timescale;
 
+    int frag_reserve;           ///< space reserved for the moof of streamed fragments
+    int64_t frag_stream_pos;    ///< position of the streamed fragment, or -1
+    int frag_header_size;       ///< upper bound of the streamed fragment's header
+
     int64_t avif_extent_pos[2];  // index 0 is YUV and 1 is Alpha.
     int avif_extent_length[2];   // index 0 is YUV and 1 is Alpha.
     int is_animated_avif;
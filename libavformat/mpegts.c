@@ -179,6 +179,13 @@ struct MpegTSContext {
     MpegTSFilter *pids[NB_PID_MAX];
     int current_pid;
 
+    /** pids only comprised in programs with discard=AVDISCARD_ALL */
+    uint32_t discard_map[NB_PID_MAX / 32];
+    /** set if any bit of discard_map is set */
+    int discard_map_active;
+    /** discard_map must be recomputed before use */
+    int discard_map_dirty;
+
     AVStream *epg_stream;
     AVBufferPool* pools[32];
 };
@@ -315,6 +322,7 @@ static void clear_programs(MpegTSContext *ts)
 {
     av_freep(&ts->prg);
     ts->nb_prg = 0;
+    ts->discard_map_dirty = 1;
 }
 
 static struct Program * add_program(MpegTSContext *ts, unsigned int programid)
@@ -372,48 +380,67 @@ static void update_av_program_info(AVFormatContext *s, unsigned int programid,
 }
 
 /**
- * @brief discard_pid() decides if the pid is to be discarded according
- *                      to caller's programs selection
- * @param ts    : - TS context
- * @param pid   : - pid
- * @return 1 if the pid is only comprised in programs that have .discard=AVDISCARD_ALL
- *         0 otherwise
+ * Recompute the bitmap of pids that are only comprised in programs with
+ * .discard=AVDISCARD_ALL, following the caller's programs selection.
  */
-static int discard_pid(MpegTSContext *ts, unsigned int pid)
+static void update_discard_map(MpegTSContext *ts)
 {
+    uint32_t used[NB_PID_MAX / 32] = { 0 };
     int i, j, k;
-    int used = 0, discarded = 0;
-    struct Program *p;
 
-    if (pid == PAT_PID)
-        return 0;
+    ts->discard_map_dirty  = 0;
+    ts->discard_map_active = 0;
+    memset(ts->discard_map, 0, sizeof(ts->discard_map));
 
     /* If none of the programs have .discard=AVDISCARD_ALL then there's
-     * no way we have to discard this packet */
+     * no way we have to discard any packet */
     for (k = 0; k < ts->stream->nb_programs; k++)
         if (ts->stream->programs[k]->discard == AVDISCARD_ALL)
             break;
     if (k == ts->stream->nb_programs)
-        return 0;
+        return;
 
     for (i = 0; i < ts->nb_prg; i++) {
-        p = &ts->prg[i];
-        for (j = 0; j < p->nb_pids; j++) {
-            if (p->pids[j] != pid)
-                continue;
-            // is program with id p->id set to be discarded?
-            for (k = 0; k < ts->stream->nb_programs; k++) {
-                if (ts->stream->programs[k]->id == p->id) {
-                    if (ts->stream->programs[k]->discard == AVDISCARD_ALL)
-                        discarded++;
-                    else
-                        used++;
-                }
+        const struct Program *p = &ts->prg[i];
+        int discarded = 0, in_use = 0;
+        // is program with id p->id set to be discarded?
+        for (k = 0; k < ts->stream->nb_programs; k++) {
+            if (ts->stream->programs[k]->id == p->id) {
+                if (ts->stream->programs[k]->discard == AVDISCARD_ALL)
+                    discarded = 1;
+                else
+                    in_use = 1;
             }
         }
+        for (j = 0; j < p->nb_pids; j++) {
+            unsigned int pid = p->pids[j];
+            if (in_use)
+                used[pid >> 5] |= 1U << (pid & 31);
+            if (discarded)
+                ts->discard_map[pid >> 5] |= 1U << (pid & 31);
+        }
     }
 
-    return !used && discarded;
+    ts->discard_map[PAT_PID >> 5] &= ~(1U << (PAT_PID & 31));
+    for (i = 0; i < FF_ARRAY_ELEMS(ts->discard_map); i++) {
+        ts->discard_map[i] &= ~used[i];
+        ts->discard_map_active |= !!ts->discard_map[i];
+    }
+}
+
+/**
+ * @brief discard_pid() decides if the pid is to be discarded according
+ *                      to caller's programs selection
+ * @param ts    : - TS context
+ * @param pid   : - pid
+ * @return 1 if the pid is only comprised in programs that have .discard=AVDISCARD_ALL
+ *         0 otherwise
+ */
+static int discard_pid(MpegTSContext *ts, unsigned int pid)
+{
+    if (ts->discard_map_dirty)
+        update_discard_map(ts);
+    return ts->discard_map[pid >> 5] >> (pid & 31) & 1;
 }
 
 /**
@@ -2368,6 +2395,7 @@ static void pmt_cb(MpegTSFilter *filter, const uint8_t *section, int section_len
         return;
     if (!ts->skip_clear)
         clear_avprogram(ts, h->id);
+    ts->discard_map_dirty = 1;
     clear_program(prg);
     add_pid_to_program(prg, ts->current_pid);
 
@@ -2564,6 +2592,7 @@ static void pat_cb(MpegTSFilter *filter, const uint8_t *section, int section_len
     if (skip_identical(h, tssf))
         return;
     ts->id = h->id;
+    ts->discard_map_dirty = 1;
 
     for (;;) {
         sid = get16(&p, p_end);
@@ -2975,6 +3004,44 @@ static void finished_reading_packet(AVFormatContext *s, int raw_packet_size)
         avio_skip(pb, skip);
 }
 
+/**
+ * Skip the packets at the current position of the buffered input that
+ * handle_packet() would ignore because their pid is discarded or has no
+ * filter, without going through the per packet reading path.
+ *
+ * @return number of packets skipped, at most max_packets
+ */
+static int64_t skip_discarded_packets(MpegTSContext *ts, int64_t max_packets)
+{
+    AVIOContext *pb = ts->stream->pb;
+    const uint8_t *p = pb->buf_ptr, *end = pb->buf_end;
+    const int raw_packet_size = ts->raw_packet_size;
+    int64_t n = 0;
+
+    while (n < max_packets && end - p >= raw_packet_size && p[0] == 0x47) {
+        unsigned int pid = AV_RB16(p + 1) & 0x1fff;
+        int is_start = p[1] & 0x40;
+        MpegTSFilter *tss = ts->pids[pid];
+
+        if (!tss) {
+            if (ts->auto_guess && is_start)
+                break;
+        } else if (is_start) {
+            if (!(ts->discard_map[pid >> 5] >> (pid & 31) & 1))
+                break;
+            tss->discard = 1;
+        } else if (!tss->discard) {
+            break;
+        }
+        p += raw_packet_size;
+        n++;
+    }
+
+    if (n)
+        avio_skip(pb, p - pb->buf_ptr);
+    return n;
+}
+
 static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
 {
     AVFormatContext *s = ts->stream;
@@ -3003,6 +3070,8 @@ static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
         }
     }
 
+    /* the caller may have changed the programs selection */
+    ts->discard_map_dirty = 1;
     ts->stop_parse = 0;
     packet_num = 0;
     memset(packet + TS_PACKET_SIZE, 0, AV_INPUT_BUFFER_PADDING_SIZE);
@@ -3016,6 +3085,17 @@ static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
         if (ts->stop_parse > 0)
             break;
 
+        if (ts->discard_map_dirty)
+            update_discard_map(ts);
+        if (ts->discard_map_active) {
+            int64_t skipped = skip_discarded_packets(ts, nb_packets ?
+                                                     nb_packets - packet_num : INT64_MAX);
+            if (skipped) {
+                packet_num += skipped - 1;
+                continue;
+            }
+        }
+
         ret = read_packet(s, packet, ts->raw_packet_size, &data);
         if (ret != 0)
             break;
@@ -3411,6 +3491,7 @@ int avpriv_mpegts_parse_packet(MpegTSContext *ts, AVPacket *pkt,
 
     len1 = len;
     ts->pkt = pkt;
+    ts->discard_map_dirty = 1;
     for (;;) {
         ts->stop_parse = 0;
         if (len < TS_PACKET_SIZE)
@@ -247,6 +247,18 @@ enum AVWriteUncodedFrameFlags {
  */
 int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size);
 
+/**
+ * Make at least size bytes of space after the first keep bytes of the output
+ * without rewriting the data that follows, if the protocol can insert space
+ * in place. The first keep bytes are written again at the start of the
+ * output, the contents of the inserted space are unspecified and the IO
+ * position is left at keep.
+ *
+ * @return the amount of space inserted, or a negative AVERROR code, in
+ *         which case the output is unchanged
+ */
+int64_t ff_format_insert_space(AVFormatContext *s, int keep, int64_t size);
+
 /**
  * Utility function to open IO stream of output format.
  *
@@ -27,8 +27,10 @@
 #include "libavutil/parseutils.h"
 #include "avformat.h"
 #include "avio.h"
+#include "avio_internal.h"
 #include "internal.h"
 #include "mux.h"
+#include "url.h"
 
 int avformat_query_codec(const AVOutputFormat *ofmt, enum AVCodecID codec_id,
                          int std_compliance)
@@ -125,6 +127,46 @@ end:
     return ret;
 }
 
+int64_t ff_format_insert_space(AVFormatContext *s, int keep, int64_t size)
+{
+    URLContext *h = ffio_geturlcontext(s->pb);
+    AVIOContext *read_pb;
+    uint8_t *buf;
+    int64_t ret;
+
+    if (!h || !h->prot->url_insert_space)
+        return AVERROR(ENOSYS);
+
+    buf = av_malloc(keep);
+    if (!buf)
+        return AVERROR(ENOMEM);
+
+    /* The inserted space starts at a block boundary, so keep a copy of the
+     * data in front of it. */
+    avio_flush(s->pb);
+    ret = s->io_open(s, &read_pb, s->url, AVIO_FLAG_READ, NULL);
+    if (ret < 0) {
+        av_log(s, AV_LOG_ERROR, "Unable to re-open %s output file for inserting space\n", s->url);
+        goto end;
+    }
+    ret = avio_read(read_pb, buf, keep);
+    ff_format_io_close(s, &read_pb);
+    if (ret != keep) {
+        ret = ret < 0 ? ret : AVERROR(EIO);
+        goto end;
+    }
+
+    ret = ffurl_insert_space(h, 0, size);
+    if (ret < 0)
+        goto end;
+    avio_seek(s->pb, 0, SEEK_SET);
+    avio_write(s->pb, buf, keep);
+
+end:
+    av_free(buf);
+    return ret;
+}
+
 int ff_format_output_open(AVFormatContext *s, const char *url, AVDictionary **options)
 {
     if (!s->oformat)
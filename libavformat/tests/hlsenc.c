@@ -0,0 +1,345 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Low-latency HLS muxing test. Two variant streams are muxed live with
+ * partial segments, while every file the muxer writes is recorded. This
+ * makes the intermediate playlists visible, which are the only ones with
+ * preload hints and rendition reports.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/mem.h"
+
+#include "libavformat/avformat.h"
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#define NB_VARIANTS 2
+#define FRAME_SIZE  1152
+#define SAMPLE_RATE 48000
+#define NB_FRAMES   (8 * SAMPLE_RATE / FRAME_SIZE)
+
+typedef struct File {
+    char *name;
+    AVIOContext *dyn;   ///< buffer handed to the muxer while open
+    AVIOContext *out;   ///< the actual file
+    uint8_t *data;
+    int size;
+    int closed;
+} File;
+
+static File *files;
+static int nb_files;
+
+typedef struct Segment {
+    char *name;
+    int nb_parts;
+    int parts_match;
+} Segment;
+
+static Segment *segments;
+static int nb_segments;
+
+// the last playlist of each variant without EXT-X-ENDLIST
+static char *live_playlists[NB_VARIANTS];
+
+static int (*default_io_open)(AVFormatContext *s, AVIOContext **pb, const char *url,
+                              int flags, AVDictionary **options);
+static int (*default_io_close2)(AVFormatContext *s, AVIOContext *pb);
+
+static const File *find_file(const char *name)
+{
+    for (int i = nb_files - 1; i >= 0; i--)
+        if (files[i].closed && !strcmp(files[i].name, name))
+            return &files[i];
+    return NULL;
+}
+
+static int ends_with(const char *str, const char *suffix)
+{
+    size_t len = strlen(str), suffix_len = strlen(suffix);
+    return len >= suffix_len && !strcmp(str + len - suffix_len, suffix);
+}
+
+static int check_segment(const File *f)
+{
+    Segment *seg;
+    char *base, *part_name;
+    int pos = 0;
+
+    seg = av_realloc_array(segments, nb_segments + 1, sizeof(*segments));
+    if (!seg)
+        return AVERROR(ENOMEM);
+    segments = seg;
+    seg = &segments[nb_segments++];
+    *seg = (Segment) { .name = av_strdup(f->name), .parts_match = 1 };
+    base = av_strndup(f->name, strlen(f->name) - strlen(".m4s"));
+    if (!seg->name || !base)
+        return AVERROR(ENOMEM);
+
+    for (;; seg->nb_parts++) {
+        const File *part;
+
+        part_name = av_asprintf("%s.part%d.m4s", base, seg->nb_parts);
+        if (!part_name)
+            return AVERROR(ENOMEM);
+        part = find_file(part_name);
+        av_free(part_name);
+        if (!part)
+            break;
+
+        if (pos + part->size > f->size ||
+            memcmp(f->data + pos, part->data, part->size))
+            seg->parts_match = 0;
+        pos += part->size;
+    }
+    if (pos != f->size)
+        seg->parts_match = 0;
+    av_free(base);
+
+    return 0;
+}
+
+static int record_file(File *f)
+{
+    char name[1024];
+    int variant;
+
+    av_strlcpy(name, f->name, sizeof(name));
+    if (ends_with(name, ".tmp"))
+        name[strlen(name) - 4] = 0;
+
+    if (ends_with(name, ".m3u8")) {
+        if (sscanf(name + strlen(name) - 7, "_%d.m3u8", &variant) != 1 ||
+            variant < 0 || variant >= NB_VARIANTS)
+            return 0;
+        if (!av_strnstr(f->data, "#EXT-X-ENDLIST", f->size)) {
+            av_free(live_playlists[variant]);
+            live_playlists[variant] = av_strndup(f->data, f->size);
+            if (!live_playlists[variant])
+                return AVERROR(ENOMEM);
+        }
+    } else if (ends_with(name, ".m4s") && !strstr(name, ".part")) {
+        return check_segment(f);
+    }
+    return 0;
+}
+
+static int io_open(AVFormatContext *s, AVIOContext **pb, const char *url,
+                   int flags, AVDictionary **options)
+{
+    File *f;
+    int ret;
+
+    if (!(flags & AVIO_FLAG_WRITE))
+        return default_io_open(s, pb, url, flags, options);
+
+    f = av_realloc_array(files, nb_files + 1, sizeof(*files));
+    if (!f)
+        return AVERROR(ENOMEM);
+    files = f;
+    f = &files[nb_files];
+    memset(f, 0, sizeof(*f));
+    f->name = av_strdup(av_basename(url));
+    if (!f->name)
+        return AVERROR(ENOMEM);
+
+    // the files are also written to disk, so that the muxer can rename
+    // and delete them
+    ret = default_io_open(s, &f->out, url, flags, options);
+    if (ret < 0)
+        goto fail;
+    ret = avio_open_dyn_buf(&f->dyn);
+    if (ret < 0) {
+        default_io_close2(s, f->out);
+        goto fail;
+    }
+    nb_files++;
+    *pb = f->dyn;
+    return 0;
+fail:
+    av_freep(&f->name);
+    return ret;
+}
+
+static int io_close2(AVFormatContext *s, AVIOContext *pb)
+{
+    for (int i = 0; i < nb_files; i++) {
+        File *f = &files[i];
+        int ret;
+
+        if (f->closed || f->dyn != pb)
+            continue;
+
+        f->size   = avio_close_dyn_buf(f->dyn, &f->data);
+        f->dyn    = NULL;
+        f->closed = 1;
+        avio_write(f->out, f->data, f->size);
+        ret = default_io_close2(s, f->out);
+        f->out = NULL;
+        if (ret < 0)
+            return ret;
+        return record_file(f);
+    }
+    return default_io_close2(s, pb);
+}
+
+int main(int argc, char **argv)
+{
+    AVFormatContext *ctx = NULL;
+    AVDictionary *opts = NULL;
+    AVPacket *pkt = NULL;
+    char *url = NULL, *segment_url = NULL, *init_url = NULL, *dir = NULL;
+    const char *dirname;
+    uint8_t frame[96];
+    int ret;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <output prefix>\n", argv[0]);
+        return 1;
+    }
+
+    url         = av_asprintf("%s_%%v.m3u8", argv[1]);
+    segment_url = av_asprintf("%s_%%v_%%d.m4s", argv[1]);
+    init_url    = av_asprintf("%s_init_%%v.mp4", av_basename(argv[1]));
+    dir         = av_strdup(argv[1]);
+    pkt         = av_packet_alloc();
+    if (!url || !segment_url || !init_url || !dir || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    ret = avformat_alloc_output_context2(&ctx, NULL, "hls", url);
+    if (ret < 0)
+        goto end;
+    ctx->flags |= AVFMT_FLAG_BITEXACT;
+
+    default_io_open   = ctx->io_open;
+    default_io_close2 = ctx->io_close2;
+    ctx->io_open      = io_open;
+    ctx->io_close2    = io_close2;
+
+    for (int i = 0; i < NB_VARIANTS; i++) {
+        AVStream *st = avformat_new_stream(ctx, NULL);
+        if (!st) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        st->codecpar->codec_type  = AVMEDIA_TYPE_AUDIO;
+        st->codecpar->codec_id    = AV_CODEC_ID_MP2;
+        st->codecpar->sample_rate = SAMPLE_RATE;
+        st->codecpar->frame_size  = FRAME_SIZE;
+        st->codecpar->bit_rate    = 64000;
+        st->codecpar->ch_layout   = (AVChannelLayout)AV_CHANNEL_LAYOUT_MONO;
+        st->time_base             = (AVRational){ 1, SAMPLE_RATE };
+    }
+
+    av_dict_set(&opts, "var_stream_map", "a:0 a:1", 0);
+    av_dict_set(&opts, "hls_segment_type", "fmp4", 0);
+    av_dict_set(&opts, "hls_fmp4_init_filename", init_url, 0);
+    av_dict_set(&opts, "hls_segment_filename", segment_url, 0);
+    av_dict_set(&opts, "hls_time", "1", 0);
+    av_dict_set(&opts, "hls_part_time", "0.25", 0);
+    av_dict_set(&opts, "hls_list_size", "5", 0);
+    av_dict_set(&opts, "hls_flags", "delete_segments", 0);
+    ret = avformat_write_header(ctx, &opts);
+    if (ret < 0)
+        goto end;
+
+    for (int i = 0; i < NB_FRAMES; i++) {
+        for (int j = 0; j < NB_VARIANTS; j++) {
+            memset(frame, i * NB_VARIANTS + j, sizeof(frame));
+            ret = av_new_packet(pkt, sizeof(frame));
+            if (ret < 0)
+                goto end;
+            memcpy(pkt->data, frame, sizeof(frame));
+            pkt->stream_index = j;
+            pkt->pts          = pkt->dts = (int64_t)i * FRAME_SIZE;
+            pkt->duration     = FRAME_SIZE;
+            pkt->flags       |= AV_PKT_FLAG_KEY;
+            ret = av_interleaved_write_frame(ctx, pkt);
+            if (ret < 0)
+                goto end;
+        }
+    }
+    ret = av_write_trailer(ctx);
+    if (ret < 0)
+        goto end;
+    dirname = av_dirname(dir);
+
+    for (int i = 0; i < NB_VARIANTS; i++)
+        printf("last live playlist of variant %d:\n%s\n", i,
+               live_playlists[i] ? live_playlists[i] : "(none)\n");
+
+    for (int i = 0; i < nb_segments; i++) {
+        const Segment *seg = &segments[i];
+        char *path = av_asprintf("%s/%s", dirname, seg->name);
+        int nb_parts_left = 0;
+
+        if (!path) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        for (int j = 0; j < seg->nb_parts; j++) {
+            char *part = av_asprintf("%.*s.part%d.m4s",
+                                     (int)(strlen(path) - strlen(".m4s")), path, j);
+            if (!part) {
+                av_free(path);
+                ret = AVERROR(ENOMEM);
+                goto end;
+            }
+            nb_parts_left += !access(part, F_OK);
+            av_free(part);
+        }
+        printf("%s: %d parts, %s, %s, %d part files left\n", seg->name,
+               seg->nb_parts, seg->parts_match ? "concatenated parts" : "parts mismatch",
+               access(path, F_OK) ? "deleted" : "kept", nb_parts_left);
+        av_free(path);
+    }
+
+end:
+    if (ret < 0)
+        fprintf(stderr, "error: %s\n", av_err2str(ret));
+    avformat_free_context(ctx);
+    av_dict_free(&opts);
+    av_packet_free(&pkt);
+    av_free(url);
+    av_free(segment_url);
+    av_free(init_url);
+    av_free(dir);
+    for (int i = 0; i < nb_files; i++) {
+        av_free(files[i].name);
+        av_free(files[i].data);
+    }
+    av_free(files);
+    for (int i = 0; i < nb_segments; i++)
+        av_free(segments[i].name);
+    av_free(segments);
+    for (int i = 0; i < NB_VARIANTS; i++)
+        av_free(live_playlists[i]);
+
+    return ret < 0;
+}
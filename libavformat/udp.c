@@ -26,6 +26,7 @@
 
 #define _DEFAULT_SOURCE
 #define _BSD_SOURCE     /* Needed for using struct ip_mreq with recent glibc */
+#define _GNU_SOURCE     /* Needed for recvmmsg() and sendmmsg() with glibc */
 
 #include "avformat.h"
 #include "libavutil/avassert.h"
@@ -45,6 +46,13 @@
 #include "TargetConditionals.h"
 #endif
 
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+#include <netinet/udp.h>
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP IPPROTO_UDP
+#endif
+
 #if HAVE_UDPLITE_H
 #include "udplite.h"
 #else
@@ -77,6 +85,16 @@
 #define UDP_RX_BUF_SIZE 393216
 #define UDP_MAX_PKT_SIZE 65536
 #define UDP_HEADER_SIZE 8
+#define UDP_RX_BATCH 32
+/* UDP_SEGMENT limits, payload of a single send and number of segments */
+#define UDP_GSO_MAX_SIZE 65000
+#define UDP_GSO_MAX_SEGS 64
+
+typedef struct UDPDatagram {
+    struct sockaddr_storage addr;
+    int len;
+    int seg_size;           ///< size of the coalesced segments with GRO
+} UDPDatagram;
 
 typedef struct UDPContext {
     const AVClass *class;
@@ -107,7 +125,6 @@ typedef struct UDPContext {
     pthread_cond_t cond;
     int thread_started;
 #endif
-    uint8_t tmp[UDP_MAX_PKT_SIZE+4];
     int remaining_in_dg;
     char *localaddr;
     int timeout;
@@ -115,6 +132,25 @@ typedef struct UDPContext {
     char *sources;
     char *block;
     IPSourceFilters filters;
+
+    int batch;
+    int gro;
+    int gso;
+    /* datagrams received by the last udp_recv_batch() call */
+    uint8_t *rx_buf;
+    int rx_slot;            ///< size of the buffer of each datagram in rx_buf
+    int rx_grow;            ///< a datagram did not fit, grow rx_slot
+    UDPDatagram *rx;
+    int rx_count, rx_index, rx_offset;
+    /* datagrams queued for udp_send_batch() */
+    uint8_t *tx_buf;
+    int *tx_len;
+    int tx_count, tx_sent;
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+    struct mmsghdr *msgs;
+    struct iovec *iov;
+    uint8_t *cmsg;
+#endif
 } UDPContext;
 
 #define OFFSET(x) offsetof(UDPContext, x)
@@ -139,6 +175,9 @@ static const AVOption options[] = {
     { "timeout",        "set raise error timeout, in microseconds (only in read mode)",OFFSET(timeout),         AV_OPT_TYPE_INT,  {.i64 = 0}, 0, INT_MAX, D },
     { "sources",        "Source list",                                     OFFSET(sources),        AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
     { "block",          "Block list",                                      OFFSET(block),          AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
+    { "batch",          "Number of datagrams received or sent per system call (-1 = auto)", OFFSET(batch), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, 1024,  D|E },
+    { "gro",            "Let the kernel coalesce received datagrams (UDP_GRO)", OFFSET(gro),       AV_OPT_TYPE_BOOL,   { .i64 = 0 },      0, 1,       D },
+    { "gso",            "Let the kernel segment batches of equally sized datagrams (UDP_SEGMENT)", OFFSET(gso), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { NULL }
 };
 
@@ -478,6 +517,240 @@ static int udp_get_file_handle(URLContext *h)
     return s->udp_fd;
 }
 
+#define CMSG_SLOT CMSG_SPACE(sizeof(int))
+
+static int udp_alloc_batch(UDPContext *s, int is_output)
+{
+    if (is_output) {
+        s->tx_buf = av_malloc_array(s->batch, UDP_MAX_PKT_SIZE);
+        s->tx_len = av_calloc(s->batch, sizeof(*s->tx_len));
+        if (!s->tx_buf || !s->tx_len)
+            return AVERROR(ENOMEM);
+    } else {
+        /* Batches of full size buffers would take 2 MiB per reader, so only
+         * reserve pkt_size bytes per datagram unless GRO coalesces them. */
+        s->rx_slot = s->gro || s->batch == 1 || s->pkt_size <= 0 ?
+                     UDP_MAX_PKT_SIZE : FFMIN(s->pkt_size, UDP_MAX_PKT_SIZE);
+        s->rx_buf = av_malloc_array(s->batch, s->rx_slot);
+        s->rx     = av_calloc(s->batch, sizeof(*s->rx));
+        if (!s->rx_buf || !s->rx)
+            return AVERROR(ENOMEM);
+    }
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+    s->msgs = av_calloc(s->batch, sizeof(*s->msgs));
+    s->iov  = av_calloc(s->batch, sizeof(*s->iov));
+    s->cmsg = av_calloc(s->batch, CMSG_SLOT);
+    if (!s->msgs || !s->iov || !s->cmsg)
+        return AVERROR(ENOMEM);
+#endif
+    return 0;
+}
+
+static void udp_free_batch(UDPContext *s)
+{
+    av_freep(&s->rx_buf);
+    av_freep(&s->rx);
+    av_freep(&s->tx_buf);
+    av_freep(&s->tx_len);
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+    av_freep(&s->msgs);
+    av_freep(&s->iov);
+    av_freep(&s->cmsg);
+#endif
+}
+
+/**
+ * Receive up to batch datagrams, blocking until at least one is available
+ * unless the socket is non-blocking.
+ *
+ * @return number of datagrams received or a negative AVERROR code
+ */
+static int udp_recv_batch(UDPContext *s)
+{
+    int n;
+#if HAVE_RECVMMSG
+    if (s->rx_grow) {
+        void *buf = av_realloc_array(s->rx_buf, s->batch, UDP_MAX_PKT_SIZE);
+        if (!buf)
+            return AVERROR(ENOMEM);
+        s->rx_buf  = buf;
+        s->rx_slot = UDP_MAX_PKT_SIZE;
+        s->rx_grow = 0;
+    }
+    for (int i = 0; i < s->batch; i++) {
+        struct msghdr *m = &s->msgs[i].msg_hdr;
+
+        s->iov[i].iov_base = s->rx_buf + (size_t)i * s->rx_slot;
+        s->iov[i].iov_len  = s->rx_slot;
+        m->msg_name        = &s->rx[i].addr;
+        m->msg_namelen     = sizeof(s->rx[i].addr);
+        m->msg_iov         = &s->iov[i];
+        m->msg_iovlen      = 1;
+        m->msg_control     = s->gro ? s->cmsg + i * CMSG_SLOT : NULL;
+        m->msg_controllen  = s->gro ? CMSG_SLOT : 0;
+        m->msg_flags       = 0;
+    }
+    n = recvmmsg(s->udp_fd, s->msgs, s->batch, MSG_WAITFORONE, NULL);
+    if (n < 0)
+        return ff_neterrno();
+    for (int i = 0; i < n; i++) {
+        UDPDatagram *d = &s->rx[i];
+
+        d->len      = s->msgs[i].msg_len;
+        d->seg_size = d->len;
+        if (s->msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            av_log(s, AV_LOG_WARNING, "Dropping a datagram larger than pkt_size (%d), "
+                   "using larger buffers from now on\n", s->rx_slot);
+            d->len     = -1;
+            s->rx_grow = 1;
+            continue;
+        }
+#ifdef UDP_GRO
+        if (s->gro) {
+            struct msghdr *m = &s->msgs[i].msg_hdr;
+            for (struct cmsghdr *c = CMSG_FIRSTHDR(m); c; c = CMSG_NXTHDR(m, c))
+                if (c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO)
+                    memcpy(&d->seg_size, CMSG_DATA(c), sizeof(d->seg_size));
+        }
+#endif
+    }
+#else
+    socklen_t addr_len = sizeof(s->rx[0].addr);
+
+    n = recvfrom(s->udp_fd, s->rx_buf, UDP_MAX_PKT_SIZE, 0,
+                 (struct sockaddr *)&s->rx[0].addr, &addr_len);
+    if (n < 0)
+        return ff_neterrno();
+    s->rx[0].len = s->rx[0].seg_size = n;
+    n = 1;
+#endif
+    s->rx_count  = n;
+    s->rx_index  = 0;
+    s->rx_offset = 0;
+    return n;
+}
+
+/**
+ * Return the next datagram of the last received batch that passes the source
+ * filters, splitting datagrams coalesced by GRO into their segments.
+ *
+ * @return size of the datagram or AVERROR(EAGAIN) if the batch is exhausted
+ */
+static int udp_next_datagram(UDPContext *s, const uint8_t **data)
+{
+    while (s->rx_index < s->rx_count) {
+        UDPDatagram *d = &s->rx[s->rx_index];
+        int len;
+
+        if (d->len < 0 ||
+            (!s->rx_offset && ff_ip_check_source_lists(&d->addr, &s->filters))) {
+            s->rx_index++;
+            continue;
+        }
+        len = d->len - s->rx_offset;
+        if (d->seg_size > 0)
+            len = FFMIN(len, d->seg_size);
+        *data = s->rx_buf + (size_t)s->rx_index * s->rx_slot + s->rx_offset;
+        s->rx_offset += len;
+        if (s->rx_offset >= d->len) {
+            s->rx_index++;
+            s->rx_offset = 0;
+        }
+        return len;
+    }
+    return AVERROR(EAGAIN);
+}
+
+/**
+ * Send count queued datagrams starting at first.
+ *
+ * @return number of datagrams sent or a negative AVERROR code
+ */
+static int udp_send_batch(UDPContext *s, int first, int count)
+{
+    struct sockaddr *dest = s->is_connected ? NULL : (struct sockaddr *)&s->dest_addr;
+    socklen_t dest_len    = s->is_connected ? 0 : s->dest_addr_len;
+    const uint8_t *buf    = s->tx_buf + (size_t)first * UDP_MAX_PKT_SIZE;
+    const int *len        = s->tx_len + first;
+    int ret;
+
+#if HAVE_SENDMMSG
+#ifdef UDP_SEGMENT
+    if (s->gso && count > 1) {
+        /* all segments but the last one must have the same size */
+        int n = 1, total = len[0];
+        while (n < count && n < UDP_GSO_MAX_SEGS && len[n - 1] == len[0] &&
+               len[n] <= len[0] && total + len[n] <= UDP_GSO_MAX_SIZE)
+            total += len[n++];
+        if (n > 1) {
+            struct msghdr m = { 0 };
+            struct cmsghdr *c;
+            uint16_t seg_size = len[0];
+
+            for (int i = 0; i < n; i++) {
+                s->iov[i].iov_base = (uint8_t *)buf + (size_t)i * UDP_MAX_PKT_SIZE;
+                s->iov[i].iov_len  = len[i];
+            }
+            m.msg_name       = dest;
+            m.msg_namelen    = dest_len;
+            m.msg_iov        = s->iov;
+            m.msg_iovlen     = n;
+            m.msg_control    = s->cmsg;
+            m.msg_controllen = CMSG_SPACE(sizeof(seg_size));
+            c = CMSG_FIRSTHDR(&m);
+            c->cmsg_level = SOL_UDP;
+            c->cmsg_type  = UDP_SEGMENT;
+            c->cmsg_len   = CMSG_LEN(sizeof(seg_size));
+            memcpy(CMSG_DATA(c), &seg_size, sizeof(seg_size));
+            ret = sendmsg(s->udp_fd, &m, 0);
+            return ret < 0 ? ff_neterrno() : n;
+        }
+    }
+#endif
+    for (int i = 0; i < count; i++) {
+        s->iov[i].iov_base = (uint8_t *)buf + (size_t)i * UDP_MAX_PKT_SIZE;
+        s->iov[i].iov_len  = len[i];
+        s->msgs[i].msg_hdr = (struct msghdr) {
+            .msg_name    = dest,
+            .msg_namelen = dest_len,
+            .msg_iov     = &s->iov[i],
+            .msg_iovlen  = 1,
+        };
+    }
+    ret = sendmmsg(s->udp_fd, s->msgs, count, 0);
+#else
+    if (dest)
+        ret = sendto(s->udp_fd, buf, len[0], 0, dest, dest_len);
+    else
+        ret = send(s->udp_fd, buf, len[0], 0);
+    if (ret >= 0)
+        ret = 1;
+#endif
+    return ret < 0 ? ff_neterrno() : ret;
+}
+
+static int udp_flush_tx(URLContext *h)
+{
+    UDPContext *s = h->priv_data;
+
+    while (s->tx_sent < s->tx_count) {
+        int ret;
+        if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
+            ret = ff_network_wait_fd(s->udp_fd, 1);
+            if (ret < 0)
+                return ret;
+        }
+        ret = udp_send_batch(s, s->tx_sent, s->tx_count - s->tx_sent);
+        if (ret == AVERROR(EINTR))
+            continue;
+        if (ret < 0)
+            return ret;
+        s->tx_sent += ret;
+    }
+    s->tx_count = s->tx_sent = 0;
+    return 0;
+}
+
 #if HAVE_PTHREAD_CANCEL
 static void *circular_buffer_task_rx( void *_URLContext)
 {
@@ -495,44 +768,45 @@ static void *circular_buffer_task_rx( void *_URLContext)
         goto end;
     }
     while(1) {
+        const uint8_t *data;
+        uint8_t tmp[4];
         int len;
-        struct sockaddr_storage addr;
-        socklen_t addr_len = sizeof(addr);
 
         pthread_mutex_unlock(&s->mutex);
         /* Blocking operations are always cancellation points;
            see "General Information" / "Thread Cancelation Overview"
            in Single Unix. */
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
-        len = recvfrom(s->udp_fd, s->tmp+4, sizeof(s->tmp)-4, 0, (struct sockaddr *)&addr, &addr_len);
+        len = udp_recv_batch(s);
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
         pthread_mutex_lock(&s->mutex);
         if (len < 0) {
-            if (ff_neterrno() != AVERROR(EAGAIN) && ff_neterrno() != AVERROR(EINTR)) {
-                s->circular_buffer_error = ff_neterrno();
+            if (len != AVERROR(EAGAIN) && len != AVERROR(EINTR)) {
+                s->circular_buffer_error = len;
                 goto end;
             }
             continue;
         }
-        if (ff_ip_check_source_lists(&addr, &s->filters))
-            continue;
-        AV_WL32(s->tmp, len);
-
-        if (av_fifo_can_write(s->fifo) < len + 4) {
-            /* No Space left */
-            if (s->overrun_nonfatal) {
-                av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
-                        "Surviving due to overrun_nonfatal option\n");
-                continue;
-            } else {
-                av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
-                        "To avoid, increase fifo_size URL option. "
-                        "To survive in such case, use overrun_nonfatal option\n");
-                s->circular_buffer_error = AVERROR(EIO);
-                goto end;
+
+        while ((len = udp_next_datagram(s, &data)) >= 0) {
+            if (av_fifo_can_write(s->fifo) < len + 4) {
+                /* No Space left */
+                if (s->overrun_nonfatal) {
+                    av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
+                            "Surviving due to overrun_nonfatal option\n");
+                    continue;
+                } else {
+                    av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
+                            "To avoid, increase fifo_size URL option. "
+                            "To survive in such case, use overrun_nonfatal option\n");
+                    s->circular_buffer_error = AVERROR(EIO);
+                    goto end;
+                }
             }
+            AV_WL32(tmp, len);
+            av_fifo_write(s->fifo, tmp, 4);
+            av_fifo_write(s->fifo, data, len);
         }
-        av_fifo_write(s->fifo, s->tmp, len + 4);
         pthread_cond_signal(&s->cond);
     }
 
@@ -563,8 +837,7 @@ static void *circular_buffer_task_tx( void *_URLContext)
     }
 
     for(;;) {
-        int len;
-        const uint8_t *p;
+        int len, count = 1;
         uint8_t tmp[4];
         int64_t timestamp;
 
@@ -581,9 +854,10 @@ static void *circular_buffer_task_tx( void *_URLContext)
         len = AV_RL32(tmp);
 
         av_assert0(len >= 0);
-        av_assert0(len <= sizeof(s->tmp));
+        av_assert0(len <= UDP_MAX_PKT_SIZE);
 
-        av_fifo_read(s->fifo, s->tmp, len);
+        av_fifo_read(s->fifo, s->tx_buf, len);
+        s->tx_len[0] = len;
 
         pthread_mutex_unlock(&s->mutex);
 
@@ -607,27 +881,32 @@ static void *circular_buffer_task_tx( void *_URLContext)
             target_timestamp = start_timestamp + sent_bits * 1000000 / s->bitrate;
         }
 
-        p = s->tmp;
-        while (len) {
-            int ret;
-            av_assert0(len > 0);
-            if (!s->is_connected) {
-                ret = sendto (s->udp_fd, p, len, 0,
-                            (struct sockaddr *) &s->dest_addr,
-                            s->dest_addr_len);
-            } else
-                ret = send(s->udp_fd, p, len, 0);
+        if (s->batch > 1) {
+            /* send the following datagrams along if they are already due */
+            pthread_mutex_lock(&s->mutex);
+            while (count < s->batch && av_fifo_can_read(s->fifo) >= 4 &&
+                   av_gettime_relative() >= target_timestamp) {
+                av_fifo_read(s->fifo, tmp, 4);
+                len = AV_RL32(tmp);
+                av_assert0(len >= 0);
+                av_assert0(len <= UDP_MAX_PKT_SIZE);
+                av_fifo_read(s->fifo, s->tx_buf + (size_t)count * UDP_MAX_PKT_SIZE, len);
+                s->tx_len[count++] = len;
+                sent_bits += len * 8;
+                target_timestamp = start_timestamp + sent_bits * 1000000 / s->bitrate;
+            }
+            pthread_mutex_unlock(&s->mutex);
+        }
+
+        for (int sent = 0; sent < count;) {
+            int ret = udp_send_batch(s, sent, count - sent);
             if (ret >= 0) {
-                len -= ret;
-                p   += ret;
-            } else {
-                ret = ff_neterrno();
-                if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR)) {
-                    pthread_mutex_lock(&s->mutex);
-                    s->circular_buffer_error = ret;
-                    pthread_mutex_unlock(&s->mutex);
-                    return NULL;
-                }
+                sent += ret;
+            } else if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR)) {
+                pthread_mutex_lock(&s->mutex);
+                s->circular_buffer_error = ret;
+                pthread_mutex_unlock(&s->mutex);
+                return NULL;
             }
         }
 
@@ -755,6 +1034,12 @@ static int udp_open(URLContext *h, const char *uri, int flags)
             s->timeout = strtol(buf, NULL, 10);
         if (is_output && av_find_info_tag(buf, sizeof(buf), "broadcast", p))
             s->is_broadcast = strtol(buf, NULL, 10);
+        if (av_find_info_tag(buf, sizeof(buf), "batch", p))
+            s->batch = av_clip(strtol(buf, NULL, 10), 1, 1024);
+        if (!is_output && av_find_info_tag(buf, sizeof(buf), "gro", p))
+            s->gro = strtol(buf, NULL, 10);
+        if (is_output && av_find_info_tag(buf, sizeof(buf), "gso", p))
+            s->gso = strtol(buf, NULL, 10);
     }
     /* handling needed to support options picking from both AVOption and URL */
     s->circular_buffer_size *= 188;
@@ -919,6 +1204,41 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         }
     }
 
+    if (s->batch < 0)
+        s->batch = is_output ? 1 : UDP_RX_BATCH;
+    if (!HAVE_RECVMMSG && !is_output)
+        s->batch = 1;
+
+    if (s->gro && !is_output) {
+#if HAVE_RECVMMSG && defined(UDP_GRO)
+        tmp = 1;
+        if (setsockopt(udp_fd, SOL_UDP, UDP_GRO, &tmp, sizeof(tmp)) < 0) {
+            ff_log_net_error(h, AV_LOG_WARNING, "setsockopt(UDP_GRO)");
+            s->gro = 0;
+        }
+#else
+        av_log(h, AV_LOG_WARNING, "UDP_GRO is not supported on this build\n");
+        s->gro = 0;
+#endif
+    }
+    if (s->gso && is_output) {
+#if HAVE_SENDMMSG && defined(UDP_SEGMENT)
+        len = sizeof(tmp);
+        if (getsockopt(udp_fd, SOL_UDP, UDP_SEGMENT, &tmp, &len) < 0) {
+            ff_log_net_error(h, AV_LOG_WARNING, "getsockopt(UDP_SEGMENT)");
+            s->gso = 0;
+        }
+#else
+        av_log(h, AV_LOG_WARNING, "UDP_SEGMENT is not supported on this build\n");
+        s->gso = 0;
+#endif
+    }
+
+    if (!is_output || s->batch > 1 || (s->bitrate && s->circular_buffer_size)) {
+        if ((ret = udp_alloc_batch(s, is_output)) < 0)
+            goto fail;
+    }
+
     s->udp_fd = udp_fd;
 
 #if HAVE_PTHREAD_CANCEL
@@ -973,6 +1293,7 @@ static int udp_open(URLContext *h, const char *uri, int flags)
     if (udp_fd >= 0)
         closesocket(udp_fd);
     av_fifo_freep2(&s->fifo);
+    udp_free_batch(s);
     ff_ip_reset_filters(&s->filters);
     return ret;
 }
@@ -990,9 +1311,8 @@ static int udplite_open(URLContext *h, const char *uri, int flags)
 static int udp_read(URLContext *h, uint8_t *buf, int size)
 {
     UDPContext *s = h->priv_data;
+    const uint8_t *data;
     int ret;
-    struct sockaddr_storage addr;
-    socklen_t addr_len = sizeof(addr);
 #if HAVE_PTHREAD_CANCEL
     int avail, nonblock = h->flags & AVIO_FLAG_NONBLOCK;
 
@@ -1038,16 +1358,21 @@ static int udp_read(URLContext *h, uint8_t *buf, int size)
     }
 #endif
 
-    if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
-        ret = ff_network_wait_fd(s->udp_fd, 0);
+    if (s->rx_index >= s->rx_count) {
+        if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
+            ret = ff_network_wait_fd(s->udp_fd, 0);
+            if (ret < 0)
+                return ret;
+        }
+        ret = udp_recv_batch(s);
         if (ret < 0)
             return ret;
     }
-    ret = recvfrom(s->udp_fd, buf, size, 0, (struct sockaddr *)&addr, &addr_len);
+    ret = udp_next_datagram(s, &data);
     if (ret < 0)
-        return ff_neterrno();
-    if (ff_ip_check_source_lists(&addr, &s->filters))
         return AVERROR(EINTR);
+    ret = FFMIN(ret, size);
+    memcpy(buf, data, ret);
     return ret;
 }
 
@@ -1072,6 +1397,10 @@ static int udp_write(URLContext *h, const uint8_t *buf, int size)
             return err;
         }
 
+        if (size > UDP_MAX_PKT_SIZE) {
+            pthread_mutex_unlock(&s->mutex);
+            return AVERROR(EMSGSIZE);
+        }
         if (av_fifo_can_write(s->fifo) < size + 4) {
             /* What about a partial packet tx ? */
             pthread_mutex_unlock(&s->mutex);
@@ -1085,6 +1414,20 @@ static int udp_write(URLContext *h, const uint8_t *buf, int size)
         return size;
     }
 #endif
+    if (s->batch > 1) {
+        if (size > UDP_MAX_PKT_SIZE)
+            return AVERROR(EMSGSIZE);
+        if (s->tx_count == s->batch && (ret = udp_flush_tx(h)) < 0)
+            return ret;
+        memcpy(s->tx_buf + (size_t)s->tx_count * UDP_MAX_PKT_SIZE, buf, size);
+        s->tx_len[s->tx_count++] = size;
+        /* the datagram is queued, so only report errors it can not be retried for */
+        if (s->tx_count == s->batch && (ret = udp_flush_tx(h)) < 0 &&
+            ret != AVERROR(EAGAIN))
+            return ret;
+        return size;
+    }
+
     if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
         ret = ff_network_wait_fd(s->udp_fd, 1);
         if (ret < 0)
@@ -1105,6 +1448,10 @@ static int udp_close(URLContext *h)
 {
     UDPContext *s = h->priv_data;
 
+    if (s->tx_count && udp_flush_tx(h) < 0)
+        av_log(h, AV_LOG_WARNING, "Could not send %d queued datagrams\n",
+               s->tx_count - s->tx_sent);
+
 #if HAVE_PTHREAD_CANCEL
     // Request close once writing is finished
     if (s->thread_started && !(h->flags & AVIO_FLAG_READ)) {
@@ -1142,6 +1489,7 @@ static int udp_close(URLContext *h)
 #endif
     closesocket(s->udp_fd);
     av_fifo_freep2(&s->fifo);
+    udp_free_batch(s);
     ff_ip_reset_filters(&s->filters);
     return 0;
 }
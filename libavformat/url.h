@@ -26,6 +26,7 @@
 
 #include "avio.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
 
@@ -83,6 +84,19 @@ typedef struct URLProtocol {
     int (*url_get_multi_file_handle)(URLContext *h, int **handles,
                                      int *numhandles);
     int (*url_get_short_seek)(URLContext *h);
+    /**
+     * Map size bytes of the resource starting at pos into a new buffer,
+     * followed by padding zeroed bytes. Return 0 on success, AVERROR(ENOSYS)
+     * if the range can not be mapped, or another negative AVERROR code.
+     */
+    int (*url_map_range)(URLContext *h, int64_t pos, int size, int padding,
+                         AVBufferRef **buf);
+    /**
+     * Insert at least size bytes at offset without moving the following
+     * data through memory. Return the number of bytes inserted, which may
+     * be rounded up to the granularity of the storage.
+     */
+    int64_t (*url_insert_space)(URLContext *h, int64_t offset, int64_t size);
     int (*url_shutdown)(URLContext *h, int flags);
     const AVClass *priv_data_class;
     int priv_data_size;
@@ -263,6 +277,27 @@ int ffurl_get_multi_file_handle(URLContext *h, int **handles, int *numhandles);
  */
 int ffurl_get_short_seek(void *urlcontext);
 
+/**
+ * Map a range of the resource into memory without copying it, if the
+ * protocol supports it.
+ *
+ * @param padding number of zeroed bytes following the data in *buf
+ * @param buf     set to a new reference of size + padding bytes on success
+ * @return 0 on success, AVERROR(ENOSYS) if the range can not be mapped,
+ *         or another negative AVERROR code
+ */
+int ffurl_map_range(URLContext *h, int64_t pos, int size, int padding,
+                    AVBufferRef **buf);
+
+/**
+ * Insert space into the resource in place, if the protocol supports it.
+ * The contents of the inserted range are unspecified.
+ *
+ * @return the number of bytes inserted (at least size), or a negative
+ *         AVERROR code; AVERROR(ENOSYS) if this is not supported
+ */
+int64_t ffurl_insert_space(URLContext *h, int64_t offset, int64_t size);
+
 /**
  * Signal the URLContext that we are done reading or writing the stream.
  *
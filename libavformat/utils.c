@@ -22,6 +22,7 @@
 #include <stdint.h>
 
 #include "config.h"
+#include "config_components.h"
 
 #include "libavutil/avstring.h"
 #include "libavutil/bprint.h"
@@ -33,6 +34,7 @@
 
 #include "avformat.h"
 #include "avio_internal.h"
+#include "http.h"
 #include "internal.h"
 #if CONFIG_NETWORK
 #include "network.h"
@@ -90,6 +92,8 @@ static int append_packet_chunked(AVIOContext *s, AVPacket *pkt, int size)
 
 int av_get_packet(AVIOContext *s, AVPacket *pkt, int size)
 {
+    int ret;
+
 #if FF_API_INIT_PACKET
 FF_DISABLE_DEPRECATION_WARNINGS
     av_init_packet(pkt);
@@ -101,6 +105,13 @@ FF_ENABLE_DEPRECATION_WARNINGS
 #endif
     pkt->pos  = avio_tell(s);
 
+    ret = ffio_read_mapped(s, size, AV_INPUT_BUFFER_PADDING_SIZE,
+                           &pkt->buf, &pkt->data);
+    if (ret > 0)
+        pkt->size = ret;
+    if (ret)
+        return ret;
+
     return append_packet_chunked(s, pkt, size);
 }
 
@@ -558,6 +569,10 @@ int avformat_network_init(void)
 int avformat_network_deinit(void)
 {
 #if CONFIG_NETWORK
+#if CONFIG_HTTP_PROTOCOL || CONFIG_HTTPS_PROTOCOL || CONFIG_HTTPPROXY_PROTOCOL
+    /* pooled connections may hold TLS sessions */
+    ff_http_pool_close();
+#endif
     ff_network_close();
     ff_tls_deinit();
 #endif
@@ -214,6 +214,7 @@ static const struct {
     #if CONFIG_RV40_DECODER
         { "rv40dsp", checkasm_check_rv40dsp },
     #endif
+        { "startcode", checkasm_check_startcode },
     #if CONFIG_SVQ1_ENCODER
         { "svq1enc", checkasm_check_svq1enc },
     #endif
@@ -20,6 +20,7 @@
 
 #include <string.h>
 #include "checkasm.h"
+#include "libavcodec/defs.h"
 #include "libavcodec/h264dsp.h"
 #include "libavcodec/h264data.h"
 #include "libavcodec/h264_parse.h"
@@ -449,6 +450,42 @@ static void check_loop_filter_intra(void)
     }
 }
 
+static void check_startcode_find_candidate(void)
+{
+#define STARTCODE_BUF_SIZE 4096
+    LOCAL_ALIGNED_32(uint8_t, buf, [STARTCODE_BUF_SIZE + AV_INPUT_BUFFER_PADDING_SIZE]);
+    H264DSPContext h;
+
+    declare_func(int, const uint8_t *buf, int size);
+
+    ff_h264dsp_init(&h, 8, 1);
+
+    if (check_func(h.startcode_find_candidate, "startcode_find_candidate")) {
+        for (int i = 0; i < 256; i++) {
+            int size   = rnd() % (STARTCODE_BUF_SIZE + 1);
+            int offset = rnd() % 32;
+            int res0, res1;
+
+            for (int j = 0; j < STARTCODE_BUF_SIZE; j++)
+                buf[j] = rnd() | 1;
+            memset(buf + STARTCODE_BUF_SIZE, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+            /* no zero at all, a zero at a random position, or a run of them */
+            if (i % 3 && size > offset) {
+                int pos = offset + rnd() % (size - offset);
+                memset(buf + pos, 0, FFMIN(i % 3, STARTCODE_BUF_SIZE - pos));
+            }
+            size -= offset;
+
+            res0 = call_ref(buf + offset, size);
+            res1 = call_new(buf + offset, size);
+            if (res0 != res1)
+                fail();
+        }
+        memset(buf, 0xff, STARTCODE_BUF_SIZE);
+        bench_new(buf, STARTCODE_BUF_SIZE);
+    }
+}
+
 void checkasm_check_h264dsp(void)
 {
     check_idct();
@@ -460,4 +497,7 @@ void checkasm_check_h264dsp(void)
 
     check_loop_filter_intra();
     report("loop_filter_intra");
+
+    check_startcode_find_candidate();
+    report("startcode");
 }
@@ -87,6 +87,48 @@ static void test_motion(const char *name, me_cmp_func test_func)
     }
 }
 
+/* test_motion() picks h at random, so the 16x16 block size of the
+ * 16 pixel wide functions is rarely hit; check both 16x8 and 16x16 here. */
+static void test_motion16(const char *name, me_cmp_func test_func)
+{
+    int x, y, d1, d2;
+    uint8_t *ptr;
+
+    LOCAL_ALIGNED_16(uint8_t, img1, [WIDTH * HEIGHT]);
+    LOCAL_ALIGNED_16(uint8_t, img2, [WIDTH * HEIGHT]);
+
+    declare_func_emms(AV_CPU_FLAG_MMX, int, struct MpegEncContext *c,
+                      const uint8_t *blk1, const uint8_t *blk2,
+                      ptrdiff_t stride, int h);
+
+    if (test_func == NULL) {
+        return;
+    }
+
+    fill_random(img1, WIDTH * HEIGHT);
+    fill_random(img2, WIDTH * HEIGHT);
+
+    if (check_func(test_func, "%s", name)) {
+        for (int i = 0; i < ITERATIONS; i++) {
+            for (int h = 8; h <= 16; h += 8) {
+                x = rnd() % (WIDTH - 16);
+                y = rnd() % (HEIGHT - 16);
+
+                ptr = img2 + y * WIDTH + x;
+                d2 = call_ref(NULL, img1, ptr, WIDTH, h);
+                d1 = call_new(NULL, img1, ptr, WIDTH, h);
+
+                if (d1 != d2) {
+                    fail();
+                    printf("func: %s, x=%d y=%d h=%d, error: asm=%d c=%d\n", name, x, y, h, d1, d2);
+                    return;
+                }
+            }
+        }
+        bench_new(NULL, img1, img2 + 3 * WIDTH + 3, WIDTH, 16);
+    }
+}
+
 #define ME_CMP_1D_ARRAYS(XX)                                                   \
     XX(sad)                                                                    \
     XX(sse)                                                                    \
@@ -132,6 +174,9 @@ static void check_motion(void)
     }
     ME_CMP_1D_ARRAYS(XX)
 #undef XX
+
+    test_motion16("sse16", me_ctx.sse[0]);
+    test_motion16("hadamard8_diff16", me_ctx.hadamard8_diff[0]);
 }
 
 void checkasm_check_motion(void)
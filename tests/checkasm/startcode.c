@@ -0,0 +1,68 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/mem_internal.h"
+
+#include "libavcodec/startcode.h"
+
+#include "checkasm.h"
+
+#define BUF_SIZE 4096
+
+static void check_find_candidate(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, buf, [BUF_SIZE + 64]);
+    StartCodeContext c;
+
+    declare_func(int, const uint8_t *buf, int size);
+
+    ff_startcode_init(&c);
+
+    if (check_func(c.find_candidate, "startcode_find_candidate")) {
+        for (int i = 0; i < 256; i++) {
+            int offset = rnd() % 32;
+            int size   = (rnd() % ((BUF_SIZE - offset) / 64 + 1)) * 64;
+            int res0, res1;
+
+            for (int j = 0; j < BUF_SIZE; j++)
+                buf[j] = rnd() | 1;
+            /* zeros right after the end must not be found */
+            memset(buf + offset + size, 0, BUF_SIZE + 64 - offset - size);
+            /* no zero at all, a zero at a random position, or a run of them */
+            if (i % 3 && size) {
+                int pos = offset + rnd() % size;
+                memset(buf + pos, 0, i % 3);
+            }
+
+            res0 = call_ref(buf + offset, size);
+            res1 = call_new(buf + offset, size);
+            if (res0 != res1)
+                fail();
+        }
+        memset(buf, 0xff, BUF_SIZE);
+        bench_new(buf, BUF_SIZE);
+    }
+}
+
+void checkasm_check_startcode(void)
+{
+    check_find_candidate();
+    report("find_candidate");
+}
@@ -264,6 +264,20 @@ fate-ffmpeg-loopback-decoding: CMD = transcode \
     "-map 0:v:0 -c:v mpeg2video -f null - -flags +bitexact -idct simple -threads $$threads -dec 0:0 -filter_complex '[0:v][dec:0]hstack[stack]' -map '[stack]' -c:v ffv1" ""
 FATE_FFMPEG-$(call ENCDEC2, MPEG2VIDEO, FFV1, NUT, HSTACK_FILTER PIPE_PROTOCOL FRAMECRC_MUXER) += fate-ffmpeg-loopback-decoding
 
+# Write a file through the iouring protocol with small blocks and periodic
+# syncs, with the muxer seeking back to finish it, and read it back with
+# and without io_uring.
+fate-ffmpeg-iouring: tests/data/vsynth1.yuv
+fate-ffmpeg-iouring: CMD = ffmpeg                                                                        \
+    -f rawvideo -s 352x288 -pix_fmt uyvy422 -i $(TARGET_PATH)/tests/data/vsynth1.yuv -frames:v 10       \
+    -c copy -bitexact -block_size 4096 -queue_depth 4 -fsync_interval 16384                             \
+    -y iouring:$(TARGET_PATH)/tests/data/fate/ffmpeg-iouring.mov &&                                     \
+    framecrc -block_size 4096 -queue_depth 4 -i iouring:$(TARGET_PATH)/tests/data/fate/ffmpeg-iouring.mov \
+    -c copy &&                                                                                           \
+    framecrc -io_uring 0 -i iouring:$(TARGET_PATH)/tests/data/fate/ffmpeg-iouring.mov -c copy
+FATE_FFMPEG-$(call ALLYES, IOURING_PROTOCOL RAWVIDEO_DEMUXER MOV_MUXER MOV_DEMUXER \
+                           FILE_PROTOCOL PIPE_PROTOCOL FRAMECRC_MUXER) += fate-ffmpeg-iouring
+
 # test matching by stream disposition
 fate-ffmpeg-spec-disposition: CMD = framecrc -i $(TARGET_SAMPLES)/mpegts/pmtchange.ts -map '0:disp:visual_impaired+descriptions:1' -c copy
 FATE_FFMPEG-$(call FRAMECRC, MPEGTS,,) += fate-ffmpeg-spec-disposition
@@ -52,6 +52,11 @@ FATE_HLSENC-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILT
 fate-hls-segment-size: tests/data/hls_segment_size.m3u8
 fate-hls-segment-size: CMD = framecrc -auto_conversion_filters -flags +bitexact -i $(TARGET_PATH)/tests/data/hls_segment_size.m3u8 -vf setpts=N*23
 
+FATE_HLSENC-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILTER ARESAMPLE_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += fate-hls-segment-size-prefetch
+fate-hls-segment-size-prefetch: tests/data/hls_segment_size.m3u8
+fate-hls-segment-size-prefetch: CMD = framecrc -auto_conversion_filters -flags +bitexact -prefetch_segments 3 -prefetch_split_size 65536 -i $(TARGET_PATH)/tests/data/hls_segment_size.m3u8 -vf setpts=N*23
+fate-hls-segment-size-prefetch: REF = $(SRC_PATH)/tests/ref/fate/hls-segment-size
+
 tests/data/hls_segment_single.m3u8: TAG = GEN
 tests/data/hls_segment_single.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
 	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
@@ -63,6 +68,11 @@ FATE_HLSENC-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILT
 fate-hls-segment-single: tests/data/hls_segment_single.m3u8
 fate-hls-segment-single: CMD = framecrc -auto_conversion_filters -flags +bitexact -i $(TARGET_PATH)/tests/data/hls_segment_single.m3u8 -vf setpts=N*23
 
+FATE_HLSENC-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILTER ARESAMPLE_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += fate-hls-segment-single-prefetch
+fate-hls-segment-single-prefetch: tests/data/hls_segment_single.m3u8
+fate-hls-segment-single-prefetch: CMD = framecrc -auto_conversion_filters -flags +bitexact -prefetch_segments 3 -prefetch_split_size 65536 -i $(TARGET_PATH)/tests/data/hls_segment_single.m3u8 -vf setpts=N*23
+fate-hls-segment-single-prefetch: REF = $(SRC_PATH)/tests/ref/fate/hls-segment-single
+
 tests/data/hls_init_time.m3u8: TAG = GEN
 tests/data/hls_init_time.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
 	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
@@ -97,6 +107,23 @@ FATE_HLSENC-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILT
 fate-hls-fmp4: tests/data/hls_fmp4.m3u8
 fate-hls-fmp4: CMD = framecrc -auto_conversion_filters -flags +bitexact -i $(TARGET_PATH)/tests/data/hls_fmp4.m3u8 -vf setpts=N*23
 
+tests/data/hls_fmp4_parts.m3u8: TAG = GEN
+tests/data/hls_fmp4_parts.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i "aevalsrc=cos(2*PI*t)*sin(2*PI*(440+4*t)*t):d=5" -map 0 -codec:a mp2fixed \
+	-hls_segment_type fmp4 -hls_fmp4_init_filename now_parts.mp4 -hls_list_size 0 \
+	-hls_time 2 -hls_part_time 0.5 -flags +bitexact -fflags +bitexact \
+	-hls_segment_filename "$(TARGET_PATH)/tests/data/hls_fmp4_parts_%d.m4s" \
+	$(TARGET_PATH)/tests/data/hls_fmp4_parts.m3u8 2>/dev/null
+
+FATE_HLSENC-$(call ALLYES, HLS_MUXER MOV_MUXER AEVALSRC_FILTER ARESAMPLE_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += fate-hls-fmp4-parts
+fate-hls-fmp4-parts: tests/data/hls_fmp4_parts.m3u8
+fate-hls-fmp4-parts: CMD = cat $(TARGET_PATH)/tests/data/hls_fmp4_parts.m3u8
+
+FATE_HLSENC_LIBAVFORMAT-$(call ALLYES, HLS_MUXER MOV_MUXER) += fate-hls-fmp4-parts-live
+fate-hls-fmp4-parts-live: libavformat/tests/hlsenc$(EXESUF) | tests/data
+fate-hls-fmp4-parts-live: CMD = run libavformat/tests/hlsenc$(EXESUF) $(TARGET_PATH)/tests/data/hls_fmp4_parts_live
+
 tests/data/hls_fmp4_ac3.m3u8: TAG = GEN
 tests/data/hls_fmp4_ac3.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
 	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
@@ -111,4 +138,5 @@ fate-hls-fmp4_ac3: CMD = probeaudiostream $(TARGET_PATH)/tests/data/now_ac3.mp4
 
 FATE_SAMPLES_FFMPEG += $(FATE_HLSENC-yes)
 FATE_SAMPLES_FFMPEG_FFPROBE += $(FATE_HLSENC_PROBE-yes)
-fate-hlsenc: $(FATE_HLSENC-yes) $(FATE_HLSENC_PROBE-yes)
+FATE_LIBAVFORMAT += $(FATE_HLSENC_LIBAVFORMAT-yes)
+fate-hlsenc: $(FATE_HLSENC-yes) $(FATE_HLSENC_PROBE-yes) $(FATE_HLSENC_LIBAVFORMAT-yes)
@@ -218,6 +218,40 @@ fate-mov-pcm-remux: CMD = md5 -i $(TARGET_PATH)/tests/data/asynth-44100-1.wav -m
 fate-mov-pcm-remux: CMP = oneline
 fate-mov-pcm-remux: REF = e76115bc392d702da38f523216bba165
 
+# Test demuxing a track with B-frames (ctts) and an edit list through the
+# compact sample table index, including a seek
+FATE_MOV_FFMPEG_FFPROBE-$(call TRANSCODE, MPEG4, MP4 MOV, RAWVIDEO_DEMUXER) += fate-mov-mp4-compact-index
+fate-mov-mp4-compact-index: tests/data/vsynth1.yuv
+fate-mov-mp4-compact-index: CMD = transcode rawvideo $(TARGET_PATH)/tests/data/vsynth1.yuv mp4 \
+  "-c:v mpeg4 -bf 2 -g 10 -frames:v 30" "-c copy" \
+  "-compact_index 1 -show_entries packet=pts,dts,duration,flags,pos" "" "-compact_index 1 -ss 0.5" \
+  "-s 352x288 -pix_fmt yuv420p"
+
+# Test faststart with the space for the moov atom reserved when writing the
+# header; the estimate from the input duration is limited by -t
+FATE_MOV_FFMPEG-$(call TRANSCODE, MPEG4, MOV, RAWVIDEO_DEMUXER) += fate-mov-faststart-reserve
+fate-mov-faststart-reserve: tests/data/vsynth1.yuv
+fate-mov-faststart-reserve: CMD = transcode rawvideo $(TARGET_PATH)/tests/data/vsynth1.yuv mov \
+  "-c:v mpeg4 -t 0.4 -movflags +faststart -faststart_reserve 1" "-c copy" "" "" "" \
+  "-s 352x288 -pix_fmt yuv420p"
+
+# Test faststart with the space for the moov atom inserted in place. Whether
+# this is possible depends on the file system, only the packets are checked.
+FATE_MOV_FFMPEG-$(call TRANSCODE, MPEG4, MOV, RAWVIDEO_DEMUXER) += fate-mov-faststart-insert
+fate-mov-faststart-insert: tests/data/vsynth1.yuv
+fate-mov-faststart-insert: CMD = ffmpeg -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv \
+  -c:v mpeg4 -frames:v 10 -bitexact -movflags +faststart -faststart_insert 1 -y $(TARGET_PATH)/tests/data/fate/mov-faststart-insert.mov ; \
+  framecrc -i $(TARGET_PATH)/tests/data/fate/mov-faststart-insert.mov -c copy
+
+# Test fragmented output with the samples written directly to the file and
+# space reserved for each moof; the reserve is small enough to cut fragments
+# early
+FATE_MOV_FFMPEG-$(call TRANSCODE, MPEG4, MP4 MOV, RAWVIDEO_DEMUXER) += fate-mov-mp4-frag-reserve
+fate-mov-mp4-frag-reserve: tests/data/vsynth1.yuv
+fate-mov-mp4-frag-reserve: CMD = transcode rawvideo $(TARGET_PATH)/tests/data/vsynth1.yuv mp4 \
+  "-c:v mpeg4 -g 10 -frames:v 20 -movflags +frag_keyframe+empty_moov+default_base_moof -frag_reserve 200" "-c copy" "" "" "" \
+  "-s 352x288 -pix_fmt yuv420p"
+
 FATE_MOV_FFMPEG-$(call TRANSCODE, RAWVIDEO, MOV, TESTSRC_FILTER SETPTS_FILTER) += fate-mov-vfr
 fate-mov-vfr: CMD = md5 -filter_complex testsrc=size=2x2:duration=1,setpts=N*N -c rawvideo -fflags +bitexact -f mov
 fate-mov-vfr: CMP = oneline
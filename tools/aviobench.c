@@ -0,0 +1,160 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Measure sequential write and read throughput of AVIO protocols, e.g.
+ *     tools/aviobench -s 1024 file:/mnt/test.bin iouring:/mnt/test.bin
+ * Each URL is written with the given amount of data and read back.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/error.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+#include "libavformat/avio.h"
+
+static int usage(const char *argv0, int ret)
+{
+    fprintf(stderr, "%s [-s size_in_MiB] [-b chunk_size] [-c] [-o <options>] url [url ...]\n", argv0);
+    fprintf(stderr, "-c: verify the data read back\n");
+    fprintf(stderr, "<options>: AVOptions expressed as key=value, :-separated\n");
+    return ret;
+}
+
+static void report(const char *url, const char *what, int64_t bytes, int64_t t)
+{
+    printf("%-40s %-5s %8.1f MiB/s (%"PRId64" bytes in %.3fs)\n", url, what,
+           bytes / (1024.0 * 1024.0) / FFMAX(t, 1) * 1000000.0, bytes, t / 1000000.0);
+}
+
+static int bench(const char *url, const AVDictionary *opts, const uint8_t *pattern,
+                 int chunk, int64_t size, int check)
+{
+    AVDictionary *o = NULL;
+    AVIOContext *io = NULL;
+    uint8_t *buf = NULL;
+    unsigned long sum_w = 1, sum_r = 1;
+    int64_t t, done;
+    int ret;
+
+    av_dict_copy(&o, opts, 0);
+    ret = avio_open2(&io, url, AVIO_FLAG_WRITE, NULL, &o);
+    av_dict_free(&o);
+    if (ret < 0)
+        goto fail;
+    t = av_gettime_relative();
+    for (done = 0; done < size; done += chunk) {
+        const uint8_t *src = pattern + done / chunk * 4099 % chunk;
+        int len = FFMIN(chunk, size - done);
+        avio_write(io, src, len);
+        if (check)
+            sum_w = av_adler32_update(sum_w, src, len);
+    }
+    ret = avio_closep(&io);
+    if (ret < 0)
+        goto fail;
+    report(url, "write", size, av_gettime_relative() - t);
+
+    buf = av_malloc(chunk);
+    if (!buf) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    av_dict_copy(&o, opts, 0);
+    ret = avio_open2(&io, url, AVIO_FLAG_READ, NULL, &o);
+    av_dict_free(&o);
+    if (ret < 0)
+        goto fail;
+    t = av_gettime_relative();
+    for (done = 0;; done += ret) {
+        ret = avio_read(io, buf, chunk);
+        if (ret <= 0)
+            break;
+        if (check)
+            sum_r = av_adler32_update(sum_r, buf, ret);
+    }
+    t = av_gettime_relative() - t;
+    if (ret < 0 && ret != AVERROR_EOF)
+        goto fail;
+    report(url, "read", done, t);
+
+    ret = 0;
+    if (done != size || sum_r != sum_w) {
+        fprintf(stderr, "%s: data read back does not match\n", url);
+        ret = AVERROR_INVALIDDATA;
+    }
+
+fail:
+    if (ret < 0)
+        fprintf(stderr, "%s: %s\n", url, av_err2str(ret));
+    avio_closep(&io);
+    av_free(buf);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    AVDictionary *opts = NULL;
+    uint8_t *pattern;
+    int64_t size = 256 << 20;
+    int chunk = 65536, check = 0, ret = 0, i;
+    AVLFG lfg;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            size = strtoll(argv[++i], NULL, 0) << 20;
+        } else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+            chunk = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-c")) {
+            check = 1;
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            if (av_dict_parse_string(&opts, argv[++i], "=", ":", 0) < 0) {
+                fprintf(stderr, "Cannot parse option string %s\n", argv[i]);
+                return usage(argv[0], 1);
+            }
+        } else {
+            return usage(argv[0], 1);
+        }
+    }
+    if (i == argc || size <= 0 || chunk <= 0)
+        return usage(argv[0], 1);
+
+    /* two chunks so that consecutive writes do not repeat the same data */
+    pattern = av_malloc(2 * (size_t)chunk);
+    if (!pattern)
+        return 1;
+    av_lfg_init(&lfg, 0xdeadbeef);
+    for (int j = 0; j < 2 * chunk; j++)
+        pattern[j] = av_lfg_get(&lfg);
+
+    for (; i < argc; i++)
+        if (bench(argv[i], opts, pattern, chunk, size, check) < 0)
+            ret = 1;
+
+    av_dict_free(&opts);
+    av_free(pattern);
+    return ret;
+}